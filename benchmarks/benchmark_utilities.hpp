@@ -0,0 +1,334 @@
+#ifndef BENCHMARK_UTILITIES_HPP
+#define BENCHMARK_UTILITIES_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Minimal self-contained benchmark harness used by the callback system
+/// benchmarks (so that they don't depend on any external library)
+///
+/// -- Each benchmark is a function taking a number of iterations, which the
+///    runner calls with an increasing number of iterations until a single
+///    run lasts at least the minimum benchmark time
+///
+/// -- Results are written as JSON, either to stdout or to the file given
+///    with the --out=<file> command line argument
+///
+/// -- Supported command line arguments:
+///
+///    --out=<file>            Write the JSON results to <file>
+///    --min-time=<seconds>    Minimum duration of each measured run
+///    --filter=<text>         Only run benchmarks whose name contains <text>
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Benchmark helpers are defined within the namespace BenchmarkLIB
+//-------------------------------------------------------------------
+namespace BenchmarkLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Function used to keep the compiler from optimizing away a value
+// computed by a benchmark
+//-------------------------------------------------------------------
+template<typename ValueType>
+
+inline void do_not_optimize(const ValueType& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static const volatile void* volatile sink;
+    sink = &value;
+#endif
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// The result of a single benchmark
+//-------------------------------------------------------------------
+struct BenchmarkResult
+{
+    // Name of the benchmark (for example "invoke/callbacks")
+
+    std::string                         m_name;
+
+
+
+    // The size parameter of the benchmark (usually
+    // the number of registered callbacks)
+
+    std::size_t                         m_size = 0;
+
+
+
+    // Number of iterations of the measured run
+
+    std::size_t                         m_iterations = 0;
+
+
+
+    // Average time of one iteration
+
+    double                              m_nanosecondsPerIteration = 0;
+
+
+
+    // Average time per item (iteration time divided
+    // by the number of items processed per iteration,
+    // for example the number of invoked callbacks)
+
+    double                              m_nanosecondsPerItem = 0;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Class used to run the benchmarks and collect their results
+//-------------------------------------------------------------------
+class BenchmarkRunner
+{
+public: // Constructors and destructor
+
+
+
+    // Constructor parsing the command line arguments
+
+    BenchmarkRunner(int argc, char** argv)
+    {
+        for(int i = 1; i < argc; ++i)
+        {
+            std::string argument(argv[i]);
+
+            if(argument.compare(0, 6, "--out=") == 0)
+                m_outputFileName = argument.substr(6);
+            else if(argument.compare(0, 11, "--min-time=") == 0)
+                m_minimumTimeInSeconds = std::atof(argument.substr(11).c_str());
+            else if(argument.compare(0, 9, "--filter=") == 0)
+                m_filter = argument.substr(9);
+            else
+                std::cerr << "Ignoring unknown argument: " << argument << std::endl;
+        }
+    }
+
+
+
+public: // Public functions
+
+
+
+    // Function used to run a benchmark
+    //
+    // The benchmark function is called with the number of
+    // iterations to run, and each iteration processes the
+    // specified number of items
+
+    template<typename BenchmarkFunction>
+
+    void run(const std::string& name,
+             std::size_t size,
+             std::size_t itemsPerIteration,
+             BenchmarkFunction&& benchmarkFunction)
+    {
+        if(!m_filter.empty() && name.find(m_filter) == std::string::npos)
+            return;
+
+        std::size_t iterations = 1;
+        double elapsedSeconds = 0;
+
+        while(true)
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            benchmarkFunction(iterations);
+
+            auto end = std::chrono::steady_clock::now();
+
+            elapsedSeconds = std::chrono::duration<double>(end - start).count();
+
+            if(elapsedSeconds >= m_minimumTimeInSeconds || iterations >= m_maximumIterations)
+                break;
+
+            // Aim a little past the minimum time so that
+            // the next run is most likely the last one
+
+            double scale = (elapsedSeconds > 0) ? (1.4 * m_minimumTimeInSeconds / elapsedSeconds) : 100.0;
+
+            if(scale > 100.0)
+                scale = 100.0;
+
+            std::size_t nextIterations = static_cast<std::size_t>(iterations * scale);
+
+            iterations = (nextIterations > iterations) ? nextIterations : iterations + 1;
+        }
+
+        BenchmarkResult result;
+
+        result.m_name = name;
+        result.m_size = size;
+        result.m_iterations = iterations;
+        result.m_nanosecondsPerIteration = elapsedSeconds * 1e9 / iterations;
+        result.m_nanosecondsPerItem = result.m_nanosecondsPerIteration / (itemsPerIteration ? itemsPerIteration : 1);
+
+        std::cerr << name << " [" << size << "]: "
+                  << result.m_nanosecondsPerIteration << " ns/iteration, "
+                  << result.m_nanosecondsPerItem << " ns/item" << std::endl;
+
+        m_results.push_back(result);
+    }
+
+
+
+    // Function used to write the results as JSON
+
+    void write_results()const
+    {
+        std::ostringstream json;
+
+        json << "{\n";
+        json << "  \"context\": {\n";
+        json << "    \"min_time_seconds\": " << m_minimumTimeInSeconds << ",\n";
+        json << "    \"compiler\": \"" << compiler_name() << "\",\n";
+#ifdef NDEBUG
+        json << "    \"optimized\": true\n";
+#else
+        json << "    \"optimized\": false\n";
+#endif
+        json << "  },\n";
+        json << "  \"benchmarks\": [\n";
+
+        for(std::size_t i = 0; i < m_results.size(); ++i)
+        {
+            const BenchmarkResult& result = m_results[i];
+
+            json << "    {"
+                 << "\"name\": \"" << result.m_name << "\", "
+                 << "\"size\": " << result.m_size << ", "
+                 << "\"iterations\": " << result.m_iterations << ", "
+                 << "\"ns_per_iteration\": " << result.m_nanosecondsPerIteration << ", "
+                 << "\"ns_per_item\": " << result.m_nanosecondsPerItem
+                 << "}" << (i + 1 < m_results.size() ? "," : "") << "\n";
+        }
+
+        json << "  ]\n";
+        json << "}\n";
+
+        if(m_outputFileName.empty())
+        {
+            std::cout << json.str();
+        }
+        else
+        {
+            std::ofstream outputFile(m_outputFileName.c_str());
+            outputFile << json.str();
+        }
+    }
+
+
+
+    // Function used to get the collected results
+
+    const std::vector<BenchmarkResult>& results()const
+    {
+        return m_results;
+    }
+
+
+
+private: // Private functions
+
+
+
+    static const char* compiler_name()
+    {
+#if defined(__clang__)
+        return "clang " __clang_version__;
+#elif defined(__GNUC__)
+        return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc";
+#else
+        return "unknown";
+#endif
+    }
+
+
+
+private: // Private variables
+
+
+
+    // Where the results are written (stdout if empty)
+
+    std::string                         m_outputFileName;
+
+
+
+    // Only benchmarks containing this text are run
+
+    std::string                         m_filter;
+
+
+
+    // Minimum duration of a measured run
+
+    double                              m_minimumTimeInSeconds = 0.2;
+
+
+
+    // Upper bound on the iterations of a run (so that
+    // benchmarks optimized away don't loop forever)
+
+    std::size_t                         m_maximumIterations = std::size_t(1) << 32;
+
+
+
+    // The collected results
+
+    std::vector<BenchmarkResult>        m_results;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of BenchmarkLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // BENCHMARK_UTILITIES_HPP
@@ -0,0 +1,996 @@
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Microbenchmarks of the callback system
+///
+/// -- invoke/*     Cost of invoking 1 to 1M registered callbacks with
+///                 Callbacks::operator() and the short-circuit invokers,
+///                 compared to a raw function pointer loop and to a plain
+///                 vector of std::function
+///
+///                 (and to the same callbacks with latency instrumentation
+///                 or with tracing compiled in but turned off)
+///
+/// -- churn/*      Cost of registering and de-registering callbacks, one
+///                 at a time or in bulk
+///
+/// -- arguments/*  Cost of invoking callbacks with arguments of different
+///                 copy cost, passed by value and by const reference, and
+///                 of an idle event point building its argument eagerly or
+///                 lazily
+///
+/// -- exceptions/* Overhead of each exception policy when no callback
+///                 throws, and cost of isolating a throwing callback
+///
+/// -- allocator/*  Registration throughput and invoke cost of callbacks
+///                 with out-of-line state, stored with std::function on the
+///                 global heap (scattered by unrelated allocations) or with
+///                 CallbackFunction in a std::pmr arena
+///
+/// -- small/*      Cost of registering and invoking 1 to 8 callbacks on
+///                 many callback systems, stored in a std::vector or inline
+///                 (SmallCallbacks with room for 4 callbacks)
+///
+/// -- storage/*    Cost of filling a fresh callback system, stored in a
+///                 growing std::vector, in a reserved std::vector or in
+///                 segments (SegmentedCallbacks)
+///
+/// -- reclamation/* Cost, on the calling thread, of registering callbacks
+///                 owning state that is slow to destroy and de-registering
+///                 them all, destroying them inline or deferring their
+///                 destruction to the background reclaimer
+///
+/// -- clone/*      Cost of cloning a callback system, whose callbacks are
+///                 copied right away (std::vector) or shared until one of
+///                 the copies modifies them (CopyOnWriteCallbacks)
+///
+/// -- lookup/*     Cost of finding the callback to de-register in a large
+///                 callback system, comparing the ID of each callback in
+///                 turn or searching the packed ID index (IndexedCallbacks)
+///
+/// Results are written as JSON (see benchmark_utilities.hpp)
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+#include "callbacks_instrumentation.hpp"
+#include "callbacks_tracing.hpp"
+#include "callbacks_exceptions.hpp"
+#include "callbacks_allocator.hpp"
+#include "callbacks_small.hpp"
+#include "callbacks_segmented.hpp"
+#include "callbacks_reclamation.hpp"
+#include "callbacks_copy_on_write.hpp"
+#include "callbacks_id_index.hpp"
+#include "benchmark_utilities.hpp"
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Helpers shared by the benchmarks
+//-------------------------------------------------------------------
+namespace
+{
+
+
+
+// Value updated by the benchmarked callbacks so
+// that their bodies can't be optimized away
+
+std::size_t g_sink = 0;
+
+
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noinline))
+#endif
+void rawCallback(int value)
+{
+    g_sink += static_cast<std::size_t>(value);
+}
+
+
+
+// Numbers of registered callbacks used
+// by the scaling benchmarks
+
+const std::vector<std::size_t> g_numbersOfSubscribers = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+
+
+// Numbers of callbacks used by the churn
+// benchmarks (de-registration is linear so
+// the largest sizes would be quadratic)
+
+const std::vector<std::size_t> g_churnSizes = {1, 10, 100, 1000, 10000};
+
+
+
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Benchmarks of the cost of invoking the callbacks
+//-------------------------------------------------------------------
+void benchmarkInvoke(BenchmarkLIB::BenchmarkRunner& runner)
+{
+    for(std::size_t numberOfSubscribers : g_numbersOfSubscribers)
+    {
+        // Baseline:  a raw function pointer loop
+
+        {
+            std::vector<void(*)(int)> functionPointers(numberOfSubscribers, &rawCallback);
+
+            runner.run("invoke/raw_function_pointers", numberOfSubscribers, numberOfSubscribers, [&](std::size_t iterations)
+            {
+                for(std::size_t i = 0; i < iterations; ++i)
+                {
+                    for(auto functionPointer : functionPointers)
+                        functionPointer(1);
+                }
+
+                BenchmarkLIB::do_not_optimize(g_sink);
+            });
+        }
+
+
+
+        // Baseline:  a plain vector of std::function
+
+        {
+            std::vector<std::function<void(int)>> functions(numberOfSubscribers, [](int value){ g_sink += value; });
+
+            runner.run("invoke/std_function_vector", numberOfSubscribers, numberOfSubscribers, [&](std::size_t iterations)
+            {
+                for(std::size_t i = 0; i < iterations; ++i)
+                {
+                    for(const auto& function : functions)
+                        function(1);
+                }
+
+                BenchmarkLIB::do_not_optimize(g_sink);
+            });
+        }
+
+
+
+        // Callbacks::operator()
+
+        {
+            CallbacksLIB::Callbacks<void,int> callbacks;
+
+            for(std::size_t i = 0; i < numberOfSubscribers; ++i)
+                callbacks.register_callback([](int value){ g_sink += value; });
+
+            runner.run("invoke/callbacks_operator", numberOfSubscribers, numberOfSubscribers, [&](std::size_t iterations)
+            {
+                for(std::size_t i = 0; i < iterations; ++i)
+                    callbacks(1);
+
+                BenchmarkLIB::do_not_optimize(g_sink);
+            });
+        }
+
+
+
+        // Callbacks::operator() with the latency instrumentation
+        // (each callback has its own ~9KB histogram, so the
+        // largest sizes are skipped)
+
+        if(numberOfSubscribers <= 10000)
+        {
+            CallbacksLIB::BasicCallbacks<CallbacksLIB::LatencyInstrumentedCallbacksPolicy,void,int> callbacks;
+
+            for(std::size_t i = 0; i < numberOfSubscribers; ++i)
+                callbacks.register_callback([](int value){ g_sink += value; });
+
+            runner.run("invoke/callbacks_latency_instrumented", numberOfSubscribers, numberOfSubscribers, [&](std::size_t iterations)
+            {
+                for(std::size_t i = 0; i < iterations; ++i)
+                    callbacks(1);
+
+                BenchmarkLIB::do_not_optimize(g_sink);
+            });
+        }
+
+
+
+        // Callbacks::operator() with tracing compiled in
+        // but turned off
+
+        {
+            CallbacksLIB::BasicCallbacks<CallbacksLIB::TracingCallbacksPolicy,void,int> callbacks;
+
+            for(std::size_t i = 0; i < numberOfSubscribers; ++i)
+                callbacks.register_callback([](int value){ g_sink += value; });
+
+            runner.run("invoke/callbacks_tracing_disabled", numberOfSubscribers, numberOfSubscribers, [&](std::size_t iterations)
+            {
+                for(std::size_t i = 0; i < iterations; ++i)
+                    callbacks(1);
+
+                BenchmarkLIB::do_not_optimize(g_sink);
+            });
+        }
+
+
+
+        // Short-circuit invoker returning a boolean
+        // (no callback succeeds, so all are invoked)
+
+        {
+            CallbacksLIB::CallbacksReturningABoolean<int> callbacks;
+
+            for(std::size_t i = 0; i < numberOfSubscribers; ++i)
+                callbacks.register_callback([](int value){ g_sink += value; return false; });
+
+            runner.run("invoke/callbacks_until_non_zero", numberOfSubscribers, numberOfSubscribers, [&](std::size_t iterations)
+            {
+                for(std::size_t i = 0; i < iterations; ++i)
+                    BenchmarkLIB::do_not_optimize(callbacks.invokeCallbacksUntilOneOfThemReturnsANonZeroValue(1));
+            });
+        }
+
+
+
+        // Short-circuit invoker returning a container
+        // (no callback succeeds, so all are invoked)
+
+        {
+            CallbacksLIB::CallbacksReturningAContainer<std::vector<int>,int> callbacks;
+
+            for(std::size_t i = 0; i < numberOfSubscribers; ++i)
+                callbacks.register_callback([](int value){ g_sink += value; return std::vector<int>(); });
+
+            runner.run("invoke/callbacks_until_non_empty", numberOfSubscribers, numberOfSubscribers, [&](std::size_t iterations)
+            {
+                for(std::size_t i = 0; i < iterations; ++i)
+                    BenchmarkLIB::do_not_optimize(callbacks.invokeCallbacksUntilOneOfThemReturnsANonEmptyContainer(1));
+            });
+        }
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Benchmarks of the cost of registering/de-registering callbacks
+//-------------------------------------------------------------------
+void benchmarkChurn(BenchmarkLIB::BenchmarkRunner& runner)
+{
+    for(std::size_t numberOfCallbacks : g_churnSizes)
+    {
+        std::vector<CallbacksLIB::CallbackID> callbackIDs(numberOfCallbacks);
+
+
+
+        // Register everything, then de-register
+        // starting from the newest callback
+
+        {
+            CallbacksLIB::Callbacks<void,int> callbacks;
+
+            runner.run("churn/register_deregister_newest_first", numberOfCallbacks, 2 * numberOfCallbacks, [&](std::size_t iterations)
+            {
+                for(std::size_t i = 0; i < iterations; ++i)
+                {
+                    for(std::size_t j = 0; j < numberOfCallbacks; ++j)
+                        callbackIDs[j] = callbacks.register_callback(&rawCallback);
+
+                    for(std::size_t j = numberOfCallbacks; j > 0; --j)
+                        callbacks.deregister_callback(callbackIDs[j - 1]);
+                }
+            });
+        }
+
+
+
+        // Register everything, then de-register
+        // starting from the oldest callback
+
+        {
+            CallbacksLIB::Callbacks<void,int> callbacks;
+
+            runner.run("churn/register_deregister_oldest_first", numberOfCallbacks, 2 * numberOfCallbacks, [&](std::size_t iterations)
+            {
+                for(std::size_t i = 0; i < iterations; ++i)
+                {
+                    for(std::size_t j = 0; j < numberOfCallbacks; ++j)
+                        callbackIDs[j] = callbacks.register_callback(&rawCallback);
+
+                    for(std::size_t j = 0; j < numberOfCallbacks; ++j)
+                        callbacks.deregister_callback(callbackIDs[j]);
+                }
+            });
+        }
+
+
+
+        // Register everything at once, then de-register
+        // everything at once
+
+        {
+            CallbacksLIB::Callbacks<void,int> callbacks;
+
+            std::vector<void(*)(int)> newCallbacks(numberOfCallbacks, &rawCallback);
+
+            runner.run("churn/register_deregister_bulk", numberOfCallbacks, 2 * numberOfCallbacks, [&](std::size_t iterations)
+            {
+                for(std::size_t i = 0; i < iterations; ++i)
+                {
+                    callbackIDs = callbacks.register_callbacks(newCallbacks);
+
+                    callbacks.deregister_callbacks(callbackIDs);
+                }
+            });
+        }
+
+
+
+        // Register with alternating priorities (so that
+        // half the registrations insert in the middle)
+
+        {
+            CallbacksLIB::Callbacks<void,int> callbacks;
+
+            runner.run("churn/register_with_priorities", numberOfCallbacks, numberOfCallbacks, [&](std::size_t iterations)
+            {
+                for(std::size_t i = 0; i < iterations; ++i)
+                {
+                    for(std::size_t j = 0; j < numberOfCallbacks; ++j)
+                        callbacks.register_callback(&rawCallback, static_cast<int>(j % 2));
+
+                    callbacks.deregister_all_callbacks();
+                }
+            });
+        }
+
+
+
+        // Connect through scoped connections and
+        // let them all disconnect
+
+        {
+            CallbacksLIB::Callbacks<void,int> callbacks;
+            std::vector<CallbacksLIB::ScopedConnection> connections(numberOfCallbacks);
+
+            runner.run("churn/connect_disconnect", numberOfCallbacks, 2 * numberOfCallbacks, [&](std::size_t iterations)
+            {
+                for(std::size_t i = 0; i < iterations; ++i)
+                {
+                    for(std::size_t j = 0; j < numberOfCallbacks; ++j)
+                        connections[j] = callbacks.connect(&rawCallback);
+
+                    for(std::size_t j = 0; j < numberOfCallbacks; ++j)
+                        connections[j].disconnect();
+
+                    callbacks.collect_expired_callbacks();
+                }
+            });
+        }
+
+
+
+        // Register one-shot callbacks and
+        // retire them all in one invocation
+
+        {
+            CallbacksLIB::Callbacks<void,int> callbacks;
+
+            runner.run("churn/one_shot_register_invoke", numberOfCallbacks, numberOfCallbacks, [&](std::size_t iterations)
+            {
+                for(std::size_t i = 0; i < iterations; ++i)
+                {
+                    for(std::size_t j = 0; j < numberOfCallbacks; ++j)
+                        callbacks.register_one_shot_callback(&rawCallback);
+
+                    callbacks(1);
+                }
+
+                BenchmarkLIB::do_not_optimize(g_sink);
+            });
+        }
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Benchmarks of the cost of passing arguments of different copy
+// cost to the callbacks
+//-------------------------------------------------------------------
+template<typename ArgumentType>
+
+void benchmarkArgument(BenchmarkLIB::BenchmarkRunner& runner,
+                       const std::string& name,
+                       const typename std::decay<ArgumentType>::type& argument)
+{
+    const std::size_t numberOfSubscribers = 16;
+
+    CallbacksLIB::Callbacks<void,ArgumentType> callbacks;
+
+    for(std::size_t i = 0; i < numberOfSubscribers; ++i)
+        callbacks.register_callback([](ArgumentType value){ g_sink += value.size(); });
+
+    runner.run("arguments/" + name, numberOfSubscribers, numberOfSubscribers, [&](std::size_t iterations)
+    {
+        for(std::size_t i = 0; i < iterations; ++i)
+            callbacks(argument);
+
+        BenchmarkLIB::do_not_optimize(g_sink);
+    });
+}
+
+
+
+void benchmarkArguments(BenchmarkLIB::BenchmarkRunner& runner)
+{
+    {
+        const std::size_t numberOfSubscribers = 16;
+
+        CallbacksLIB::Callbacks<void,int> callbacks;
+
+        for(std::size_t i = 0; i < numberOfSubscribers; ++i)
+            callbacks.register_callback([](int value){ g_sink += value; });
+
+        runner.run("arguments/int", numberOfSubscribers, numberOfSubscribers, [&](std::size_t iterations)
+        {
+            for(std::size_t i = 0; i < iterations; ++i)
+                callbacks(1);
+
+            BenchmarkLIB::do_not_optimize(g_sink);
+        });
+    }
+
+    const std::string smallString(8, 'x');
+    const std::string largeString(1024, 'x');
+    const std::vector<double> largeVector(1024, 1.0);
+
+    benchmarkArgument<std::string>(runner, "small_string_by_value", smallString);
+    benchmarkArgument<const std::string&>(runner, "small_string_by_const_reference", smallString);
+    benchmarkArgument<std::string>(runner, "large_string_by_value", largeString);
+    benchmarkArgument<const std::string&>(runner, "large_string_by_const_reference", largeString);
+    benchmarkArgument<std::vector<double>>(runner, "large_vector_by_value", largeVector);
+    benchmarkArgument<const std::vector<double>&>(runner, "large_vector_by_const_reference", largeVector);
+
+
+
+    // Idle event point (no callback registered) whose
+    // argument is expensive to build, built eagerly or
+    // only when somebody listens
+
+    {
+        CallbacksLIB::Callbacks<void,const std::string&> callbacks;
+
+        runner.run("arguments/idle_event_eager_argument", 0, 1, [&](std::size_t iterations)
+        {
+            for(std::size_t i = 0; i < iterations; ++i)
+                callbacks("event number " + std::to_string(i));
+        });
+
+        runner.run("arguments/idle_event_lazy_argument", 0, 1, [&](std::size_t iterations)
+        {
+            for(std::size_t i = 0; i < iterations; ++i)
+                callbacks.invokeCallbacksLazily([i]{ return std::make_tuple("event number " + std::to_string(i)); });
+        });
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Benchmarks of the overhead of the exception policies
+//-------------------------------------------------------------------
+template<typename CallbacksPolicy>
+
+void benchmarkExceptionPolicy(BenchmarkLIB::BenchmarkRunner& runner, const std::string& name)
+{
+    const std::size_t numberOfSubscribers = 16;
+
+    CallbacksLIB::BasicCallbacks<CallbacksPolicy,void,int> callbacks;
+
+    for(std::size_t i = 0; i < numberOfSubscribers; ++i)
+        callbacks.register_callback([](int value){ g_sink += value; });
+
+    runner.run("exceptions/" + name, numberOfSubscribers, numberOfSubscribers, [&](std::size_t iterations)
+    {
+        for(std::size_t i = 0; i < iterations; ++i)
+            callbacks(1);
+
+        BenchmarkLIB::do_not_optimize(g_sink);
+    });
+}
+
+
+
+void benchmarkExceptions(BenchmarkLIB::BenchmarkRunner& runner)
+{
+    // Overhead when no callback throws
+
+    benchmarkExceptionPolicy<CallbacksLIB::DefaultCallbacksPolicy>(runner, "propagate");
+    benchmarkExceptionPolicy<CallbacksLIB::IsolatingCallbacksPolicy>(runner, "isolate");
+    benchmarkExceptionPolicy<CallbacksLIB::CollectingCallbacksPolicy>(runner, "collect");
+    benchmarkExceptionPolicy<CallbacksLIB::NoexceptCallbacksPolicy>(runner, "noexcept");
+
+
+
+    // Cost of isolating a throwing callback
+    // (one out of the 16 callbacks throws)
+
+    {
+        const std::size_t numberOfSubscribers = 16;
+
+        CallbacksLIB::BasicCallbacks<CallbacksLIB::IsolatingCallbacksPolicy,void,int> callbacks;
+
+        for(std::size_t i = 0; i < numberOfSubscribers - 1; ++i)
+            callbacks.register_callback([](int value){ g_sink += value; });
+
+        callbacks.register_callback([](int){ throw std::runtime_error("callback failed"); });
+
+        runner.run("exceptions/isolate_one_throwing", numberOfSubscribers, numberOfSubscribers, [&](std::size_t iterations)
+        {
+            for(std::size_t i = 0; i < iterations; ++i)
+                callbacks(1);
+
+            BenchmarkLIB::do_not_optimize(g_sink);
+        });
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Benchmarks of the allocators of the callbacks
+//-------------------------------------------------------------------
+
+// Callable whose state doesn't fit inline (neither in
+// std::function nor in CallbackFunction)
+
+struct LargeCallable
+{
+    std::array<std::size_t,8>           m_state;
+
+    void operator()(int value)const
+    {
+        g_sink += m_state[0] + static_cast<std::size_t>(value);
+    }
+};
+
+
+
+// Function registering the callbacks (interleaved with
+// unrelated allocations that stay alive, as in a long
+// running program, if a scattering list is given)
+
+template<typename CallbacksType>
+
+void registerLargeCallbacks(CallbacksType& callbacks,
+                            std::size_t numberOfCallbacks,
+                            std::vector<std::unique_ptr<char[]>>* scatteringAllocations = nullptr)
+{
+    LargeCallable largeCallable;
+    largeCallable.m_state.fill(1);
+
+    for(std::size_t i = 0; i < numberOfCallbacks; ++i)
+    {
+        callbacks.register_callback(largeCallable);
+
+        if(scatteringAllocations)
+            scatteringAllocations->emplace_back(new char[64 + 32 * (i % 7)]);
+    }
+}
+
+
+
+template<typename CallbacksType>
+
+void benchmarkInvokeLargeCallbacks(BenchmarkLIB::BenchmarkRunner& runner,
+                                   const std::string& name,
+                                   CallbacksType& callbacks,
+                                   std::size_t numberOfCallbacks)
+{
+    runner.run("allocator/" + name, numberOfCallbacks, numberOfCallbacks, [&](std::size_t iterations)
+    {
+        for(std::size_t i = 0; i < iterations; ++i)
+            callbacks(1);
+
+        BenchmarkLIB::do_not_optimize(g_sink);
+    });
+}
+
+
+
+void benchmarkAllocators(BenchmarkLIB::BenchmarkRunner& runner)
+{
+    using HeapCallbacks = CallbacksLIB::Callbacks<void,int>;
+    using CallbackFunctionCallbacks = CallbacksLIB::BasicCallbacks<CallbacksLIB::AllocatorCallbacksPolicy<std::allocator<char>>,void,int>;
+
+    for(std::size_t numberOfCallbacks : {std::size_t(100), std::size_t(10000)})
+    {
+        // Registration throughput (a fresh callback
+        // system per iteration)
+
+        runner.run("allocator/register_std_function_heap", numberOfCallbacks, numberOfCallbacks, [&](std::size_t iterations)
+        {
+            for(std::size_t i = 0; i < iterations; ++i)
+            {
+                HeapCallbacks callbacks;
+                registerLargeCallbacks(callbacks, numberOfCallbacks);
+            }
+        });
+
+        runner.run("allocator/register_callback_function_heap", numberOfCallbacks, numberOfCallbacks, [&](std::size_t iterations)
+        {
+            for(std::size_t i = 0; i < iterations; ++i)
+            {
+                CallbackFunctionCallbacks callbacks;
+                registerLargeCallbacks(callbacks, numberOfCallbacks);
+            }
+        });
+
+#ifdef CALLBACKS_HAS_PMR
+        {
+            std::vector<char> arenaBuffer(numberOfCallbacks * 1024);
+
+            runner.run("allocator/register_pmr_monotonic_arena", numberOfCallbacks, numberOfCallbacks, [&](std::size_t iterations)
+            {
+                for(std::size_t i = 0; i < iterations; ++i)
+                {
+                    std::pmr::monotonic_buffer_resource arena(arenaBuffer.data(), arenaBuffer.size());
+                    CallbacksLIB::BasicCallbacks<CallbacksLIB::PmrCallbacksPolicy,void,int> callbacks(&arena);
+                    registerLargeCallbacks(callbacks, numberOfCallbacks);
+                }
+            });
+        }
+#endif
+
+
+
+        // Invoke cost once the state of the callbacks is
+        // scattered across the heap, or kept in an arena
+
+        {
+            std::vector<std::unique_ptr<char[]>> scatteringAllocations;
+
+            HeapCallbacks callbacks;
+            registerLargeCallbacks(callbacks, numberOfCallbacks, &scatteringAllocations);
+
+            benchmarkInvokeLargeCallbacks(runner, "invoke_std_function_scattered_heap", callbacks, numberOfCallbacks);
+        }
+
+#ifdef CALLBACKS_HAS_PMR
+        {
+            std::vector<std::unique_ptr<char[]>> scatteringAllocations;
+
+            std::pmr::monotonic_buffer_resource arena;
+            CallbacksLIB::BasicCallbacks<CallbacksLIB::PmrCallbacksPolicy,void,int> callbacks(&arena);
+            registerLargeCallbacks(callbacks, numberOfCallbacks, &scatteringAllocations);
+
+            benchmarkInvokeLargeCallbacks(runner, "invoke_pmr_arena", callbacks, numberOfCallbacks);
+        }
+#endif
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Benchmarks of the callback systems holding a few callbacks
+//-------------------------------------------------------------------
+template<typename CallbacksType>
+
+void benchmarkSmallRegistry(BenchmarkLIB::BenchmarkRunner& runner,
+                            const std::string& name,
+                            std::size_t numberOfCallbacks)
+{
+    // Registration (a fresh callback system per iteration)
+
+    runner.run("small/register_" + name, numberOfCallbacks, numberOfCallbacks, [&](std::size_t iterations)
+    {
+        for(std::size_t i = 0; i < iterations; ++i)
+        {
+            CallbacksType callbacks;
+
+            for(std::size_t j = 0; j < numberOfCallbacks; ++j)
+                callbacks.register_callback(&rawCallback);
+
+            BenchmarkLIB::do_not_optimize(callbacks);
+        }
+    });
+
+
+
+    // Invocation of many callback systems in turn
+    // (like the events of many objects)
+
+    const std::size_t numberOfRegistries = 1024;
+
+    std::vector<std::unique_ptr<CallbacksType>> registries;
+
+    for(std::size_t i = 0; i < numberOfRegistries; ++i)
+    {
+        registries.emplace_back(new CallbacksType());
+
+        for(std::size_t j = 0; j < numberOfCallbacks; ++j)
+            registries.back()->register_callback(&rawCallback);
+    }
+
+    runner.run("small/invoke_" + name, numberOfCallbacks, numberOfRegistries * numberOfCallbacks, [&](std::size_t iterations)
+    {
+        for(std::size_t i = 0; i < iterations; ++i)
+        {
+            for(const auto& callbacks : registries)
+                (*callbacks)(1);
+        }
+
+        BenchmarkLIB::do_not_optimize(g_sink);
+    });
+}
+
+
+
+void benchmarkSmallRegistries(BenchmarkLIB::BenchmarkRunner& runner)
+{
+    for(std::size_t numberOfCallbacks : {std::size_t(1), std::size_t(2), std::size_t(4), std::size_t(8)})
+    {
+        benchmarkSmallRegistry<CallbacksLIB::Callbacks<void,int>>(runner, "vector", numberOfCallbacks);
+        benchmarkSmallRegistry<CallbacksLIB::SmallCallbacks<4,void,int>>(runner, "small_4", numberOfCallbacks);
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Benchmarks of the growth of the storage of the callbacks
+//-------------------------------------------------------------------
+template<typename CallbacksType>
+
+void benchmarkStorageGrowth(BenchmarkLIB::BenchmarkRunner& runner,
+                            const std::string& name,
+                            std::size_t numberOfCallbacks,
+                            bool isReserved)
+{
+    runner.run("storage/" + name, numberOfCallbacks, numberOfCallbacks, [&](std::size_t iterations)
+    {
+        for(std::size_t i = 0; i < iterations; ++i)
+        {
+            CallbacksType callbacks;
+
+            if(isReserved)
+                callbacks.reserve(numberOfCallbacks);
+
+            for(std::size_t j = 0; j < numberOfCallbacks; ++j)
+                callbacks.register_callback([](int value){ g_sink += value; });
+
+            BenchmarkLIB::do_not_optimize(callbacks);
+        }
+    });
+}
+
+
+
+void benchmarkStorage(BenchmarkLIB::BenchmarkRunner& runner)
+{
+    for(std::size_t numberOfCallbacks : g_churnSizes)
+    {
+        benchmarkStorageGrowth<CallbacksLIB::Callbacks<void,int>>(runner, "fill_vector", numberOfCallbacks, false);
+        benchmarkStorageGrowth<CallbacksLIB::Callbacks<void,int>>(runner, "fill_vector_reserved", numberOfCallbacks, true);
+        benchmarkStorageGrowth<CallbacksLIB::SegmentedCallbacks<void,int>>(runner, "fill_segmented", numberOfCallbacks, false);
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Benchmarks of the destruction of the removed callbacks
+//-------------------------------------------------------------------
+
+// Captured state that is cheap to create but takes a
+// while to destroy (like releasing a large resource)
+
+struct ExpensiveToDestroy
+{
+    ~ExpensiveToDestroy()
+    {
+        volatile std::size_t sum = 0;
+
+        for(std::size_t i = 0; i < 1000; ++i)
+            sum = sum + i;
+    }
+};
+
+
+
+template<typename CallbacksPolicy>
+
+void benchmarkReclamationPolicy(BenchmarkLIB::BenchmarkRunner& runner,
+                                const std::string& name,
+                                std::size_t numberOfCallbacks)
+{
+    CallbacksLIB::BasicCallbacks<CallbacksPolicy,void,int> callbacks;
+
+    runner.run("reclamation/" + name, numberOfCallbacks, numberOfCallbacks, [&](std::size_t iterations)
+    {
+        for(std::size_t i = 0; i < iterations; ++i)
+        {
+            for(std::size_t j = 0; j < numberOfCallbacks; ++j)
+            {
+                auto state = std::make_shared<ExpensiveToDestroy>();
+
+                callbacks.register_callback([state](int value){ g_sink += value; });
+            }
+
+            callbacks.deregister_all_callbacks();
+        }
+    });
+}
+
+
+
+void benchmarkReclamation(BenchmarkLIB::BenchmarkRunner& runner)
+{
+    for(std::size_t numberOfCallbacks : {std::size_t(10), std::size_t(1000)})
+    {
+        benchmarkReclamationPolicy<CallbacksLIB::DefaultCallbacksPolicy>(runner, "register_deregister_all_inline", numberOfCallbacks);
+        benchmarkReclamationPolicy<CallbacksLIB::DeferredReclamationCallbacksPolicy>(runner, "register_deregister_all_deferred", numberOfCallbacks);
+    }
+
+    CallbacksLIB::CallbacksReclaimer::global().flush();
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Benchmarks of the cost of cloning the callback systems
+//-------------------------------------------------------------------
+template<typename CallbacksType>
+
+void benchmarkCloneRegistry(BenchmarkLIB::BenchmarkRunner& runner,
+                            const std::string& name,
+                            std::size_t numberOfCallbacks)
+{
+    CallbacksType callbacks;
+
+    for(std::size_t i = 0; i < numberOfCallbacks; ++i)
+        callbacks.register_callback([i](int value){ g_sink += i + static_cast<std::size_t>(value); });
+
+    runner.run("clone/" + name, numberOfCallbacks, 1, [&](std::size_t iterations)
+    {
+        for(std::size_t i = 0; i < iterations; ++i)
+        {
+            CallbacksType clone = callbacks.clone();
+
+            BenchmarkLIB::do_not_optimize(clone);
+        }
+    });
+}
+
+
+
+void benchmarkClone(BenchmarkLIB::BenchmarkRunner& runner)
+{
+    for(std::size_t numberOfCallbacks : {std::size_t(10), std::size_t(1000), std::size_t(100000)})
+    {
+        benchmarkCloneRegistry<CallbacksLIB::Callbacks<void,int>>(runner, "vector", numberOfCallbacks);
+        benchmarkCloneRegistry<CallbacksLIB::CopyOnWriteCallbacks<void,int>>(runner, "copy_on_write", numberOfCallbacks);
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Benchmarks of the cost of finding the callback to de-register
+//-------------------------------------------------------------------
+template<typename CallbacksType>
+
+void benchmarkLookupRegistry(BenchmarkLIB::BenchmarkRunner& runner,
+                             const std::string& name,
+                             std::size_t numberOfCallbacks)
+{
+    CallbacksType callbacks;
+
+    callbacks.reserve(numberOfCallbacks);
+
+    CallbacksLIB::CallbackID newestCallbackID = 0;
+
+    for(std::size_t i = 0; i < numberOfCallbacks; ++i)
+        newestCallbackID = callbacks.register_callback(&rawCallback);
+
+
+
+    // De-register the newest callback (the last one
+    // searched) and register a new one in its place
+
+    runner.run("lookup/deregister_newest_" + name, numberOfCallbacks, 1, [&](std::size_t iterations)
+    {
+        for(std::size_t i = 0; i < iterations; ++i)
+        {
+            callbacks.deregister_callback(newestCallbackID);
+            newestCallbackID = callbacks.register_callback(&rawCallback);
+        }
+    });
+
+
+
+    // De-register a callback that was already
+    // de-registered (the whole search, no erase)
+
+    CallbacksLIB::CallbackID staleCallbackID = newestCallbackID;
+
+    callbacks.deregister_callback(staleCallbackID);
+
+    runner.run("lookup/deregister_stale_" + name, numberOfCallbacks, 1, [&](std::size_t iterations)
+    {
+        for(std::size_t i = 0; i < iterations; ++i)
+            BenchmarkLIB::do_not_optimize(callbacks.deregister_callback(staleCallbackID));
+    });
+}
+
+
+
+void benchmarkLookup(BenchmarkLIB::BenchmarkRunner& runner)
+{
+    for(std::size_t numberOfCallbacks : {std::size_t(100), std::size_t(1000), std::size_t(100000)})
+    {
+        benchmarkLookupRegistry<CallbacksLIB::Callbacks<void,int>>(runner, "scan", numberOfCallbacks);
+        benchmarkLookupRegistry<CallbacksLIB::IndexedCallbacks<void,int>>(runner, std::string("packed_index_") + CallbacksLIB::PackedCallbackIdSearch::instruction_set(), numberOfCallbacks);
+    }
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// main function
+//-------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    BenchmarkLIB::BenchmarkRunner runner(argc, argv);
+
+    benchmarkInvoke(runner);
+    benchmarkChurn(runner);
+    benchmarkArguments(runner);
+    benchmarkExceptions(runner);
+    benchmarkAllocators(runner);
+    benchmarkSmallRegistries(runner);
+    benchmarkStorage(runner);
+    benchmarkReclamation(runner);
+    benchmarkClone(runner);
+    benchmarkLookup(runner);
+
+    runner.write_results();
+
+    return 0;
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,296 @@
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Benchmark of the memory footprint of objects embedding a callback system
+///
+/// -- memory/*     Bytes used per object by objects embedding Callbacks or
+///                 CompactCallbacks, with no callback registered, with a
+///                 single callback registered, and with a single callback
+///                 registered for 1% of the objects (compared to objects
+///                 whose callbacks are kept in a CallbacksTable)
+///
+/// The heap bytes are all the bytes requested from operator new (counted by
+/// replacing it) while registering the callbacks, so they include the
+/// buffers freed when containers grow but not the overhead of the allocator
+///
+/// Results are written as JSON, either to stdout or to the file given with
+/// the --out=<file> command line argument
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+#include "callbacks_compact.hpp"
+#include "callbacks_table.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Replaced global operators counting the requested heap bytes
+//-------------------------------------------------------------------
+namespace
+{
+    std::atomic<std::size_t> g_numberOfAllocatedBytes(0);
+
+
+
+    void* counted_allocation(std::size_t sizeInBytes)
+    {
+        g_numberOfAllocatedBytes.fetch_add(sizeInBytes, std::memory_order_relaxed);
+
+        void* memory = std::malloc(sizeInBytes ? sizeInBytes : 1);
+
+        if(!memory)
+            throw std::bad_alloc();
+
+        return memory;
+    }
+}
+
+
+
+void* operator new(std::size_t sizeInBytes)
+{
+    return counted_allocation(sizeInBytes);
+}
+
+
+
+void* operator new[](std::size_t sizeInBytes)
+{
+    return counted_allocation(sizeInBytes);
+}
+
+
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Helpers used by the benchmark
+//-------------------------------------------------------------------
+namespace
+{
+
+
+
+// Number of objects created by each benchmark
+
+const std::size_t g_numberOfObjects = 1000000;
+
+
+
+// Object embedding a callback system, as in
+// the README example
+
+template<typename CallbacksType>
+
+struct Object
+{
+    int                                 m_value = 0;
+    CallbacksType                       m_onValueChanged;
+};
+
+
+
+void onValueChanged(int)
+{
+}
+
+
+
+// The result of a memory benchmark
+
+struct MemoryResult
+{
+    std::string                         m_name;
+    std::size_t                         m_objectSizeInBytes = 0;
+    double                              m_heapBytesPerObject = 0;
+};
+
+
+
+// Function used to create a result and report it
+
+MemoryResult createResult(const std::string& name, std::size_t objectSizeInBytes, std::size_t allocatedBytes)
+{
+    MemoryResult result;
+
+    result.m_name = name;
+    result.m_objectSizeInBytes = objectSizeInBytes;
+    result.m_heapBytesPerObject = static_cast<double>(allocatedBytes) / static_cast<double>(g_numberOfObjects);
+
+    std::cerr << name << ": " << result.m_objectSizeInBytes << " bytes/object + "
+              << result.m_heapBytesPerObject << " heap bytes/object" << std::endl;
+
+    return result;
+}
+
+
+
+// Function measuring the bytes used by the objects
+// embedding the specified callback system, with the
+// specified number of callbacks registered for one
+// object out of subscriptionStride
+
+template<typename CallbacksType>
+
+MemoryResult measureFootprint(const std::string& name, int numberOfCallbacksPerObject, std::size_t subscriptionStride = 1)
+{
+    std::vector<Object<CallbacksType>> objects(g_numberOfObjects);
+
+    std::size_t allocatedBytesBefore = g_numberOfAllocatedBytes.load(std::memory_order_relaxed);
+
+    for(std::size_t i = 0; i < objects.size(); i += subscriptionStride)
+    {
+        for(int j = 0; j < numberOfCallbacksPerObject; ++j)
+            objects[i].m_onValueChanged.register_callback(&onValueChanged);
+    }
+
+    std::size_t allocatedBytes = g_numberOfAllocatedBytes.load(std::memory_order_relaxed) - allocatedBytesBefore;
+
+    return createResult(name, sizeof(Object<CallbacksType>), allocatedBytes);
+}
+
+
+
+// Function measuring the bytes used by objects whose
+// callbacks are kept in a table (the objects don't
+// embed anything)
+
+MemoryResult measureTableFootprint(const std::string& name, int numberOfCallbacksPerObject, std::size_t subscriptionStride)
+{
+    std::vector<int> objects(g_numberOfObjects);
+
+    std::size_t allocatedBytesBefore = g_numberOfAllocatedBytes.load(std::memory_order_relaxed);
+
+    {
+        CallbacksLIB::CallbacksTable<void,int> table;
+
+        for(std::size_t i = 0; i < objects.size(); i += subscriptionStride)
+        {
+            for(int j = 0; j < numberOfCallbacksPerObject; ++j)
+                table.register_callback(&objects[i], &onValueChanged);
+        }
+
+        std::size_t allocatedBytes = g_numberOfAllocatedBytes.load(std::memory_order_relaxed) - allocatedBytesBefore;
+
+        return createResult(name, sizeof(int), allocatedBytes);
+    }
+}
+
+
+
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// main function
+//-------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    std::string outputFileName;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string argument(argv[i]);
+
+        if(argument.compare(0, 6, "--out=") == 0)
+            outputFileName = argument.substr(6);
+        else
+            std::cerr << "Ignoring unknown argument: " << argument << std::endl;
+    }
+
+    std::vector<MemoryResult> results;
+
+    results.push_back(measureFootprint<CallbacksLIB::Callbacks<void,int>>("memory/callbacks_empty", 0));
+    results.push_back(measureFootprint<CallbacksLIB::CompactCallbacks<void,int>>("memory/compact_callbacks_empty", 0));
+    results.push_back(measureFootprint<CallbacksLIB::Callbacks<void,int>>("memory/callbacks_one_callback", 1));
+    results.push_back(measureFootprint<CallbacksLIB::CompactCallbacks<void,int>>("memory/compact_callbacks_one_callback", 1));
+    results.push_back(measureFootprint<CallbacksLIB::Callbacks<void,int>>("memory/callbacks_1_percent_subscribed", 1, 100));
+    results.push_back(measureFootprint<CallbacksLIB::CompactCallbacks<void,int>>("memory/compact_callbacks_1_percent_subscribed", 1, 100));
+    results.push_back(measureTableFootprint("memory/callbacks_table_1_percent_subscribed", 1, 100));
+
+    std::ostringstream json;
+
+    json << "{\n";
+    json << "  \"context\": {\n";
+    json << "    \"number_of_objects\": " << g_numberOfObjects << "\n";
+    json << "  },\n";
+    json << "  \"benchmarks\": [\n";
+
+    for(std::size_t i = 0; i < results.size(); ++i)
+    {
+        const MemoryResult& result = results[i];
+
+        json << "    {"
+             << "\"name\": \"" << result.m_name << "\", "
+             << "\"object_bytes\": " << result.m_objectSizeInBytes << ", "
+             << "\"heap_bytes_per_object\": " << result.m_heapBytesPerObject << ", "
+             << "\"bytes_per_object\": " << static_cast<double>(result.m_objectSizeInBytes) + result.m_heapBytesPerObject
+             << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+
+    json << "  ]\n";
+    json << "}\n";
+
+    if(outputFileName.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream outputFile(outputFileName.c_str());
+        outputFile << json.str();
+    }
+
+    return 0;
+}
+//-------------------------------------------------------------------
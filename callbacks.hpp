@@ -36,6 +36,13 @@
 ///        about whether the callbacks successfully understand and work on
 ///        the input arguments or not
 ///
+/// -- A callback system is invoked by one thread at a time.  The invoke
+///    functions are const but still update its bookkeeping (how deeply the
+///    invocations are nested, the countdown of the one-shot callbacks, and
+///    the removal of the callbacks used up or de-registered during the
+///    invocation), so invoking the same callback system from several
+///    threads at once needs external synchronization
+///
 ///
 ///
 /// Note: This class is defined within the namespace CallbacksLIB
@@ -58,6 +65,15 @@
 #include <functional>
 #include <vector>
 #include <atomic>
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+#include <memory>
+#include <chrono>
+#include <tuple>
+#include <string>
+#include <initializer_list>
+#include <iterator>
 //-------------------------------------------------------------------
 
 
@@ -71,20 +87,37 @@ namespace CallbacksLIB
 
 
 
+//-------------------------------------------------------------------
+// Type of the IDs identifying the registered callbacks (0 is never
+// a valid ID)
+//
+// The IDs are assigned by a 63-bit counter, which would take
+// centuries to wrap around even at a billion registrations per
+// second, so a callback system never assigns the same ID twice
+//-------------------------------------------------------------------
+using CallbackID = std::uint64_t;
+//-------------------------------------------------------------------
+
+
+
 //-------------------------------------------------------------------
 // Class used to pair a callback function with an ID to allow
 // de-registering callbacks
+//
+// The function type stores the callable (std::function unless
+// the policy of the callback system selects another one)
 //-------------------------------------------------------------------
-template<typename CallbackReturnType,
+template<typename FunctionType,
+         typename CallbackReturnType,
          typename...CallbackArguments>
 
-class Callback
+class BasicCallback
 {
 public: // Public typedefs
 
 
 
-    using CallbackFunctionType = std::function<CallbackReturnType(CallbackArguments...arguments)>;
+    using CallbackFunctionType = FunctionType;
 
 
 
@@ -92,8 +125,27 @@ public: // Constructors and destructor
 
 
 
-    Callback(){}
-    ~Callback(){}
+    BasicCallback() : m_id(0), m_isTracked(0){}
+    ~BasicCallback(){}
+
+
+
+    // Constructor taking over a callable (so that
+    // an allocator-aware function keeps the
+    // allocator it was created with)
+
+    explicit BasicCallback(CallbackFunctionType callback) : m_id(0), m_isTracked(0), m_callback(std::move(callback)){}
+
+
+
+    // Callbacks are moved (not copied) when the
+    // registry shifts them to make room for a
+    // higher priority callback
+
+    BasicCallback(const BasicCallback& callback) = default;
+    BasicCallback(BasicCallback&& callback) = default;
+    BasicCallback& operator=(const BasicCallback& callback) = default;
+    BasicCallback& operator=(BasicCallback&& callback) = default;
 
 
 
@@ -115,13 +167,61 @@ public: // Operator and function used to invoke the callback
 
 
 
+public: // Function used to query the state of the callback
+
+
+
+    // Returns false once the callback has used up
+    // all of its allowed invocations (the registry
+    // skips it and removes it after the invocation)
+
+    bool                        is_active()const
+    {
+        return m_remainingInvocations != 0;
+    }
+
+
+
 public: // Public variables
 
 
 
     // The callback ID used to de-register callbacks
+    //
+    // NOTE:  It shares its 64 bits with m_isTracked, so
+    //        that the ID, the priority, the number of
+    //        invocations and the tracking flag still fit
+    //        in 16 bytes
+
+    CallbackID                  m_id : 63;
+
+
+
+    // Whether the callback tracks the lifetime of
+    // an object and is dropped once that object is
+    // destroyed (the object is kept in the trackers
+    // of the callback system, so that untracked
+    // callbacks don't pay for it)
 
-    int                         m_id = 0;
+    CallbackID                  m_isTracked : 1;
+
+
+
+    // The priority of the callback (callbacks with
+    // a higher priority are invoked first)
+
+    int                         m_priority = 0;
+
+
+
+    // The number of invocations left before the
+    // callback is automatically de-registered
+    // (a negative number means unlimited)
+    //
+    // NOTE:  It is mutable because it is counted
+    //        down while invoking the callbacks
+
+    mutable int                 m_remainingInvocations = -1;
 
 
 
@@ -135,173 +235,268 @@ public: // Public variables
 
 
 //-------------------------------------------------------------------
-// Class defining a "callback system" which is made of a vector
-// that holds "registered callbacks"
-//
-// The system allows programmers to "register", "invoke" and
-// "deregister" callback functions
+// Callback storing its callable in a std::function
 //-------------------------------------------------------------------
 template<typename CallbackReturnType,
          typename...CallbackArguments>
 
-class Callbacks
+using Callback = BasicCallback<std::function<CallbackReturnType(CallbackArguments...)>,CallbackReturnType,CallbackArguments...>;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Trait telling whether a function type can be constructed with an
+// allocator (std::allocator_arg), so that the callback system can
+// move the callables to its own allocator (see callbacks_function.hpp)
+//-------------------------------------------------------------------
+template<typename FunctionType>
+
+struct IsAllocatorAwareFunction : std::false_type
 {
-public: // Public typedefs
+};
+//-------------------------------------------------------------------
 
 
 
-    using CallbackFunctionType = std::function<CallbackReturnType(CallbackArguments...arguments)>;
-    using CallbackType = Callback<CallbackReturnType,CallbackArguments...>;
+//-------------------------------------------------------------------
+// Trait telling up to how many callbacks a storage type should be
+// walked with an unrolled loop when invoking the callbacks (zero,
+// the default, always uses the regular loop, see callbacks_small.hpp)
+//-------------------------------------------------------------------
+template<typename StorageType>
 
+struct UnrolledInvocationSize : std::integral_constant<std::size_t,0>
+{
+};
+//-------------------------------------------------------------------
 
 
 
-public: // Constructors and destructor
+//-------------------------------------------------------------------
+// Trait telling whether copies of a storage type share their
+// elements until one of them is modified (see
+// callbacks_copy_on_write.hpp), in which case the storage provides
+// an unshare() function giving a copy its own elements
+//-------------------------------------------------------------------
+template<typename StorageType>
 
+struct IsCopyOnWriteStorage : std::false_type
+{
+};
+//-------------------------------------------------------------------
 
 
-    // Default constructor
 
-    Callbacks(){}
+//-------------------------------------------------------------------
+// Helpers used to expand a tuple of arguments into a call (the
+// C++11 equivalent of std::index_sequence)
+//-------------------------------------------------------------------
+template<std::size_t...Indices>
 
+struct IndexSequence
+{
+};
 
 
-    // Destructor
 
-    ~Callbacks(){}
+template<std::size_t N, std::size_t...Indices>
 
+struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, Indices...>
+{
+};
 
 
-public: // Public functions
 
+template<std::size_t...Indices>
 
+struct MakeIndexSequence<0, Indices...>
+{
+    using Type = IndexSequence<Indices...>;
+};
+//-------------------------------------------------------------------
 
-    // Function used to register a callback
 
-    int register_callback(CallbackFunctionType callback)
-    {
-        CallbackType newCallback;
 
-        newCallback.m_id = (++m_lastAssignedCallback_ID);
-        newCallback.m_callback = callback;
+//-------------------------------------------------------------------
+// Counters describing how many callbacks were dropped because
+// the object whose lifetime they track had been destroyed
+//-------------------------------------------------------------------
+struct ExpiredCallbacksStatistics
+{
+    // Total number of expired callbacks removed
 
-        m_callbacks.push_back(newCallback);
+    std::size_t                         m_numberOfExpiredCallbacksCollected = 0;
 
-        return newCallback.m_id;
-    }
 
 
+    // Number of clean-up passes that removed
+    // at least one expired callback
 
-    // Function used to de-register a callback
+    std::size_t                         m_numberOfSweeps = 0;
+};
+//-------------------------------------------------------------------
 
-    bool deregister_callback(const int& callbackID)
-    {
-        for(int i = 0; i < m_callbacks.size(); ++i)
-        {
-            if(m_callbacks[i].m_id == callbackID)
-            {
-                m_callbacks.erase(m_callbacks.begin() + i);
-                return true;
-            }
-        }
 
-        return false;
-    }
 
+//-------------------------------------------------------------------
+// Descriptive data attached to a registered callback (used by
+// debugging and monitoring tools)
+//
+// The callback systems keep it in a separate array, sorted by
+// callback ID, so that attaching it doesn't grow the callbacks
+// walked when invoking them
+//-------------------------------------------------------------------
+struct CallbackMetadata
+{
+    // Name of the callback
 
+    std::string                         m_name;
 
-    // Function used to de-register all callbacks
 
-    void deregister_all_callbacks()
-    {
-        m_callbacks.clear();
-    }
 
+    // The object that registered the callback
 
+    const void*                         m_owner = nullptr;
 
-    // Function invoking all the callbacks
 
-    CallbackReturnType invokeCallbacks(CallbackArguments...arguments)const
-    {
-        for(const auto& callback : m_callbacks)
-        {
-            callback(arguments...);
-        }
-    }
 
+    // Free-form description (for example where
+    // the callback was registered)
 
+    std::string                         m_description;
+};
+//-------------------------------------------------------------------
 
-public: // Public operator() used to invoke all
-        // the callbacks with the specified arguments
 
 
+//-------------------------------------------------------------------
+// Description of a registered callback returned by list_callbacks()
+//-------------------------------------------------------------------
+struct CallbackInfo
+{
+    // The ID and priority of the callback
 
-    CallbackReturnType operator()(CallbackArguments...arguments)const
-    {
-        for(const auto& callback : m_callbacks)
-        {
-            callback(arguments...);
-        }
-    }
+    CallbackID                          m_id = 0;
+    int                                 m_priority = 0;
 
 
 
-protected: // Protected variables
+    // The number of invocations left (a negative
+    // number means unlimited)
 
+    int                                 m_remainingInvocations = -1;
 
 
-    // The vector holding the callbacks
-    // that have been added
 
-    std::vector<CallbackType>           m_callbacks;
+    // Whether the callback tracks the lifetime of
+    // an object (or is owned by a connection)
 
+    bool                                m_isTracked = false;
 
 
-    // The ID used to identify each
-    // added callback to allow users
-    // to de-register them at a later
-    // time
-    //
-    // NOTE:  It is made atomic to allow
-    //        multiple threads to register
-    //        callbacks while being assigned
-    //        a unique id
+
+    // Whether the callback was registered from within
+    // a callback and is only added once the current
+    // invocation finishes
+
+    bool                                m_isPending = false;
+
 
 
-    std::atomic<int>                    m_lastAssignedCallback_ID;
+    // The metadata attached to the callback (empty
+    // if none was attached)
+
+    CallbackMetadata                    m_metadata;
 };
 //-------------------------------------------------------------------
 
 
 
 //-------------------------------------------------------------------
-// Specialization that invokes the callbacks but returns as soon as
-// one of them returns a non-empty container
-//
-// This specialization assumes the return type is a container that
-// defines the empty() member function
-//
-// Callbacks are invoked sequentially until one of them returns a
-// non-empty container
+// Result of invoking the callbacks within a time budget
 //-------------------------------------------------------------------
-template<typename CallbackReturnType,
-         typename...CallbackArguments>
+struct BudgetedInvocationResult
+{
+    // True if every callback was invoked before
+    // the budget ran out
+
+    bool                                m_isComplete = true;
+
+
+
+    // Number of callbacks invoked
+
+    std::size_t                         m_numberOfCallbacksInvoked = 0;
+
+
+
+    // ID and priority of the first callback that was
+    // not invoked because the budget ran out (ID 0 if
+    // complete), used to resume the invocation in a
+    // later pass
 
-class CallbacksReturningAContainer : public Callbacks<CallbackReturnType,CallbackArguments...>
+    CallbackID                          m_resumeCallbackID = 0;
+    int                                 m_resumePriority = 0;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Move-only handle returned when connecting a callback, which
+// de-registers the callback when the handle is destroyed
+//
+// The handle owns a token that the registered callback tracks,
+// so disconnecting is O(1) (it doesn't search for the callback's
+// ID) and it is safe even if the callback system was destroyed
+// first.  The callback system skips the disconnected callback
+// and removes it in its next clean-up pass
+//-------------------------------------------------------------------
+class ScopedConnection
 {
 public: // Constructors and destructor
 
 
 
-    // Default constructor
+    // Default constructor (not connected)
 
-    CallbacksReturningAContainer() : Callbacks<CallbackReturnType,CallbackArguments...> (){}
+    ScopedConnection(){}
 
 
 
-    // Destructor
+    // Constructor taking the token tracked
+    // by the connected callback
+
+    explicit ScopedConnection(std::shared_ptr<void> connectionToken) : m_connectionToken(std::move(connectionToken)){}
+
+
+
+    // Connections can be moved but not copied
+
+    ScopedConnection(ScopedConnection&& connection) = default;
+    ScopedConnection& operator=(ScopedConnection&& connection)
+    {
+        if(this != &connection)
+        {
+            disconnect();
+            m_connectionToken = std::move(connection.m_connectionToken);
+        }
+
+        return *this;
+    }
+
+    ScopedConnection(const ScopedConnection& connection) = delete;
+    ScopedConnection& operator=(const ScopedConnection& connection) = delete;
+
+
+
+    // Destructor (disconnects the callback)
 
-    ~CallbacksReturningAContainer(){}
+    ~ScopedConnection()
+    {
+        disconnect();
+    }
 
 
 
@@ -309,87 +504,2625 @@ public: // Public functions
 
 
 
-    // Function invoking all the callbacks but
-    // returning as soon as a callback returns
-    // a non-empty container
+    // Function used to disconnect the callback
+    // before the connection is destroyed
 
-    CallbackReturnType invokeCallbacksUntilOneOfThemReturnsANonEmptyContainer(CallbackArguments...arguments)const
+    void disconnect()
     {
-        CallbackReturnType callbackReturn;
+        m_connectionToken.reset();
+    }
 
-        for(const auto& callback : this->m_callbacks)
-        {
-            callbackReturn = callback(arguments...);
 
-            if(!callbackReturn.empty())
-                return callbackReturn;
-        }
 
-        return callbackReturn;
+    // Returns true if the connection has not
+    // been disconnected (or moved from)
+
+    bool is_connected()const
+    {
+        return m_connectionToken != nullptr;
     }
+
+
+
+private: // Private variables
+
+
+
+    // The token tracked by the connected callback
+
+    std::shared_ptr<void>               m_connectionToken;
 };
 //-------------------------------------------------------------------
 
 
 
 //-------------------------------------------------------------------
-// Specialization that invokes the callbacks but returns as soon as
-// one of them returns a non-zero value (like a boolean true)
+// Instrumentation used by default, which doesn't measure anything
+// (invoking the callbacks through it compiles down to direct calls)
 //
-// This specialization assumes the return type can be checked like
-// a boolean in an if-statement
+// Custom instrumentation classes (see callbacks_instrumentation.hpp
+// and callbacks_tracing.hpp) provide the same functions:
+//
+// -- measure_invocation() wraps a whole invocation of the callbacks
+//    and is handed the callback system and the name of the invoke
+//    function that was called
+//
+// -- measure() wraps the invocation of a single callback and is
+//    handed the ID of the callback
+//
+// -- forget() and forget_all() are called when a callback, or all of
+//    them, are removed from the callback system (never while they are
+//    being invoked), so that what is kept per callback stays bounded
 //-------------------------------------------------------------------
-template<typename...CallbackArguments>
-
-class CallbacksReturningABoolean : public Callbacks<bool,CallbackArguments...>
+class NoInstrumentation
 {
-public: // Public typedefs
+public: // Public functions
 
 
 
-    using CallbackFunctionType = typename Callbacks<bool,CallbackArguments...>::CallbackFunctionType;
+    template<typename InvokeFunction>
 
+    auto measure_invocation(const void* callbacks, const char* invokerName, InvokeFunction&& invokeFunction)const -> decltype(invokeFunction())
+    {
+        (void)callbacks;
+        (void)invokerName;
 
+        return invokeFunction();
+    }
 
-public: // Constructors and destructor
 
 
+    template<typename InvokeFunction>
 
-    // Default constructor
+    auto measure(CallbackID callbackID, InvokeFunction&& invokeFunction)const -> decltype(invokeFunction())
+    {
+        (void)callbackID;
 
-    CallbacksReturningABoolean() : Callbacks<bool,CallbackArguments...> (){}
+        return invokeFunction();
+    }
 
 
 
-    // Destructor
+    void forget(CallbackID callbackID)const
+    {
+        (void)callbackID;
+    }
 
-    ~CallbacksReturningABoolean(){}
+    void forget_all()const
+    {
+    }
+};
+//-------------------------------------------------------------------
 
 
 
+//-------------------------------------------------------------------
+// Circuit breaker used by default, which never disables a callback
+//
+// Custom circuit breakers (see callbacks_circuit_breaker.hpp) provide
+// the same guard() function, which is handed the ID of the callback
+// about to be invoked and a function invoking it.  The guard either
+// calls the function and returns its result (true stops the walk) or
+// skips the callback and returns false.  Like the instrumentation,
+// they are told through forget() and forget_all() when callbacks are
+// removed
+//-------------------------------------------------------------------
+class NoCircuitBreaker
+{
 public: // Public functions
 
 
 
-    // Function invoking all the callbacks but
-    // returning as soon as a callback returns
-    // a non-zero value (like a boolean true)
+    template<typename InvokeFunction>
 
-    bool invokeCallbacksUntilOneOfThemReturnsANonZeroValue(CallbackArguments...arguments)const
+    bool guard(CallbackID callbackID, InvokeFunction&& invokeFunction)const
     {
-        for(const auto& callback : this->m_callbacks)
-        {
-            if(callback(arguments...))
-                return true;
-        }
+        (void)callbackID;
 
-        return false;
+        return invokeFunction();
+    }
+
+
+
+    void forget(CallbackID callbackID)const
+    {
+        (void)callbackID;
+    }
+
+    void forget_all()const
+    {
     }
 };
 //-------------------------------------------------------------------
 
 
 
+//-------------------------------------------------------------------
+// Exception policy used by default, which lets an exception thrown
+// by a callback propagate to the caller (the remaining callbacks
+// are not invoked) without adding any try/catch to the invocation
+//
+// Custom exception policies (see callbacks_exceptions.hpp) provide
+// the same begin_invocation() function, returning a scope that lives
+// for one invocation of the callbacks.  The scope wraps each callback
+// invocation with invoke() and is told when the walk is done with
+// finish()
+//-------------------------------------------------------------------
+class PropagateExceptions
+{
+public: // Public classes
+
+
+
+    class InvocationScope
+    {
+    public:
+
+        template<typename InvokeFunction>
+
+        bool invoke(CallbackID callbackID, InvokeFunction&& invokeFunction)
+        {
+            (void)callbackID;
+
+            return invokeFunction();
+        }
+
+        void finish(){}
+    };
+
+
+
+public: // Public functions
+
+
+
+    InvocationScope begin_invocation()const
+    {
+        return InvocationScope();
+    }
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Reclamation policy used by default, which destroys the callbacks
+// (and their callables) right away when they are removed
+//
+// Custom reclamation policies (see callbacks_reclamation.hpp) provide
+// the same functions, called with a callback that is about to be
+// removed, with a container whose callbacks are all removed, and
+// once a pass has retired all the callbacks it removes (so that they
+// can be handed over together)
+//-------------------------------------------------------------------
+class DestroyCallbacksInline
+{
+public: // Public functions
+
+
+
+    // Function called with a callback that is about to be
+    // removed (leaving it in place destroys it with the
+    // slot it is stored in)
+
+    template<typename CallbackType>
+
+    void retire(CallbackType& callback)const
+    {
+        (void)callback;
+    }
+
+
+
+    // Function called to remove all the callbacks
+    // of a container
+
+    template<typename ContainerType>
+
+    void retire_all(ContainerType& callbacks)const
+    {
+        callbacks.clear();
+    }
+
+
+
+    // Function called once a pass has retired
+    // the callbacks it removes
+
+    void end_pass()const
+    {
+    }
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// ID index used by default, which finds a callback by comparing the
+// ID of each registered callback in turn
+//
+// Custom ID indexes (see callbacks_id_index.hpp) provide the same
+// functions, and are told about every callback inserted in or
+// erased from the vector of callbacks so that they can keep their
+// own copy of the IDs, in the same order
+//-------------------------------------------------------------------
+class NoCallbackIdIndex
+{
+public: // Public functions
+
+
+
+    // Function used to find the index of the callback with
+    // the specified ID (returns the number of callbacks if
+    // there is none)
+
+    template<typename ContainerType>
+
+    std::size_t find(const ContainerType& callbacks, CallbackID callbackID)const
+    {
+        for(std::size_t i = 0; i < callbacks.size(); ++i)
+        {
+            if(callbacks[i].m_id == callbackID)
+                return i;
+        }
+
+        return callbacks.size();
+    }
+
+
+
+    // Functions called when a callback is inserted at or
+    // erased from the specified index
+
+    void insert(std::size_t index, CallbackID callbackID)
+    {
+        (void)index;
+        (void)callbackID;
+    }
+
+    void erase(std::size_t index)
+    {
+        (void)index;
+    }
+
+
+
+    // Function called when room is made for the
+    // specified number of callbacks
+
+    void reserve(std::size_t numberOfCallbacks)
+    {
+        (void)numberOfCallbacks;
+    }
+
+
+
+    // Functions called when the callbacks were rearranged
+    // (several of them added or removed in one pass), or
+    // all removed
+
+    template<typename ContainerType>
+
+    void rebuild(const ContainerType& callbacks)
+    {
+        (void)callbacks;
+    }
+
+    void clear()
+    {
+    }
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Policy selecting the optional features of a callback system at
+// compile time
+//
+// Custom policies derive from this one and only redefine the
+// features they want to change, for example:
+//
+//     struct MeasuredCallbacksPolicy : DefaultCallbacksPolicy
+//     {
+//         using InstrumentationType = LatencyInstrumentation;
+//     };
+//
+//     BasicCallbacks<MeasuredCallbacksPolicy,void,int> callbacks;
+//-------------------------------------------------------------------
+struct DefaultCallbacksPolicy
+{
+    // Instrumentation wrapped around each callback invocation
+
+    using InstrumentationType = NoInstrumentation;
+
+
+
+    // Circuit breaker deciding whether each callback
+    // is invoked or skipped
+
+    using CircuitBreakerType = NoCircuitBreaker;
+
+
+
+    // Policy deciding what happens when a callback throws
+
+    using ExceptionPolicyType = PropagateExceptions;
+
+
+
+    // Policy deciding where removed callbacks are destroyed
+
+    using ReclamationType = DestroyCallbacksInline;
+
+
+
+    // Index used to find a callback from its ID
+
+    using IdIndexType = NoCallbackIdIndex;
+
+
+
+    // Allocator of the vectors of callbacks (rebound to
+    // the callback type), also handed to the callables
+    // if the function type is allocator-aware
+
+    using AllocatorType = std::allocator<char>;
+
+
+
+    // Type storing the callables
+
+    template<typename Signature>
+
+    using FunctionType = std::function<Signature>;
+
+
+
+    // Container storing the callbacks (its max_size()
+    // is the maximum number of registered callbacks)
+
+    template<typename CallbackType, typename CallbackAllocatorType>
+
+    using StorageType = std::vector<CallbackType,CallbackAllocatorType>;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Class defining a "callback system" which is made of a vector
+// that holds "registered callbacks"
+//
+// The system allows programmers to "register", "invoke" and
+// "deregister" callback functions
+//
+// The policy selects the optional features of the callback system
+// (see DefaultCallbacksPolicy), most code uses the Callbacks alias
+// defined below which uses the default policy
+//-------------------------------------------------------------------
+template<typename CallbacksPolicy,
+         typename CallbackReturnType,
+         typename...CallbackArguments>
+
+class BasicCallbacks
+{
+public: // Public typedefs
+
+
+
+    using CallbackFunctionType = typename CallbacksPolicy::template FunctionType<CallbackReturnType(CallbackArguments...)>;
+    using CallbackType = BasicCallback<CallbackFunctionType,CallbackReturnType,CallbackArguments...>;
+    using AllocatorType = typename CallbacksPolicy::AllocatorType;
+    using CallbackAllocatorType = typename std::allocator_traits<AllocatorType>::template rebind_alloc<CallbackType>;
+    using CallbacksVectorType = typename CallbacksPolicy::template StorageType<CallbackType,CallbackAllocatorType>;
+    using InstrumentationType = typename CallbacksPolicy::InstrumentationType;
+    using CircuitBreakerType = typename CallbacksPolicy::CircuitBreakerType;
+    using ExceptionPolicyType = typename CallbacksPolicy::ExceptionPolicyType;
+    using ReclamationType = typename CallbacksPolicy::ReclamationType;
+    using IdIndexType = typename CallbacksPolicy::IdIndexType;
+
+
+
+    // Up to how many callbacks the invocations use
+    // an unrolled loop (see UnrolledInvocationSize)
+
+    static const std::size_t            s_unrolledInvocationSize = UnrolledInvocationSize<CallbacksVectorType>::value;
+
+
+
+
+public: // Constructors and destructor
+
+
+
+    // Default constructor
+
+    BasicCallbacks(){}
+
+
+
+    // Constructor taking the allocator of the callbacks
+    // (for example a std::pmr::polymorphic_allocator
+    // pointing to an arena)
+
+    explicit BasicCallbacks(const AllocatorType& allocator) :
+        m_callbacks(CallbackAllocatorType(allocator)),
+        m_pendingCallbacks(CallbackAllocatorType(allocator)),
+        m_trackers(TrackerAllocatorType(allocator))
+    {
+    }
+
+
+
+    // Destructor
+
+    ~BasicCallbacks(){}
+
+
+
+    // Callback systems can be moved (the IDs of the
+    // callbacks stay valid in the new callback system),
+    // but they must not be moved while invoking their
+    // callbacks.  Copies are made explicitly with clone()
+
+    BasicCallbacks(BasicCallbacks&& callbacks) :
+        m_callbacks(std::move(callbacks.m_callbacks)),
+        m_hasRetiredCallbacks(callbacks.m_hasRetiredCallbacks),
+        m_instrumentation(std::move(callbacks.m_instrumentation)),
+        m_circuitBreaker(std::move(callbacks.m_circuitBreaker)),
+        m_exceptionPolicy(std::move(callbacks.m_exceptionPolicy)),
+        m_reclamation(std::move(callbacks.m_reclamation)),
+        m_idIndex(std::move(callbacks.m_idIndex)),
+        m_pendingCallbacks(std::move(callbacks.m_pendingCallbacks)),
+        m_trackers(std::move(callbacks.m_trackers)),
+        m_hasReleasedTrackers(callbacks.m_hasReleasedTrackers),
+        m_metadata(std::move(callbacks.m_metadata)),
+        m_nextExpiredCallbacksSweepSize(callbacks.m_nextExpiredCallbacksSweepSize),
+        m_numberOfExpiredCallbacksToCollect(callbacks.m_numberOfExpiredCallbacksToCollect),
+        m_expiredCallbacksStatistics(callbacks.m_expiredCallbacksStatistics),
+        m_numberOfCallbacks(callbacks.m_numberOfCallbacks.load(std::memory_order_relaxed)),
+        m_lastAssignedCallback_ID(callbacks.m_lastAssignedCallback_ID.load())
+    {
+        callbacks.reset_after_move();
+    }
+
+    BasicCallbacks& operator=(BasicCallbacks&& callbacks)
+    {
+        if(this != &callbacks)
+        {
+            m_callbacks = std::move(callbacks.m_callbacks);
+            m_hasRetiredCallbacks = callbacks.m_hasRetiredCallbacks;
+            m_instrumentation = std::move(callbacks.m_instrumentation);
+            m_circuitBreaker = std::move(callbacks.m_circuitBreaker);
+            m_exceptionPolicy = std::move(callbacks.m_exceptionPolicy);
+            m_reclamation = std::move(callbacks.m_reclamation);
+            m_idIndex = std::move(callbacks.m_idIndex);
+            m_pendingCallbacks = std::move(callbacks.m_pendingCallbacks);
+            m_trackers = std::move(callbacks.m_trackers);
+            m_hasReleasedTrackers = callbacks.m_hasReleasedTrackers;
+            m_metadata = std::move(callbacks.m_metadata);
+            m_nextExpiredCallbacksSweepSize = callbacks.m_nextExpiredCallbacksSweepSize;
+            m_numberOfExpiredCallbacksToCollect = callbacks.m_numberOfExpiredCallbacksToCollect;
+            m_expiredCallbacksStatistics = callbacks.m_expiredCallbacksStatistics;
+            m_numberOfCallbacks.store(callbacks.m_numberOfCallbacks.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            m_lastAssignedCallback_ID.store(callbacks.m_lastAssignedCallback_ID.load());
+
+            callbacks.reset_after_move();
+        }
+
+        return *this;
+    }
+
+
+
+public: // Public functions
+
+
+
+    // Function used to make an independent copy of the
+    // callback system (same callbacks, IDs, metadata
+    // and policies)
+    //
+    // With a copy-on-write storage (see
+    // callbacks_copy_on_write.hpp) the copy shares the
+    // callbacks until either callback system modifies
+    // them, so cloning is O(1).  Other storages copy
+    // the callbacks right away
+    //
+    // NOTE:  When called from within a callback, the
+    //        callbacks are always copied right away
+
+    BasicCallbacks clone()const
+    {
+        return BasicCallbacks(*this);
+    }
+
+
+
+    // Function used to register a callback
+    //
+    // Callbacks with a higher priority are invoked
+    // before callbacks with a lower priority, while
+    // callbacks with the same priority are invoked
+    // in the order in which they were registered
+    //
+    // NOTE:  The vector is kept sorted so that invoking
+    //        the callbacks remains a linear walk.  The
+    //        common case (registering with a priority not
+    //        higher than the last callback's) is a simple
+    //        append, otherwise only the callbacks after the
+    //        insertion point are moved (never copied)
+    //
+    // Returns the ID of the callback, or 0 if the storage
+    // of the callbacks is full (only possible when the
+    // policy selects a fixed-capacity storage)
+
+    CallbackID register_callback(CallbackFunctionType callback, int priority = 0)
+    {
+        return register_new_callback(create_callback(std::move(callback), priority, -1));
+    }
+
+
+
+    // Function used to register a callback that is
+    // automatically de-registered after it has been
+    // invoked the specified number of times
+
+    CallbackID register_callback_n_times(CallbackFunctionType callback, int numberOfInvocations, int priority = 0)
+    {
+        if(numberOfInvocations <= 0)
+            return 0;
+
+        return register_new_callback(create_callback(std::move(callback), priority, numberOfInvocations));
+    }
+
+
+
+    // Function used to register a callback that is
+    // automatically de-registered after it has been
+    // invoked once
+
+    CallbackID register_one_shot_callback(CallbackFunctionType callback, int priority = 0)
+    {
+        return register_new_callback(create_callback(std::move(callback), priority, 1));
+    }
+
+
+
+    // Function used to register a callback that stays
+    // registered for as long as the specified owner is
+    // alive (for example the object captured by the
+    // callback)
+    //
+    // Once the owner is destroyed the callback is skipped
+    // and removed in the next clean-up pass, so checking
+    // the owner costs a binary search of the trackers
+    // (kept apart from the callbacks) and a single load
+    // per invocation, and stops as soon as the owner is
+    // gone
+    //
+    // NOTE:  The owner is not locked while the callback
+    //        runs, so it must not be destroyed by another
+    //        thread while the callbacks are being invoked
+
+    CallbackID register_tracked_callback(std::weak_ptr<void> owner, CallbackFunctionType callback, int priority = 0)
+    {
+        return register_new_tracked_callback(create_callback(std::move(callback), priority, -1), std::move(owner));
+    }
+
+
+
+    // Function used to register a callback that stays
+    // registered for as long as the returned connection
+    // is alive (the callback is de-registered when the
+    // connection is destroyed or disconnected)
+
+    ScopedConnection connect(CallbackFunctionType callback, int priority = 0)
+    {
+        auto connectionToken = std::make_shared<bool>(true);
+
+        if(register_new_tracked_callback(create_callback(std::move(callback), priority, -1), connectionToken) == 0)
+            return ScopedConnection();
+
+        return ScopedConnection(std::move(connectionToken));
+    }
+
+
+
+    // Function used to register several callbacks with
+    // the same priority at once (for example all the
+    // callbacks of a subsystem starting up)
+    //
+    // Room is made for all of them up front and they are
+    // moved to their place in a single pass, instead of
+    // one insertion (and possibly one reallocation) each
+    //
+    // Returns the IDs of the callbacks in the same order,
+    // with 0 for the callbacks that didn't fit (only
+    // possible when the policy selects a fixed-capacity
+    // storage)
+    //
+    // NOTE:  If creating one of the callbacks throws, none
+    //        of them is registered
+
+    template<typename CallbackRange>
+
+    std::vector<CallbackID> register_callbacks(const CallbackRange& callbacks, int priority = 0)
+    {
+        std::vector<CallbackID> callbackIDs;
+
+        std::size_t numberOfNewCallbacks = static_cast<std::size_t>(std::distance(std::begin(callbacks), std::end(callbacks)));
+
+        callbackIDs.reserve(numberOfNewCallbacks);
+
+        // Callbacks registered from within a callback
+        // are journaled one by one
+
+        if(m_invocationDepth > 0)
+        {
+            for(const auto& callback : callbacks)
+                callbackIDs.push_back(register_callback(callback, priority));
+
+            return callbackIDs;
+        }
+
+        finish_invocation();
+
+        sweep_expired_callbacks_if_grown();
+
+        if(m_callbacks.size() + numberOfNewCallbacks > m_callbacks.max_size())
+            remove_expired_callbacks();
+
+        std::size_t numberOfCallbacksToStore = std::min(m_callbacks.size() + numberOfNewCallbacks, m_callbacks.max_size());
+
+        m_callbacks.reserve(numberOfCallbacksToStore);
+        m_idIndex.reserve(numberOfCallbacksToStore);
+
+        // The callbacks are appended, then rotated
+        // into place when they have to go before
+        // callbacks with a lower priority
+
+        std::size_t insertionIndex = static_cast<std::size_t>(find_insertion_point(priority) - m_callbacks.begin());
+        std::size_t firstNewCallbackIndex = m_callbacks.size();
+
+        try
+        {
+            for(const auto& callback : callbacks)
+            {
+                if(m_callbacks.size() >= numberOfCallbacksToStore)
+                {
+                    callbackIDs.push_back(0);
+                    continue;
+                }
+
+                CallbackType newCallback = create_callback(callback, priority, -1);
+
+                callbackIDs.push_back(newCallback.m_id);
+                m_callbacks.push_back(std::move(newCallback));
+            }
+        }
+        catch(...)
+        {
+            m_callbacks.erase(m_callbacks.begin() + firstNewCallbackIndex, m_callbacks.end());
+            throw;
+        }
+
+        if(insertionIndex == firstNewCallbackIndex)
+        {
+            for(std::size_t i = firstNewCallbackIndex; i < m_callbacks.size(); ++i)
+                m_idIndex.insert(i, m_callbacks[i].m_id);
+        }
+        else
+        {
+            std::rotate(m_callbacks.begin() + insertionIndex,
+                        m_callbacks.begin() + firstNewCallbackIndex,
+                        m_callbacks.end());
+
+            m_idIndex.rebuild(m_callbacks);
+        }
+
+        m_numberOfCallbacks.fetch_add(m_callbacks.size() - firstNewCallbackIndex, std::memory_order_relaxed);
+
+        return callbackIDs;
+    }
+
+    std::vector<CallbackID> register_callbacks(std::initializer_list<CallbackFunctionType> callbacks, int priority = 0)
+    {
+        return register_callbacks<std::initializer_list<CallbackFunctionType>>(callbacks, priority);
+    }
+
+
+
+    // Function used to de-register a callback
+    //
+    // NOTE:  When called from within a callback while the
+    //        callbacks are being invoked, the callback is
+    //        not invoked again but is only removed once
+    //        the outermost invocation finishes
+
+    bool deregister_callback(const CallbackID& callbackID)
+    {
+        // Reject right away the IDs this callback
+        // system never assigned (the others are
+        // looked up below)
+
+        if(!is_assigned_callback_id(callbackID))
+            return false;
+
+        std::size_t i = find_callback_index(callbackID);
+
+        if(i < m_callbacks.size())
+        {
+            if(m_invocationDepth > 0)
+            {
+                retire_callback(writable_callback(i));
+            }
+            else
+            {
+                forget_callback(m_callbacks[i]);
+                m_reclamation.retire(m_callbacks[i]);
+                m_reclamation.end_pass();
+                m_callbacks.erase(m_callbacks.begin() + i);
+                m_idIndex.erase(i);
+                remove_released_trackers();
+                m_numberOfCallbacks.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            return true;
+        }
+
+        for(std::size_t i = 0; i < m_pendingCallbacks.size(); ++i)
+        {
+            if(m_pendingCallbacks[i].m_id == callbackID)
+            {
+                forget_callback(m_pendingCallbacks[i]);
+                m_reclamation.retire(m_pendingCallbacks[i]);
+                m_reclamation.end_pass();
+                m_pendingCallbacks.erase(m_pendingCallbacks.begin() + i);
+                remove_released_trackers();
+                m_numberOfCallbacks.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+
+
+    // Function used to de-register several callbacks at
+    // once (for example all the callbacks of a subsystem
+    // shutting down)
+    //
+    // The IDs are sorted once and the callbacks are all
+    // removed in a single compaction pass, instead of one
+    // search and one erase each
+    //
+    // Returns the number of callbacks de-registered
+    //
+    // NOTE:  When called from within a callback while the
+    //        callbacks are being invoked, the callbacks are
+    //        not invoked again but are only removed once
+    //        the outermost invocation finishes
+
+    template<typename CallbackIDRange>
+
+    std::size_t deregister_callbacks(const CallbackIDRange& callbackIDs)
+    {
+        std::vector<CallbackID> sortedCallbackIDs;
+
+        sortedCallbackIDs.reserve(static_cast<std::size_t>(std::distance(std::begin(callbackIDs), std::end(callbackIDs))));
+
+        // Only the IDs this callback system assigned
+        // can match one of its callbacks (whether they
+        // still do is checked by the pass below)
+
+        for(CallbackID callbackID : callbackIDs)
+        {
+            if(is_assigned_callback_id(callbackID))
+                sortedCallbackIDs.push_back(callbackID);
+        }
+
+        if(sortedCallbackIDs.empty())
+            return 0;
+
+        std::sort(sortedCallbackIDs.begin(), sortedCallbackIDs.end());
+
+        auto isListed = [&](const CallbackType& callback)
+        {
+            return std::binary_search(sortedCallbackIDs.begin(), sortedCallbackIDs.end(), CallbackID(callback.m_id));
+        };
+
+        std::size_t numberOfDeregisteredCallbacks = 0;
+
+        // The callbacks are only marked as retired, and
+        // removed together by remove_retired_callbacks()
+
+        const CallbacksVectorType& callbacks = m_callbacks;
+
+        for(std::size_t i = 0; i < callbacks.size(); ++i)
+        {
+            if(callbacks[i].is_active() && isListed(callbacks[i]))
+            {
+                retire_callback(writable_callback(i));
+                ++numberOfDeregisteredCallbacks;
+            }
+        }
+
+        remove_retired_callbacks();
+
+        // The journaled callbacks are not being walked,
+        // so they are removed right away
+
+        for(auto& pendingCallback : m_pendingCallbacks)
+        {
+            if(pendingCallback.is_active() && isListed(pendingCallback))
+            {
+                forget_callback(pendingCallback);
+                m_reclamation.retire(pendingCallback);
+                pendingCallback.m_remainingInvocations = 0;
+                m_numberOfCallbacks.fetch_sub(1, std::memory_order_relaxed);
+                ++numberOfDeregisteredCallbacks;
+            }
+        }
+
+        m_reclamation.end_pass();
+
+        m_pendingCallbacks.erase(std::remove_if(m_pendingCallbacks.begin(),
+                                                m_pendingCallbacks.end(),
+                                                [](const CallbackType& callback)
+                                                {
+                                                    return !callback.is_active();
+                                                }),
+                                 m_pendingCallbacks.end());
+
+        remove_released_trackers();
+
+        return numberOfDeregisteredCallbacks;
+    }
+
+    std::size_t deregister_callbacks(std::initializer_list<CallbackID> callbackIDs)
+    {
+        return deregister_callbacks<std::initializer_list<CallbackID>>(callbackIDs);
+    }
+
+
+
+    // Function used to check in constant time whether
+    // an ID is within the range of the IDs assigned by
+    // this callback system so far
+    //
+    // NOTE:  This is only a range check, used to reject
+    //        the IDs that can't belong to this callback
+    //        system (0, or IDs assigned later by another
+    //        one).  It doesn't tell whether the callback
+    //        is still registered, which is what
+    //        is_registered_callback() checks
+
+    bool is_assigned_callback_id(CallbackID callbackID)const
+    {
+        return callbackID != 0 && callbackID <= m_lastAssignedCallback_ID.load(std::memory_order_relaxed);
+    }
+
+
+
+    // Function used to check whether a callback is
+    // registered (including the callbacks registered
+    // while invoking the callbacks, which are only
+    // added once the invocation finishes)
+    //
+    // NOTE:  Unlike is_assigned_callback_id(), it looks
+    //        the callback up (through the ID index of
+    //        the policy, if any)
+
+    bool is_registered_callback(CallbackID callbackID)const
+    {
+        if(!is_assigned_callback_id(callbackID))
+            return false;
+
+        if(find_callback_index(callbackID) < m_callbacks.size())
+            return true;
+
+        return std::any_of(m_pendingCallbacks.begin(),
+                           m_pendingCallbacks.end(),
+                           [&](const CallbackType& callback){ return callback.m_id == callbackID; });
+    }
+
+
+
+    // Function used to get the last ID assigned by this
+    // callback system (0 if none was assigned)
+
+    CallbackID get_last_assigned_callback_id()const
+    {
+        return m_lastAssignedCallback_ID.load(std::memory_order_relaxed);
+    }
+
+
+
+    // Function used to make sure that the IDs assigned
+    // from now on are greater than the specified ID (for
+    // example so that a recycled callback system never
+    // assigns again the IDs of the one it replaces)
+
+    void skip_callback_ids_up_to(CallbackID callbackID)
+    {
+        if(callbackID > m_lastAssignedCallback_ID.load(std::memory_order_relaxed))
+            m_lastAssignedCallback_ID.store(callbackID, std::memory_order_relaxed);
+    }
+
+
+
+    // Function used to de-register all callbacks
+    //
+    // NOTE:  When called from within a callback while the
+    //        callbacks are being invoked, the rest of the
+    //        callbacks are skipped and they are removed once
+    //        the outermost invocation finishes
+
+    void deregister_all_callbacks()
+    {
+        if(m_metadata)
+            m_metadata->clear();
+
+        // The retired callbacks are not invoked anymore,
+        // so their trackers can go right away
+
+        m_trackers.clear();
+        m_hasReleasedTrackers = false;
+
+        m_reclamation.retire_all(m_pendingCallbacks);
+
+        if(m_invocationDepth > 0)
+        {
+            for(std::size_t i = 0; i < m_callbacks.size(); ++i)
+                retire_callback(writable_callback(i));
+        }
+        else
+        {
+            m_reclamation.retire_all(m_callbacks);
+            m_idIndex.clear();
+            m_instrumentation.forget_all();
+            m_circuitBreaker.forget_all();
+        }
+
+        m_numberOfCallbacks.store(0, std::memory_order_relaxed);
+    }
+
+
+
+    // Function used to remove the callbacks whose tracked
+    // owner (or connection) has been destroyed without
+    // waiting for the next invocation
+    //
+    // Returns the number of callbacks that were removed
+
+    std::size_t collect_expired_callbacks()
+    {
+        std::size_t numberOfCallbacksCollectedBefore = m_expiredCallbacksStatistics.m_numberOfExpiredCallbacksCollected;
+
+        remove_expired_callbacks();
+
+        return m_expiredCallbacksStatistics.m_numberOfExpiredCallbacksCollected - numberOfCallbacksCollectedBefore;
+    }
+
+
+
+    // Function used to get the counters describing how
+    // many expired callbacks have been removed so far
+
+    const ExpiredCallbacksStatistics& get_expired_callbacks_statistics()const
+    {
+        return m_expiredCallbacksStatistics;
+    }
+
+
+
+    // Function used to get the number of registered
+    // callbacks, which is an upper bound of how many of
+    // them the next invocation will invoke: a callback
+    // whose tracked owner died is counted until the next
+    // invocation (or sweep) notices it, and a callback
+    // skipped by the circuit breaker is counted since it
+    // is still registered.  Used up one-shot callbacks
+    // and de-registered callbacks are never counted
+    //
+    // NOTE:  The counter is a relaxed atomic, so any
+    //        thread can query it without a lock (the
+    //        value might be slightly out of date if
+    //        another thread is registering callbacks)
+
+    std::size_t get_number_of_callbacks()const
+    {
+        return m_numberOfCallbacks.load(std::memory_order_relaxed);
+    }
+
+
+
+    // Function used to check whether at least one
+    // callback is registered (a single load, so that
+    // producers can skip building the arguments of
+    // an event nobody listens to)
+    //
+    // NOTE:  Like get_number_of_callbacks(), it can be
+    //        true while every registered callback is
+    //        about to be skipped (owner destroyed or
+    //        circuit open), but never false while a
+    //        callback would be invoked
+
+    bool has_callbacks()const
+    {
+        return m_numberOfCallbacks.load(std::memory_order_relaxed) != 0;
+    }
+
+
+
+    // Function used to attach metadata to a registered
+    // callback (replacing the metadata attached before)
+    //
+    // The metadata is dropped when the callback is
+    // removed, and it is never read while invoking the
+    // callbacks
+    //
+    // Returns false if no callback with that ID is
+    // registered
+
+    bool set_callback_metadata(CallbackID callbackID, CallbackMetadata metadata)
+    {
+        if(!is_registered_callback(callbackID))
+            return false;
+
+        if(!m_metadata)
+            m_metadata.reset(new MetadataVectorType());
+
+        auto entry = find_metadata_entry(callbackID);
+
+        if(entry != m_metadata->end() && entry->m_id == callbackID)
+            entry->m_metadata = std::move(metadata);
+        else
+            m_metadata->insert(entry, MetadataEntry{callbackID, std::move(metadata)});
+
+        return true;
+    }
+
+
+
+    // Function used to look up the metadata attached to
+    // a callback (returns nullptr if none was attached)
+    //
+    // NOTE:  Only the metadata array is searched (a binary
+    //        search), the callbacks aren't touched.  The
+    //        pointer is invalidated by the next change
+    //        to the callbacks or to their metadata
+
+    const CallbackMetadata* find_callback_metadata(CallbackID callbackID)const
+    {
+        if(!m_metadata)
+            return nullptr;
+
+        auto entry = find_metadata_entry(callbackID);
+
+        if(entry == m_metadata->end() || entry->m_id != callbackID)
+            return nullptr;
+
+        return &entry->m_metadata;
+    }
+
+
+
+    // Function used to list the registered callbacks in
+    // the order in which they are invoked (followed by
+    // the callbacks registered while invoking them)
+
+    std::vector<CallbackInfo> list_callbacks()const
+    {
+        std::vector<CallbackInfo> callbacks;
+
+        callbacks.reserve(m_callbacks.size() + m_pendingCallbacks.size());
+
+        for(const auto& callback : static_cast<const CallbacksVectorType&>(m_callbacks))
+        {
+            if(callback.is_active())
+                callbacks.push_back(describe_callback(callback, false));
+        }
+
+        for(const auto& callback : m_pendingCallbacks)
+            callbacks.push_back(describe_callback(callback, true));
+
+        return callbacks;
+    }
+
+
+
+    // Function used to make room for the specified number
+    // of callbacks, so that registering them doesn't
+    // allocate (nor move the callbacks already registered)
+    //
+    // NOTE:  Ignored when called from within a callback
+    //        (the callbacks can't be moved while being
+    //        invoked)
+
+    void reserve(std::size_t numberOfCallbacks)
+    {
+        if(m_invocationDepth == 0)
+        {
+            m_callbacks.reserve(numberOfCallbacks);
+            m_idIndex.reserve(numberOfCallbacks);
+        }
+    }
+
+
+
+    // Function used to get how many callbacks can be
+    // stored without allocating
+
+    std::size_t capacity()const
+    {
+        return m_callbacks.capacity();
+    }
+
+
+
+    // Function used to get the allocator of the callbacks
+
+    AllocatorType get_allocator()const
+    {
+        return AllocatorType(m_callbacks.get_allocator());
+    }
+
+
+
+    // Functions used to access the instrumentation
+    // wrapped around each callback invocation
+
+    InstrumentationType& instrumentation()
+    {
+        return m_instrumentation;
+    }
+
+    const InstrumentationType& instrumentation()const
+    {
+        return m_instrumentation;
+    }
+
+
+
+    // Functions used to access the circuit breaker
+    // deciding whether each callback is invoked
+
+    CircuitBreakerType& circuit_breaker()
+    {
+        return m_circuitBreaker;
+    }
+
+    const CircuitBreakerType& circuit_breaker()const
+    {
+        return m_circuitBreaker;
+    }
+
+
+
+    // Functions used to access the policy deciding
+    // what happens when a callback throws
+
+    ExceptionPolicyType& exception_policy()
+    {
+        return m_exceptionPolicy;
+    }
+
+    const ExceptionPolicyType& exception_policy()const
+    {
+        return m_exceptionPolicy;
+    }
+
+
+
+    // Functions used to access the policy deciding
+    // where removed callbacks are destroyed
+
+    ReclamationType& reclamation()
+    {
+        return m_reclamation;
+    }
+
+    const ReclamationType& reclamation()const
+    {
+        return m_reclamation;
+    }
+
+
+
+    // Function invoking all the callbacks
+
+    CallbackReturnType invokeCallbacks(CallbackArguments...arguments)const
+    {
+        invoke_each("invokeCallbacks", [&](const CallbackType& callback)
+        {
+            callback(arguments...);
+            return false;
+        });
+
+        return CallbackReturnType();
+    }
+
+
+
+    // Function invoking all the callbacks with the
+    // arguments built by the specified factory, which
+    // is only called if at least one callback is
+    // registered
+    //
+    // The factory returns the arguments as a tuple:
+    //
+    //     callbacks.invokeCallbacksLazily([&]
+    //     {
+    //         return std::make_tuple(formatMessage(event), event.size());
+    //     });
+
+    template<typename ArgumentsFactory>
+
+    CallbackReturnType invokeCallbacksLazily(ArgumentsFactory&& argumentsFactory)const
+    {
+        if(!has_callbacks())
+            return CallbackReturnType();
+
+        return invoke_with_tuple(argumentsFactory(), typename MakeIndexSequence<sizeof...(CallbackArguments)>::Type());
+    }
+
+
+
+    // Function invoking the callbacks until the time
+    // budget runs out
+    //
+    // The elapsed time is checked between callbacks, so
+    // at least one callback is invoked and a callback
+    // that is already running is never interrupted.  The
+    // callbacks that were not invoked can either be
+    // skipped (stop) or invoked in a later pass (defer)
+    // by passing the returned result to the function
+    // resumeCallbacksWithinBudget()
+
+    BudgetedInvocationResult invokeCallbacksWithinBudget(std::chrono::steady_clock::duration budget,
+                                                         CallbackArguments...arguments)const
+    {
+        return invoke_within_budget(nullptr, budget, arguments...);
+    }
+
+
+
+    // Function resuming an invocation that ran out of
+    // budget, starting from the callback it stopped at
+    //
+    // NOTE:  If that callback has been de-registered in
+    //        the meantime, the invocation resumes from
+    //        the next callback in priority order
+
+    BudgetedInvocationResult resumeCallbacksWithinBudget(const BudgetedInvocationResult& previousResult,
+                                                         std::chrono::steady_clock::duration budget,
+                                                         CallbackArguments...arguments)const
+    {
+        if(previousResult.m_resumeCallbackID == 0)
+            return BudgetedInvocationResult();
+
+        return invoke_within_budget(&previousResult, budget, arguments...);
+    }
+
+
+
+public: // Public operator() used to invoke all
+        // the callbacks with the specified arguments
+
+
+
+    CallbackReturnType operator()(CallbackArguments...arguments)const
+    {
+        invoke_each("operator()", [&](const CallbackType& callback)
+        {
+            callback(arguments...);
+            return false;
+        });
+
+        return CallbackReturnType();
+    }
+
+
+
+protected: // Constructor used by clone()
+
+
+
+    BasicCallbacks(const BasicCallbacks& callbacks) :
+        m_callbacks(callbacks.m_callbacks.get_allocator()),
+        m_hasRetiredCallbacks(callbacks.m_hasRetiredCallbacks),
+        m_instrumentation(callbacks.m_instrumentation),
+        m_circuitBreaker(callbacks.m_circuitBreaker),
+        m_exceptionPolicy(callbacks.m_exceptionPolicy),
+        m_reclamation(callbacks.m_reclamation),
+        m_idIndex(callbacks.m_idIndex),
+        m_pendingCallbacks(callbacks.m_pendingCallbacks.get_allocator()),
+        m_trackers(callbacks.m_trackers.get_allocator()),
+        m_hasReleasedTrackers(callbacks.m_hasReleasedTrackers),
+        m_metadata(callbacks.m_metadata ? new MetadataVectorType(*callbacks.m_metadata) : nullptr),
+        m_nextExpiredCallbacksSweepSize(callbacks.m_nextExpiredCallbacksSweepSize),
+        m_numberOfExpiredCallbacksToCollect(callbacks.m_numberOfExpiredCallbacksToCollect),
+        m_expiredCallbacksStatistics(callbacks.m_expiredCallbacksStatistics),
+        m_numberOfCallbacks(callbacks.m_numberOfCallbacks.load(std::memory_order_relaxed)),
+        m_lastAssignedCallback_ID(callbacks.m_lastAssignedCallback_ID.load())
+    {
+        // The containers are copied once they use the
+        // allocator of the original (copy-constructing
+        // them would select a default allocator, such as
+        // the default memory resource with std::pmr)
+
+        m_callbacks = callbacks.m_callbacks;
+        m_pendingCallbacks = callbacks.m_pendingCallbacks;
+        m_trackers = callbacks.m_trackers;
+
+        // The callbacks being invoked must stay where they
+        // are, so a clone made from within a callback gets
+        // its own callbacks, and the journaled changes are
+        // applied to the clone right away
+
+        if(callbacks.m_invocationDepth > 0)
+        {
+            unshare_callbacks(IsCopyOnWriteStorage<CallbacksVectorType>());
+            remove_retired_callbacks();
+            add_pending_callbacks();
+        }
+    }
+
+
+
+protected: // Protected functions
+
+
+
+    // Function used to leave a callback system that was
+    // moved from empty (but still usable)
+
+    void reset_after_move()
+    {
+        m_callbacks.clear();
+        m_idIndex.clear();
+        m_pendingCallbacks.clear();
+        m_trackers.clear();
+        m_hasRetiredCallbacks = false;
+        m_hasReleasedTrackers = false;
+        m_numberOfExpiredCallbacksToCollect = 0;
+        m_numberOfCallbacks.store(0, std::memory_order_relaxed);
+    }
+
+
+
+    // Functions used to give a copy-on-write storage
+    // its own callbacks (nothing to do for the other
+    // storages)
+
+    void unshare_callbacks(std::true_type)
+    {
+        m_callbacks.unshare();
+    }
+
+    void unshare_callbacks(std::false_type)
+    {
+    }
+
+
+
+    // Function used to get a callback in order to change
+    // its invocation state (retiring it or counting down
+    // its invocations)
+    //
+    // A copy-on-write storage whose callbacks are shared
+    // is given its own callbacks first, so that the state
+    // of the other callback systems is left untouched.
+    // Everything else reads the callbacks through a const
+    // reference, which never copies them
+
+    const CallbackType& writable_callback(std::size_t index)const
+    {
+        unshare_callbacks_while_invoking(IsCopyOnWriteStorage<CallbacksVectorType>());
+
+        return m_callbacks[index];
+    }
+
+
+
+    // Functions used to give a copy-on-write storage its
+    // own callbacks from within an invocation (the shared
+    // callbacks, which are being walked, are kept alive
+    // until the outermost invocation finishes)
+
+    void unshare_callbacks_while_invoking(std::true_type)const
+    {
+        if(!m_callbacks.is_shared())
+            return;
+
+        if(m_invocationDepth > 0 && m_pinnedCallbacks.empty())
+            m_pinnedCallbacks = m_callbacks;
+
+        m_callbacks.unshare();
+    }
+
+    void unshare_callbacks_while_invoking(std::false_type)const
+    {
+    }
+
+    void release_pinned_callbacks(std::true_type)const
+    {
+        if(!m_pinnedCallbacks.empty())
+            m_pinnedCallbacks = CallbacksVectorType();
+    }
+
+    void release_pinned_callbacks(std::false_type)const
+    {
+    }
+
+
+
+    // Function used to create a new callback with a
+    // newly assigned ID
+
+    CallbackType create_callback(CallbackFunctionType callback, int priority, int numberOfInvocations)
+    {
+        CallbackType newCallback(adopt_callback_function(std::move(callback), IsAllocatorAwareFunction<CallbackFunctionType>()));
+
+        newCallback.m_id = (++m_lastAssignedCallback_ID);
+        newCallback.m_priority = priority;
+        newCallback.m_remainingInvocations = numberOfInvocations;
+
+        return newCallback;
+    }
+
+
+
+    // Functions used to move a callable to the allocator
+    // of the callbacks (when the function type supports
+    // allocators)
+
+    CallbackFunctionType adopt_callback_function(CallbackFunctionType callback, std::true_type)const
+    {
+        return CallbackFunctionType(std::allocator_arg, get_allocator(), std::move(callback));
+    }
+
+    CallbackFunctionType adopt_callback_function(CallbackFunctionType callback, std::false_type)const
+    {
+        return callback;
+    }
+
+
+
+    // Function used to insert a new callback in the
+    // vector according to its priority
+
+    CallbackID register_new_callback(CallbackType newCallback)
+    {
+        CallbackID newCallbackID = newCallback.m_id;
+
+        // Changes journaled by an invocation that threw
+        // are applied first, so that the new callback
+        // goes after the journaled ones of its priority
+
+        if(m_invocationDepth == 0)
+            finish_invocation();
+
+        sweep_expired_callbacks_if_grown();
+
+        // Storage with a fixed capacity (see the policy)
+        // refuses new callbacks once it is full (counting
+        // the journaled callbacks, which are merged in it,
+        // and the retired ones, which can only be removed
+        // when the callbacks are not being invoked)
+
+        if(m_callbacks.size() + m_pendingCallbacks.size() >= m_callbacks.max_size())
+        {
+            remove_expired_callbacks();
+
+            if(m_callbacks.size() + m_pendingCallbacks.size() >= m_callbacks.max_size())
+                return 0;
+        }
+
+        // Callbacks registered from within a callback
+        // are journaled and only added once the
+        // outermost invocation finishes, so that the
+        // vector is never modified while being walked
+
+        if(m_invocationDepth > 0)
+        {
+            m_pendingCallbacks.push_back(std::move(newCallback));
+        }
+        else
+        {
+            auto position = m_callbacks.insert(find_insertion_point(newCallback.m_priority), std::move(newCallback));
+
+            m_idIndex.insert(static_cast<std::size_t>(position - m_callbacks.begin()), newCallbackID);
+        }
+
+        m_numberOfCallbacks.fetch_add(1, std::memory_order_relaxed);
+
+        return newCallbackID;
+    }
+
+
+
+    // Callbacks whose tracked object died are only
+    // removed when invoking the callbacks, so when
+    // the vector grows past the last clean-up size
+    // they are swept when registering too (the sweep
+    // threshold doubles, so the cost stays amortized
+    // O(1))
+
+    void sweep_expired_callbacks_if_grown()
+    {
+        if(m_invocationDepth == 0 && m_callbacks.size() >= m_nextExpiredCallbacksSweepSize)
+        {
+            remove_expired_callbacks();
+            m_nextExpiredCallbacksSweepSize = std::max<std::size_t>(2 * m_callbacks.size(), 16);
+        }
+    }
+
+
+
+    // Function used to check whether the object
+    // tracked by a callback has been destroyed (a
+    // tracked callback without a tracker had its
+    // tracker removed once its object died)
+
+    bool has_expired(const CallbackType& callback)const
+    {
+        if(!callback.m_isTracked)
+            return false;
+
+        const TrackersVectorType& trackers = m_trackers;
+
+        std::size_t i = find_tracker_index(callback.m_id);
+
+        return i == trackers.size() || trackers[i].m_owner.expired();
+    }
+
+
+
+    // Function used to mark a callback as retired so that it
+    // is skipped and removed once the invocation finishes
+
+    void retire_callback(const CallbackType& callback)const
+    {
+        if(!callback.is_active())
+            return;
+
+        callback.m_remainingInvocations = 0;
+        m_hasRetiredCallbacks = true;
+
+        m_numberOfCallbacks.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+
+
+    // Function used to retire a callback whose tracked
+    // object has been destroyed
+
+    void retire_expired_callback(const CallbackType& callback)const
+    {
+        retire_callback(callback);
+        ++m_numberOfExpiredCallbacksToCollect;
+    }
+
+
+
+    // Function used by all the invoke functions to walk
+    // the active callbacks in order
+    //
+    // The visitor is called with each callback and returns
+    // true to stop the walk.  Callbacks that use up their
+    // last invocation are only marked as retired here, they
+    // are removed in a single pass once the walk is done
+    //
+    // The invoker name identifies the public invoke function
+    // that was called (it is handed to the instrumentation)
+    //
+    // The walk can resume from a position saved by an
+    // earlier walk, and when the visitor stops the walk
+    // the position of the next active callback is saved
+    // in stopPosition (its ID is 0 if there is none)
+    //
+    // The clean-up pass runs once the outermost walk has
+    // returned.  If a callback throws, it is left to the
+    // next walk or registration (the retired callbacks
+    // are skipped until then)
+    //
+    // Returns true if the visitor stopped the walk
+
+    template<typename Visitor>
+
+    bool invoke_each(const char* invokerName,
+                     Visitor&& visitor,
+                     const BudgetedInvocationResult* resumePosition = nullptr,
+                     BudgetedInvocationResult* stopPosition = nullptr)const
+    {
+        bool stopped = false;
+
+        if(m_invocationDepth == 0)
+            finish_invocation();
+
+        {
+            InvocationGuard guard(*this);
+
+            stopped = walk_callbacks(invokerName, visitor, resumePosition, stopPosition);
+        }
+
+        if(m_invocationDepth == 0)
+            finish_invocation();
+
+        return stopped;
+    }
+
+
+
+    // Function implementing the walk of invoke_each()
+
+    template<typename Visitor>
+
+    bool walk_callbacks(const char* invokerName,
+                        Visitor& visitor,
+                        const BudgetedInvocationResult* resumePosition,
+                        BudgetedInvocationResult* stopPosition)const
+    {
+        return m_instrumentation.measure_invocation(this, invokerName, [&]
+        {
+            auto exceptionScope = m_exceptionPolicy.begin_invocation();
+
+            std::size_t firstCallbackIndex = resumePosition ? find_resume_index(*resumePosition) : 0;
+
+            const CallbacksVectorType& callbacks = m_callbacks;
+
+            auto invokeCallback = [&](std::size_t i)
+            {
+                const CallbackType* callback = &callbacks[i];
+
+                if(!callback->is_active())
+                    return false;
+
+                if(has_expired(*callback))
+                {
+                    retire_expired_callback(writable_callback(i));
+                    return false;
+                }
+
+                bool stopped = exceptionScope.invoke(callback->m_id, [&]
+                {
+                    return m_circuitBreaker.guard(callback->m_id, [&]
+                    {
+                        if(callback->m_remainingInvocations > 0)
+                        {
+                            callback = &writable_callback(i);
+
+                            if(callback->m_remainingInvocations == 1)
+                                retire_callback(*callback);
+                            else
+                                --callback->m_remainingInvocations;
+                        }
+
+                        return m_instrumentation.measure(callback->m_id, [&]{ return visitor(*callback); });
+                    });
+                });
+
+                if(stopped && stopPosition)
+                    save_resume_position(i + 1, *stopPosition);
+
+                return stopped;
+            };
+
+            bool stopped = (m_callbacks.size() <= s_unrolledInvocationSize) ?
+                           walk_unrolled<s_unrolledInvocationSize>(firstCallbackIndex, invokeCallback) :
+                           walk(firstCallbackIndex, invokeCallback);
+
+            exceptionScope.finish();
+
+            return stopped;
+        });
+    }
+
+
+
+    // Functions used to walk the callbacks from the specified
+    // index until the step function returns true
+    //
+    // The unrolled version is used when there are few enough
+    // callbacks (its loop is bounded at compile time, so the
+    // compiler unrolls it), the vector never changes size
+    // during the walk since new callbacks are journaled
+
+    template<typename StepFunction>
+
+    bool walk(std::size_t firstCallbackIndex, StepFunction& step)const
+    {
+        for(std::size_t i = firstCallbackIndex; i < m_callbacks.size(); ++i)
+        {
+            if(step(i))
+                return true;
+        }
+
+        return false;
+    }
+
+    template<std::size_t MaximumNumberOfCallbacks, typename StepFunction>
+
+    bool walk_unrolled(std::size_t firstCallbackIndex, StepFunction& step)const
+    {
+        std::size_t numberOfCallbacks = m_callbacks.size();
+
+        for(std::size_t i = firstCallbackIndex; i < MaximumNumberOfCallbacks; ++i)
+        {
+            if(i >= numberOfCallbacks)
+                return false;
+
+            if(step(i))
+                return true;
+        }
+
+        return false;
+    }
+
+
+
+    // Function used to expand the tuple of arguments
+    // built by invokeCallbacksLazily()
+
+    template<typename ArgumentsTuple, std::size_t...Indices>
+
+    CallbackReturnType invoke_with_tuple(ArgumentsTuple&& arguments, IndexSequence<Indices...>)const
+    {
+        return invokeCallbacks(std::get<Indices>(std::forward<ArgumentsTuple>(arguments))...);
+    }
+
+
+
+    // Function implementing the budgeted invocations
+
+    BudgetedInvocationResult invoke_within_budget(const BudgetedInvocationResult* resumePosition,
+                                                  std::chrono::steady_clock::duration budget,
+                                                  CallbackArguments...arguments)const
+    {
+        BudgetedInvocationResult result;
+
+        auto deadline = std::chrono::steady_clock::now() + budget;
+
+        result.m_isComplete = !invoke_each("invokeCallbacksWithinBudget", [&](const CallbackType& callback)
+        {
+            callback(arguments...);
+
+            ++result.m_numberOfCallbacksInvoked;
+
+            return std::chrono::steady_clock::now() >= deadline;
+        },
+        resumePosition,
+        &result);
+
+        // Running out of budget after the last
+        // callback still completes the invocation
+
+        if(result.m_resumeCallbackID == 0)
+            result.m_isComplete = true;
+
+        return result;
+    }
+
+
+
+    // Function used to find the index of a callback
+    // (returns the number of callbacks if not found)
+
+    std::size_t find_callback_index(CallbackID callbackID)const
+    {
+        const CallbacksVectorType& callbacks = m_callbacks;
+
+        std::size_t i = m_idIndex.find(callbacks, callbackID);
+
+        if(i < callbacks.size() && callbacks[i].is_active())
+            return i;
+
+        return callbacks.size();
+    }
+
+
+
+    // Function used to save the ID and priority of the
+    // first active callback starting from the specified
+    // index (the ID is 0 if there is none)
+
+    void save_resume_position(std::size_t firstCallbackIndex, BudgetedInvocationResult& result)const
+    {
+        const CallbacksVectorType& callbacks = m_callbacks;
+
+        for(std::size_t i = firstCallbackIndex; i < callbacks.size(); ++i)
+        {
+            if(callbacks[i].is_active() && !has_expired(callbacks[i]))
+            {
+                result.m_resumeCallbackID = callbacks[i].m_id;
+                result.m_resumePriority = callbacks[i].m_priority;
+                return;
+            }
+        }
+
+        result.m_resumeCallbackID = 0;
+    }
+
+
+
+    // Function used to find the first callback ordered at
+    // or after a saved resume position (the callbacks are
+    // sorted from highest to lowest priority, then by ID
+    // since IDs only grow, so this still finds the next
+    // callback if the saved one was de-registered)
+
+    std::size_t find_resume_index(const BudgetedInvocationResult& resumePosition)const
+    {
+        const CallbacksVectorType& callbacks = m_callbacks;
+
+        auto position = std::lower_bound(callbacks.begin(),
+                                         callbacks.end(),
+                                         resumePosition,
+                                         [](const CallbackType& callback, const BudgetedInvocationResult& position)
+                                         {
+                                             return callback.m_priority > position.m_resumePriority ||
+                                                    (callback.m_priority == position.m_resumePriority &&
+                                                     CallbackID(callback.m_id) < position.m_resumeCallbackID);
+                                         });
+
+        return static_cast<std::size_t>(position - callbacks.begin());
+    }
+
+
+
+    // Function used to remove all the retired callbacks
+    // in a single pass
+
+    void remove_retired_callbacks()const
+    {
+        if(!m_hasRetiredCallbacks || m_invocationDepth > 0)
+            return;
+
+        for(auto& callback : m_callbacks)
+        {
+            if(!callback.is_active())
+            {
+                forget_callback(callback);
+                m_reclamation.retire(callback);
+            }
+        }
+
+        m_reclamation.end_pass();
+
+        m_callbacks.erase(std::remove_if(m_callbacks.begin(),
+                                         m_callbacks.end(),
+                                         [](const CallbackType& callback)
+                                         {
+                                             return !callback.is_active();
+                                         }),
+                          m_callbacks.end());
+
+        m_idIndex.rebuild(m_callbacks);
+
+        remove_released_trackers();
+
+        m_hasRetiredCallbacks = false;
+
+        if(m_numberOfExpiredCallbacksToCollect > 0)
+        {
+            m_expiredCallbacksStatistics.m_numberOfExpiredCallbacksCollected += m_numberOfExpiredCallbacksToCollect;
+            ++m_expiredCallbacksStatistics.m_numberOfSweeps;
+
+            m_numberOfExpiredCallbacksToCollect = 0;
+        }
+    }
+
+
+
+    // Function used to remove all the callbacks whose
+    // tracked object has been destroyed in a single pass
+
+    void remove_expired_callbacks()const
+    {
+        const CallbacksVectorType& callbacks = m_callbacks;
+
+        for(std::size_t i = 0; i < callbacks.size(); ++i)
+        {
+            if(callbacks[i].is_active() && has_expired(callbacks[i]))
+                retire_expired_callback(writable_callback(i));
+        }
+
+        remove_retired_callbacks();
+    }
+
+
+
+    // Function used to apply the journaled changes once
+    // the outermost invocation has returned (or before
+    // the next invocation or registration, when a
+    // callback threw)
+
+    void finish_invocation()const
+    {
+        release_pinned_callbacks(IsCopyOnWriteStorage<CallbacksVectorType>());
+        remove_retired_callbacks();
+        add_pending_callbacks();
+    }
+
+
+
+    // Function used to add the callbacks that were
+    // registered while the callbacks were being invoked
+    //
+    // If running out of memory, the callbacks that were
+    // not added yet stay journaled for the next pass
+
+    void add_pending_callbacks()const
+    {
+        if(m_pendingCallbacks.empty())
+            return;
+
+        std::size_t numberOfAddedCallbacks = 0;
+
+        try
+        {
+            for(auto& pendingCallback : m_pendingCallbacks)
+            {
+                int priority = pendingCallback.m_priority;
+
+                m_callbacks.insert(find_insertion_point(priority), std::move(pendingCallback));
+
+                ++numberOfAddedCallbacks;
+            }
+        }
+        catch(...)
+        {
+            m_pendingCallbacks.erase(m_pendingCallbacks.begin(), m_pendingCallbacks.begin() + numberOfAddedCallbacks);
+            m_idIndex.rebuild(m_callbacks);
+            throw;
+        }
+
+        m_pendingCallbacks.clear();
+
+        m_idIndex.rebuild(m_callbacks);
+    }
+
+
+
+protected: // Protected classes
+
+
+
+    // Entry of the metadata array (sorted by callback ID)
+
+    struct MetadataEntry
+    {
+        CallbackID                      m_id;
+        CallbackMetadata                m_metadata;
+    };
+
+    using MetadataVectorType = std::vector<MetadataEntry>;
+
+
+
+    // Entry of the trackers array (sorted by callback
+    // ID, stored like the callbacks so that tracking a
+    // callback allocates only if they do)
+
+    struct TrackerEntry
+    {
+        CallbackID                      m_id;
+        std::weak_ptr<void>             m_owner;
+    };
+
+    using TrackerAllocatorType = typename std::allocator_traits<AllocatorType>::template rebind_alloc<TrackerEntry>;
+    using TrackersVectorType = typename CallbacksPolicy::template StorageType<TrackerEntry,TrackerAllocatorType>;
+
+
+
+    // Type keeping the shared callbacks alive while they
+    // are walked (only used by copy-on-write storages)
+
+    struct NoPinnedCallbacks
+    {
+    };
+
+    using PinnedCallbacksType = typename std::conditional<IsCopyOnWriteStorage<CallbacksVectorType>::value,
+                                                          CallbacksVectorType,
+                                                          NoPinnedCallbacks>::type;
+
+
+
+    // Helper used to track how deeply nested the current
+    // invocation is (callbacks can invoke the callbacks
+    // again), also when a callback throws
+
+    class InvocationGuard
+    {
+    public:
+
+        InvocationGuard(const BasicCallbacks& callbacks) : m_callbacks(callbacks)
+        {
+            ++m_callbacks.m_invocationDepth;
+        }
+
+        ~InvocationGuard()
+        {
+            --m_callbacks.m_invocationDepth;
+        }
+
+    private:
+
+        const BasicCallbacks&           m_callbacks;
+    };
+
+
+
+protected: // Protected functions
+
+
+
+    // Function used to find the metadata entry of a
+    // callback, or where it should be inserted
+
+    typename MetadataVectorType::iterator find_metadata_entry(CallbackID callbackID)const
+    {
+        return std::lower_bound(m_metadata->begin(),
+                                m_metadata->end(),
+                                callbackID,
+                                [](const MetadataEntry& entry, CallbackID id)
+                                {
+                                    return entry.m_id < id;
+                                });
+    }
+
+
+
+    // Function used to drop what is kept about a callback
+    // that is being removed (its metadata, its tracker,
+    // what the instrumentation measured and its circuit)
+
+    void forget_callback(const CallbackType& callback)const
+    {
+        CallbackID callbackID = callback.m_id;
+
+        erase_callback_metadata(callbackID);
+
+        if(callback.m_isTracked)
+            release_callback_tracker(callbackID);
+
+        m_instrumentation.forget(callbackID);
+        m_circuitBreaker.forget(callbackID);
+    }
+
+
+
+    // Function used to register a new callback tracking
+    // the specified owner
+    //
+    // The tracker is appended once the callback is
+    // registered (IDs only grow, so the trackers stay
+    // sorted), and the callback is de-registered again
+    // if that fails
+
+    CallbackID register_new_tracked_callback(CallbackType newCallback, std::weak_ptr<void> owner)
+    {
+        newCallback.m_isTracked = true;
+
+        CallbackID newCallbackID = register_new_callback(std::move(newCallback));
+
+        if(newCallbackID == 0)
+            return 0;
+
+        try
+        {
+            m_trackers.push_back(TrackerEntry{newCallbackID, std::move(owner)});
+        }
+        catch(...)
+        {
+            deregister_callback(newCallbackID);
+            throw;
+        }
+
+        return newCallbackID;
+    }
+
+
+
+    // Function used to find the index of the tracker of
+    // a callback (the number of trackers if it has none)
+
+    std::size_t find_tracker_index(CallbackID callbackID)const
+    {
+        const TrackersVectorType& trackers = m_trackers;
+
+        auto entry = std::lower_bound(trackers.begin(),
+                                      trackers.end(),
+                                      callbackID,
+                                      [](const TrackerEntry& entry, CallbackID id)
+                                      {
+                                          return entry.m_id < id;
+                                      });
+
+        if(entry == trackers.end() || entry->m_id != callbackID)
+            return trackers.size();
+
+        return static_cast<std::size_t>(entry - trackers.begin());
+    }
+
+
+
+    // Function used to release the tracker of a callback
+    // that is being removed (the released trackers are
+    // removed together by remove_released_trackers())
+
+    void release_callback_tracker(CallbackID callbackID)const
+    {
+        std::size_t i = find_tracker_index(callbackID);
+
+        if(i < m_trackers.size())
+        {
+            m_trackers[i].m_owner.reset();
+            m_hasReleasedTrackers = true;
+        }
+    }
+
+
+
+    // Function used to remove the released trackers in a
+    // single pass (along with the trackers whose object
+    // died, whose callbacks count as expired anyway)
+
+    void remove_released_trackers()const
+    {
+        if(!m_hasReleasedTrackers)
+            return;
+
+        m_trackers.erase(std::remove_if(m_trackers.begin(),
+                                        m_trackers.end(),
+                                        [](const TrackerEntry& entry)
+                                        {
+                                            return entry.m_owner.expired();
+                                        }),
+                         m_trackers.end());
+
+        m_hasReleasedTrackers = false;
+    }
+
+
+
+    // Function used to drop the metadata of a callback
+    // that is being removed (nothing to do unless some
+    // metadata was attached)
+
+    void erase_callback_metadata(CallbackID callbackID)const
+    {
+        if(!m_metadata || m_metadata->empty())
+            return;
+
+        auto entry = find_metadata_entry(callbackID);
+
+        if(entry != m_metadata->end() && entry->m_id == callbackID)
+            m_metadata->erase(entry);
+    }
+
+
+
+    // Function used to describe a callback for list_callbacks()
+
+    CallbackInfo describe_callback(const CallbackType& callback, bool isPending)const
+    {
+        CallbackInfo info;
+
+        info.m_id = callback.m_id;
+        info.m_priority = callback.m_priority;
+        info.m_remainingInvocations = callback.m_remainingInvocations;
+        info.m_isTracked = callback.m_isTracked;
+        info.m_isPending = isPending;
+
+        if(const CallbackMetadata* metadata = find_callback_metadata(callback.m_id))
+            info.m_metadata = *metadata;
+
+        return info;
+    }
+
+
+
+    // Function used to find where a callback with the
+    // specified priority should be inserted so that the
+    // vector stays sorted from highest to lowest priority
+    // and stable within callbacks of equal priority
+
+    typename CallbacksVectorType::iterator find_insertion_point(int priority)const
+    {
+        if(m_callbacks.empty() || m_callbacks.back().m_priority >= priority)
+            return m_callbacks.end();
+
+        return std::upper_bound(m_callbacks.begin(),
+                                m_callbacks.end(),
+                                priority,
+                                [](int newPriority, const CallbackType& callback)
+                                {
+                                    return newPriority > callback.m_priority;
+                                });
+    }
+
+
+
+protected: // Protected variables
+
+
+
+    // The vector holding the callbacks
+    // that have been added (sorted from
+    // highest to lowest priority)
+    //
+    // NOTE:  It is mutable because callbacks
+    //        that use up their invocations
+    //        are removed after being invoked
+
+    mutable CallbacksVectorType         m_callbacks;
+
+
+
+    // Flag set when at least one callback has
+    // been retired during an invocation
+
+    mutable bool                        m_hasRetiredCallbacks = false;
+
+
+
+    // The shared callbacks a copy-on-write storage was
+    // walking when it got its own callbacks, kept until
+    // the outermost invocation finishes (nothing for the
+    // other storages)
+
+    mutable PinnedCallbacksType         m_pinnedCallbacks;
+
+
+
+    // The instrumentation wrapped around each
+    // callback invocation (empty by default)
+
+    mutable InstrumentationType         m_instrumentation;
+
+
+
+    // The circuit breaker deciding whether each
+    // callback is invoked (empty by default)
+
+    mutable CircuitBreakerType          m_circuitBreaker;
+
+
+
+    // The policy deciding what happens when a
+    // callback throws (propagate by default)
+
+    mutable ExceptionPolicyType         m_exceptionPolicy;
+
+
+
+    // The policy deciding where removed callbacks
+    // are destroyed (right away by default)
+
+    mutable ReclamationType             m_reclamation;
+
+
+
+    // The index used to find a callback from its ID
+    // (kept in the same order as the callbacks)
+
+    mutable IdIndexType                 m_idIndex;
+
+
+
+    // The callbacks registered from within a callback
+    // while the callbacks were being invoked (they are
+    // added once the outermost invocation finishes)
+
+    mutable CallbacksVectorType         m_pendingCallbacks;
+
+
+
+    // The objects tracked by the tracked callbacks
+    // (including the pending ones), kept apart from
+    // the callbacks so that the untracked ones stay
+    // small
+
+    mutable TrackersVectorType          m_trackers;
+
+
+
+    // Whether some trackers were released but not
+    // yet removed from the trackers
+
+    mutable bool                        m_hasReleasedTrackers = false;
+
+
+
+    // The metadata attached to the callbacks, kept
+    // apart from them so that the callbacks stay small
+    // and invoking them never loads it (only allocated
+    // once some metadata is attached)
+
+    std::unique_ptr<MetadataVectorType> m_metadata;
+
+
+
+    // How many invocations are currently running
+    // (greater than one when callbacks invoke the
+    // callbacks again), not atomic since a callback
+    // system is invoked by one thread at a time
+
+    mutable int                         m_invocationDepth = 0;
+
+
+
+    // Size the vector has to reach before the callbacks
+    // whose tracked object died are swept when registering
+
+    std::size_t                         m_nextExpiredCallbacksSweepSize = 16;
+
+
+
+    // Number of expired callbacks retired but
+    // not yet removed from the vector
+
+    mutable std::size_t                 m_numberOfExpiredCallbacksToCollect = 0;
+
+
+
+    // Counters of the expired callbacks
+    // removed so far
+
+    mutable ExpiredCallbacksStatistics  m_expiredCallbacksStatistics;
+
+
+
+    // Number of registered callbacks that are still
+    // active (including the pending ones), so that
+    // checking for subscribers is a single load
+
+    mutable std::atomic<std::size_t>    m_numberOfCallbacks{0};
+
+
+
+    // The ID used to identify each
+    // added callback to allow users
+    // to de-register them at a later
+    // time
+    //
+    // NOTE:  It is made atomic to allow
+    //        multiple threads to register
+    //        callbacks while being assigned
+    //        a unique id (it starts at 0, so
+    //        the first ID is 1, see CallbackID)
+
+    std::atomic<CallbackID>             m_lastAssignedCallback_ID{0};
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// The callback system with the default policy
+//-------------------------------------------------------------------
+template<typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using Callbacks = BasicCallbacks<DefaultCallbacksPolicy,CallbackReturnType,CallbackArguments...>;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Specialization that invokes the callbacks but returns as soon as
+// one of them returns a non-empty container
+//
+// This specialization assumes the return type is a container that
+// defines the empty() member function
+//
+// Callbacks are invoked sequentially until one of them returns a
+// non-empty container
+//-------------------------------------------------------------------
+template<typename CallbacksPolicy,
+         typename CallbackReturnType,
+         typename...CallbackArguments>
+
+class BasicCallbacksReturningAContainer : public BasicCallbacks<CallbacksPolicy,CallbackReturnType,CallbackArguments...>
+{
+public: // Public typedefs
+
+
+
+    using CallbackType = typename BasicCallbacks<CallbacksPolicy,CallbackReturnType,CallbackArguments...>::CallbackType;
+
+
+
+public: // Constructors and destructor
+
+
+
+    // Default constructor
+
+    BasicCallbacksReturningAContainer() : BasicCallbacks<CallbacksPolicy,CallbackReturnType,CallbackArguments...> (){}
+
+
+
+    // Constructor taking the allocator of the callbacks
+
+    explicit BasicCallbacksReturningAContainer(const typename BasicCallbacks<CallbacksPolicy,CallbackReturnType,CallbackArguments...>::AllocatorType& allocator) :
+        BasicCallbacks<CallbacksPolicy,CallbackReturnType,CallbackArguments...> (allocator)
+    {
+    }
+
+
+
+    // Destructor
+
+    ~BasicCallbacksReturningAContainer(){}
+
+
+
+    // Callback systems can be moved, and copied
+    // with clone() (see BasicCallbacks)
+
+    BasicCallbacksReturningAContainer(BasicCallbacksReturningAContainer&& callbacks) = default;
+    BasicCallbacksReturningAContainer& operator=(BasicCallbacksReturningAContainer&& callbacks) = default;
+
+
+
+public: // Public functions
+
+
+
+    BasicCallbacksReturningAContainer clone()const
+    {
+        return BasicCallbacksReturningAContainer(*this);
+    }
+
+
+
+    // Function invoking all the callbacks but
+    // returning as soon as a callback returns
+    // a non-empty container
+
+    CallbackReturnType invokeCallbacksUntilOneOfThemReturnsANonEmptyContainer(CallbackArguments...arguments)const
+    {
+        CallbackReturnType callbackReturn;
+
+        this->invoke_each("invokeCallbacksUntilOneOfThemReturnsANonEmptyContainer", [&](const CallbackType& callback)
+        {
+            callbackReturn = callback(arguments...);
+
+            return !callbackReturn.empty();
+        });
+
+        return callbackReturn;
+    }
+
+
+
+protected: // Constructor used by clone()
+
+
+
+    BasicCallbacksReturningAContainer(const BasicCallbacksReturningAContainer& callbacks) = default;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// The callback system returning a container with the default policy
+//-------------------------------------------------------------------
+template<typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using CallbacksReturningAContainer = BasicCallbacksReturningAContainer<DefaultCallbacksPolicy,CallbackReturnType,CallbackArguments...>;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Specialization that invokes the callbacks but returns as soon as
+// one of them returns a non-zero value (like a boolean true)
+//
+// This specialization assumes the return type can be checked like
+// a boolean in an if-statement
+//-------------------------------------------------------------------
+template<typename CallbacksPolicy,
+         typename...CallbackArguments>
+
+class BasicCallbacksReturningABoolean : public BasicCallbacks<CallbacksPolicy,bool,CallbackArguments...>
+{
+public: // Public typedefs
+
+
+
+    using CallbackFunctionType = typename BasicCallbacks<CallbacksPolicy,bool,CallbackArguments...>::CallbackFunctionType;
+    using CallbackType = typename BasicCallbacks<CallbacksPolicy,bool,CallbackArguments...>::CallbackType;
+
+
+
+public: // Constructors and destructor
+
+
+
+    // Default constructor
+
+    BasicCallbacksReturningABoolean() : BasicCallbacks<CallbacksPolicy,bool,CallbackArguments...> (){}
+
+
+
+    // Constructor taking the allocator of the callbacks
+
+    explicit BasicCallbacksReturningABoolean(const typename BasicCallbacks<CallbacksPolicy,bool,CallbackArguments...>::AllocatorType& allocator) :
+        BasicCallbacks<CallbacksPolicy,bool,CallbackArguments...> (allocator)
+    {
+    }
+
+
+
+    // Destructor
+
+    ~BasicCallbacksReturningABoolean(){}
+
+
+
+    // Callback systems can be moved, and copied
+    // with clone() (see BasicCallbacks)
+
+    BasicCallbacksReturningABoolean(BasicCallbacksReturningABoolean&& callbacks) = default;
+    BasicCallbacksReturningABoolean& operator=(BasicCallbacksReturningABoolean&& callbacks) = default;
+
+
+
+public: // Public functions
+
+
+
+    BasicCallbacksReturningABoolean clone()const
+    {
+        return BasicCallbacksReturningABoolean(*this);
+    }
+
+
+
+    // Function invoking all the callbacks but
+    // returning as soon as a callback returns
+    // a non-zero value (like a boolean true)
+
+    bool invokeCallbacksUntilOneOfThemReturnsANonZeroValue(CallbackArguments...arguments)const
+    {
+        return this->invoke_each("invokeCallbacksUntilOneOfThemReturnsANonZeroValue", [&](const CallbackType& callback)
+        {
+            return static_cast<bool>(callback(arguments...));
+        });
+    }
+
+
+
+protected: // Constructor used by clone()
+
+
+
+    BasicCallbacksReturningABoolean(const BasicCallbacksReturningABoolean& callbacks) = default;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// The callback system returning a boolean with the default policy
+//-------------------------------------------------------------------
+template<typename...CallbackArguments>
+
+using CallbacksReturningABoolean = BasicCallbacksReturningABoolean<DefaultCallbacksPolicy,CallbackArguments...>;
+//-------------------------------------------------------------------
+
+
+
 //-------------------------------------------------------------------
 // End of CallbacksLIB namespace
 //-------------------------------------------------------------------
@@ -0,0 +1,108 @@
+#ifndef CALLBACKS_ALLOCATOR_HPP
+#define CALLBACKS_ALLOCATOR_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Policies making the callback systems defined in callbacks.hpp take both
+/// the vector of callbacks and the state of the callables from a custom
+/// allocator
+///
+/// -- Any standard allocator can be used:
+///
+///        BasicCallbacks<AllocatorCallbacksPolicy<ArenaAllocator<char>>,void,int> callbacks(arenaAllocator);
+///
+/// -- With C++17, PmrCallbacksPolicy uses std::pmr::polymorphic_allocator so
+///    that each callback system can get its memory from its own memory
+///    resource (for example a monotonic buffer), keeping the callbacks and
+///    their state close together instead of scattered across the heap:
+///
+///        std::pmr::monotonic_buffer_resource arena;
+///
+///        BasicCallbacks<PmrCallbacksPolicy,void,int> callbacks(&arena);
+///
+/// -- The callables are stored in a CallbackFunction (see
+///    callbacks_function.hpp) instead of a std::function, which keeps small
+///    callables inline and allocates the others with the allocator of the
+///    callback system
+///
+///
+///
+/// Note: This class is defined within the namespace CallbacksLIB
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+#include "callbacks_function.hpp"
+
+#include <memory>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define CALLBACKS_HAS_PMR 1
+#endif
+#endif
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Classes are defined within the namespace CallbacksLIB
+//-------------------------------------------------------------------
+namespace CallbacksLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Policy taking the callbacks and the state of the callables from
+// the specified allocator
+//-------------------------------------------------------------------
+template<typename Allocator>
+
+struct AllocatorCallbacksPolicy : DefaultCallbacksPolicy
+{
+    using AllocatorType = Allocator;
+
+    template<typename Signature>
+
+    using FunctionType = CallbackFunction<Signature,Allocator>;
+};
+//-------------------------------------------------------------------
+
+
+
+#ifdef CALLBACKS_HAS_PMR
+//-------------------------------------------------------------------
+// Policy taking the callbacks and the state of the callables from
+// a std::pmr::memory_resource
+//-------------------------------------------------------------------
+using PmrCallbacksPolicy = AllocatorCallbacksPolicy<std::pmr::polymorphic_allocator<char>>;
+//-------------------------------------------------------------------
+#endif
+
+
+
+//-------------------------------------------------------------------
+// End of CallbacksLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // CALLBACKS_ALLOCATOR_HPP
@@ -0,0 +1,373 @@
+#ifndef CALLBACKS_CIRCUIT_BREAKER_HPP
+#define CALLBACKS_CIRCUIT_BREAKER_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Optional circuit breaker for the callback systems defined in
+/// callbacks.hpp, which disables the callbacks that keep failing (throwing
+/// or exceeding a latency threshold) and probes them again later
+///
+/// -- The circuit breaker is selected through the policy of the callback
+///    system:
+///
+///        BasicCallbacks<CircuitBreakerCallbacksPolicy,void,int> callbacks;
+///
+///        callbacks.circuit_breaker().set_failure_threshold(5);
+///        callbacks.circuit_breaker().set_latency_threshold(std::chrono::milliseconds(1));
+///        callbacks.circuit_breaker().set_backoff(std::chrono::seconds(1), std::chrono::minutes(1));
+///
+/// -- Each callback ID goes through the usual circuit breaker states:
+///
+///    1.  Closed:     The callback is invoked.  After the configured number
+///                    of consecutive failures the circuit trips (opens)
+///
+///    2.  Open:       The callback is skipped until the back-off interval
+///                    has elapsed
+///
+///    3.  Half-open:  The callback is invoked once as a probe.  If the probe
+///                    succeeds the circuit closes again, otherwise it opens
+///                    again with a back-off interval twice as long (up to
+///                    the configured maximum)
+///
+/// -- Exceptions thrown by a callback are counted as failures and then
+///    propagated as usual
+///
+/// -- The state of each callback is only touched by the thread invoking
+///    the callbacks, so the circuit breaker doesn't take any lock
+///
+/// -- A callback only gets a circuit once it fails, and its circuit is
+///    dropped when the callback is removed from the callback system
+///
+///
+///
+/// Note: This class is defined within the namespace CallbacksLIB
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Classes are defined within the namespace CallbacksLIB
+//-------------------------------------------------------------------
+namespace CallbacksLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// The states of a circuit
+//-------------------------------------------------------------------
+enum class CircuitState
+{
+    Closed,
+    Open,
+    HalfOpen
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Circuit breaker tracking the consecutive failures of each
+// callback ID
+//-------------------------------------------------------------------
+class CircuitBreaker
+{
+public: // Public typedefs
+
+
+
+    using ClockType = std::chrono::steady_clock;
+
+
+
+public: // Configuration functions
+
+
+
+    // Function used to set how many consecutive failures
+    // trip the circuit of a callback (at least one)
+
+    void set_failure_threshold(std::uint32_t failureThreshold)
+    {
+        m_failureThreshold = (failureThreshold > 0) ? failureThreshold : 1;
+    }
+
+
+
+    // Function used to set how long an invocation can take
+    // before it counts as a failure (zero disables the
+    // latency check, which also avoids reading the clock
+    // around each invocation)
+
+    void set_latency_threshold(ClockType::duration latencyThreshold)
+    {
+        m_latencyThreshold = latencyThreshold;
+    }
+
+
+
+    // Function used to set how long a tripped callback is
+    // skipped before being probed again (the interval doubles
+    // after each failed probe, up to the maximum)
+
+    void set_backoff(ClockType::duration initialBackoff, ClockType::duration maximumBackoff)
+    {
+        m_initialBackoff = initialBackoff;
+        m_maximumBackoff = (maximumBackoff > initialBackoff) ? maximumBackoff : initialBackoff;
+    }
+
+
+
+public: // Public functions
+
+
+
+    // Function wrapped around each callback invocation
+
+    template<typename InvokeFunction>
+
+    bool guard(CallbackID callbackID, InvokeFunction&& invokeFunction)
+    {
+        auto existingCircuit = m_circuits.find(callbackID);
+
+        Circuit* circuit = (existingCircuit != m_circuits.end()) ? &existingCircuit->second : nullptr;
+
+        if(circuit && circuit->m_state == CircuitState::Open)
+        {
+            if(ClockType::now() < circuit->m_probeTime)
+                return false;
+
+            circuit->m_state = CircuitState::HalfOpen;
+        }
+
+        bool isLatencyChecked = m_latencyThreshold > ClockType::duration::zero();
+
+        ClockType::time_point startTime = isLatencyChecked ? ClockType::now() : ClockType::time_point();
+
+        bool stop = false;
+
+        // The circuit is looked up again once the callback
+        // returns, since the callback may have destroyed it
+        // (by resetting its circuit, or all of them)
+
+        try
+        {
+            stop = invokeFunction();
+        }
+        catch(...)
+        {
+            record_failure(m_circuits[callbackID]);
+            throw;
+        }
+
+        if(isLatencyChecked && ClockType::now() - startTime > m_latencyThreshold)
+        {
+            record_failure(m_circuits[callbackID]);
+        }
+        else
+        {
+            existingCircuit = m_circuits.find(callbackID);
+
+            if(existingCircuit != m_circuits.end())
+                record_success(existingCircuit->second);
+        }
+
+        return stop;
+    }
+
+
+
+    // Function used to get the state of the circuit
+    // of a callback
+
+    CircuitState get_state(CallbackID callbackID)const
+    {
+        auto circuit = m_circuits.find(callbackID);
+
+        return (circuit == m_circuits.end()) ? CircuitState::Closed : circuit->second.m_state;
+    }
+
+
+
+    // Function used to get the IDs of the callbacks
+    // whose circuit is currently open
+
+    std::vector<CallbackID> get_tripped_callbacks()const
+    {
+        std::vector<CallbackID> trippedCallbacks;
+
+        for(const auto& circuit : m_circuits)
+        {
+            if(circuit.second.m_state != CircuitState::Closed)
+                trippedCallbacks.push_back(circuit.first);
+        }
+
+        return trippedCallbacks;
+    }
+
+
+
+    // Function used to get how many times the circuit
+    // of a callback tripped
+
+    std::uint64_t get_number_of_trips(CallbackID callbackID)const
+    {
+        auto circuit = m_circuits.find(callbackID);
+
+        return (circuit == m_circuits.end()) ? 0 : circuit->second.m_numberOfTrips;
+    }
+
+
+
+    // Function used to close the circuit of a callback
+    // (for example once the cause of the failures has
+    // been fixed)
+
+    void reset(CallbackID callbackID)
+    {
+        m_circuits.erase(callbackID);
+    }
+
+
+
+    // Function used to close all the circuits
+
+    void reset()
+    {
+        m_circuits.clear();
+    }
+
+
+
+    // Functions called when a callback is removed from the
+    // callback system, or when all of them are removed
+
+    void forget(CallbackID callbackID)
+    {
+        m_circuits.erase(callbackID);
+    }
+
+    void forget_all()
+    {
+        m_circuits.clear();
+    }
+
+
+
+private: // Private classes
+
+
+
+    // The state of the circuit of a callback
+
+    struct Circuit
+    {
+        CircuitState                    m_state = CircuitState::Closed;
+        std::uint32_t                   m_numberOfConsecutiveFailures = 0;
+        std::uint64_t                   m_numberOfTrips = 0;
+        ClockType::duration             m_backoff = ClockType::duration::zero();
+        ClockType::time_point           m_probeTime;
+    };
+
+
+
+private: // Private functions
+
+
+
+    void record_success(Circuit& circuit)
+    {
+        circuit.m_state = CircuitState::Closed;
+        circuit.m_numberOfConsecutiveFailures = 0;
+        circuit.m_backoff = ClockType::duration::zero();
+    }
+
+
+
+    void record_failure(Circuit& circuit)
+    {
+        ++circuit.m_numberOfConsecutiveFailures;
+
+        if(circuit.m_state != CircuitState::HalfOpen && circuit.m_numberOfConsecutiveFailures < m_failureThreshold)
+            return;
+
+        // Trip the circuit (a failed probe
+        // doubles the back-off interval)
+
+        if(circuit.m_state == CircuitState::HalfOpen && circuit.m_backoff > ClockType::duration::zero())
+            circuit.m_backoff = (circuit.m_backoff < m_maximumBackoff / 2) ? circuit.m_backoff * 2 : m_maximumBackoff;
+        else
+            circuit.m_backoff = m_initialBackoff;
+
+        circuit.m_state = CircuitState::Open;
+        circuit.m_probeTime = ClockType::now() + circuit.m_backoff;
+
+        ++circuit.m_numberOfTrips;
+    }
+
+
+
+private: // Private variables
+
+
+
+    // Configuration
+
+    std::uint32_t                       m_failureThreshold = 3;
+    ClockType::duration                 m_latencyThreshold = ClockType::duration::zero();
+    ClockType::duration                 m_initialBackoff = std::chrono::seconds(1);
+    ClockType::duration                 m_maximumBackoff = std::chrono::seconds(60);
+
+
+
+    // The circuit of each callback that has failed
+
+    std::unordered_map<CallbackID,Circuit> m_circuits;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Policy enabling the circuit breaker
+//-------------------------------------------------------------------
+struct CircuitBreakerCallbacksPolicy : DefaultCallbacksPolicy
+{
+    using CircuitBreakerType = CircuitBreaker;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of CallbacksLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // CALLBACKS_CIRCUIT_BREAKER_HPP
@@ -0,0 +1,442 @@
+#ifndef CALLBACKS_COMPACT_HPP
+#define CALLBACKS_COMPACT_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Compact version of the callback systems defined in callbacks.hpp, meant
+/// for objects that embed a callback system but almost never have any
+/// callback registered
+///
+/// -- A compact callback system is a single pointer, which stays null until
+///    the first callback is registered.  The full callback system is only
+///    allocated at that point:
+///
+///        class Particle
+///        {
+///        public:
+///
+///            CallbacksLIB::CompactCallbacks<void,const Particle&> m_onCollision;
+///        };
+///
+/// -- Invoking a compact callback system without any callback registered
+///    costs a single null check
+///
+/// -- Once allocated, the callback system is kept (even if all callbacks
+///    are de-registered) because it might still be invoking its callbacks
+///
+/// -- It provides the same functions as the wrapped callback system, and
+///    the wrapped callback system can be accessed with registry() to reach
+///    its other functions (instrumentation and so on)
+///
+///
+///
+/// Note: This class is defined within the namespace CallbacksLIB
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+
+#include <chrono>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Classes are defined within the namespace CallbacksLIB
+//-------------------------------------------------------------------
+namespace CallbacksLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Callback system allocated on first registration, wrapping any of
+// the callback systems defined in callbacks.hpp
+//-------------------------------------------------------------------
+template<typename CallbacksType>
+
+class BasicCompactCallbacks
+{
+public: // Public typedefs
+
+
+
+    using RegistryType = CallbacksType;
+    using CallbackFunctionType = typename CallbacksType::CallbackFunctionType;
+
+
+
+public: // Constructors and destructor
+
+
+
+    // Default constructor (doesn't allocate)
+
+    BasicCompactCallbacks(){}
+
+
+
+    // Destructor
+
+    ~BasicCompactCallbacks(){}
+
+
+
+    // Compact callback systems can be moved (the
+    // wrapped callback system stays where it is),
+    // but they must not be moved while invoking
+    // their callbacks
+
+    BasicCompactCallbacks(BasicCompactCallbacks&& compactCallbacks) = default;
+    BasicCompactCallbacks& operator=(BasicCompactCallbacks&& compactCallbacks) = default;
+
+
+
+private: // Private typedefs
+
+
+
+    // The wrapped callback system as a type depending on
+    // the arguments of the invoke functions, so that only
+    // the invoke functions that are actually called need
+    // to exist in the wrapped callback system
+
+    template<typename...Arguments>
+
+    struct DependentRegistry
+    {
+        using Type = CallbacksType;
+    };
+
+    template<typename...Arguments>
+
+    using DependentRegistryType = typename DependentRegistry<Arguments...>::Type;
+
+
+
+public: // Public functions
+
+
+
+    // Functions used to register callbacks (see
+    // the functions of the same name defined by
+    // the wrapped callback system)
+
+    CallbackID register_callback(CallbackFunctionType callback, int priority = 0)
+    {
+        return registry().register_callback(std::move(callback), priority);
+    }
+
+    CallbackID register_callback_n_times(CallbackFunctionType callback, int numberOfInvocations, int priority = 0)
+    {
+        if(numberOfInvocations <= 0)
+            return 0;
+
+        return registry().register_callback_n_times(std::move(callback), numberOfInvocations, priority);
+    }
+
+    CallbackID register_one_shot_callback(CallbackFunctionType callback, int priority = 0)
+    {
+        return registry().register_one_shot_callback(std::move(callback), priority);
+    }
+
+    CallbackID register_tracked_callback(std::weak_ptr<void> owner, CallbackFunctionType callback, int priority = 0)
+    {
+        return registry().register_tracked_callback(std::move(owner), std::move(callback), priority);
+    }
+
+    ScopedConnection connect(CallbackFunctionType callback, int priority = 0)
+    {
+        return registry().connect(std::move(callback), priority);
+    }
+
+    template<typename CallbackRange>
+
+    std::vector<CallbackID> register_callbacks(const CallbackRange& callbacks, int priority = 0)
+    {
+        return registry().register_callbacks(callbacks, priority);
+    }
+
+    std::vector<CallbackID> register_callbacks(std::initializer_list<CallbackFunctionType> callbacks, int priority = 0)
+    {
+        return registry().register_callbacks(callbacks, priority);
+    }
+
+
+
+    // Functions used to de-register callbacks
+
+    bool deregister_callback(const CallbackID& callbackID)
+    {
+        return m_registry ? m_registry->deregister_callback(callbackID) : false;
+    }
+
+    template<typename CallbackIDRange>
+
+    std::size_t deregister_callbacks(const CallbackIDRange& callbackIDs)
+    {
+        return m_registry ? m_registry->deregister_callbacks(callbackIDs) : 0;
+    }
+
+    std::size_t deregister_callbacks(std::initializer_list<CallbackID> callbackIDs)
+    {
+        return m_registry ? m_registry->deregister_callbacks(callbackIDs) : 0;
+    }
+
+    void deregister_all_callbacks()
+    {
+        if(m_registry)
+            m_registry->deregister_all_callbacks();
+    }
+
+    std::size_t collect_expired_callbacks()
+    {
+        return m_registry ? m_registry->collect_expired_callbacks() : 0;
+    }
+
+
+
+    // Functions used to query the registered callbacks
+
+    std::size_t get_number_of_callbacks()const
+    {
+        return m_registry ? m_registry->get_number_of_callbacks() : 0;
+    }
+
+    bool has_callbacks()const
+    {
+        return m_registry && m_registry->has_callbacks();
+    }
+
+    ExpiredCallbacksStatistics get_expired_callbacks_statistics()const
+    {
+        return m_registry ? m_registry->get_expired_callbacks_statistics() : ExpiredCallbacksStatistics();
+    }
+
+
+
+    // Functions used to reserve room for callbacks
+    // (reserving allocates the callback system)
+
+    void reserve(std::size_t numberOfCallbacks)
+    {
+        registry().reserve(numberOfCallbacks);
+    }
+
+    std::size_t capacity()const
+    {
+        return m_registry ? m_registry->capacity() : 0;
+    }
+
+
+
+    // Function used to make an independent copy (see
+    // the function of the same name defined by the
+    // wrapped callback system)
+
+    BasicCompactCallbacks clone()const
+    {
+        BasicCompactCallbacks compactCallbacks;
+
+        if(m_registry)
+            compactCallbacks.m_registry.reset(new CallbacksType(m_registry->clone()));
+
+        return compactCallbacks;
+    }
+
+
+
+    // Function used to check whether the wrapped
+    // callback system has been allocated
+
+    bool is_allocated()const
+    {
+        return static_cast<bool>(m_registry);
+    }
+
+
+
+    // Function used to access the wrapped callback
+    // system (allocating it if needed)
+
+    CallbacksType& registry()
+    {
+        if(!m_registry)
+            m_registry.reset(new CallbacksType());
+
+        return *m_registry;
+    }
+
+
+
+    // Functions used to invoke the callbacks (see
+    // the functions of the same name defined by
+    // the wrapped callback system)
+    //
+    // NOTE:  The invoke functions only compile if the
+    //        wrapped callback system defines them (for
+    //        example the short-circuit invokers)
+
+    template<typename...Arguments>
+
+    auto invokeCallbacks(Arguments&&...arguments)const
+        -> decltype(std::declval<const DependentRegistryType<Arguments...>&>().invokeCallbacks(std::forward<Arguments>(arguments)...))
+    {
+        using ReturnType = decltype(std::declval<const DependentRegistryType<Arguments...>&>().invokeCallbacks(std::forward<Arguments>(arguments)...));
+
+        if(!m_registry)
+            return ReturnType();
+
+        return m_registry->invokeCallbacks(std::forward<Arguments>(arguments)...);
+    }
+
+
+
+    template<typename...Arguments>
+
+    auto operator()(Arguments&&...arguments)const
+        -> decltype(std::declval<const DependentRegistryType<Arguments...>&>()(std::forward<Arguments>(arguments)...))
+    {
+        using ReturnType = decltype(std::declval<const DependentRegistryType<Arguments...>&>()(std::forward<Arguments>(arguments)...));
+
+        if(!m_registry)
+            return ReturnType();
+
+        return (*m_registry)(std::forward<Arguments>(arguments)...);
+    }
+
+
+
+    template<typename ArgumentsFactory>
+
+    auto invokeCallbacksLazily(ArgumentsFactory&& argumentsFactory)const
+        -> decltype(std::declval<const DependentRegistryType<ArgumentsFactory>&>().invokeCallbacksLazily(std::forward<ArgumentsFactory>(argumentsFactory)))
+    {
+        using ReturnType = decltype(std::declval<const DependentRegistryType<ArgumentsFactory>&>().invokeCallbacksLazily(std::forward<ArgumentsFactory>(argumentsFactory)));
+
+        if(!m_registry)
+            return ReturnType();
+
+        return m_registry->invokeCallbacksLazily(std::forward<ArgumentsFactory>(argumentsFactory));
+    }
+
+
+
+    template<typename...Arguments>
+
+    BudgetedInvocationResult invokeCallbacksWithinBudget(std::chrono::steady_clock::duration budget,
+                                                         Arguments&&...arguments)const
+    {
+        if(!m_registry)
+            return BudgetedInvocationResult();
+
+        return m_registry->invokeCallbacksWithinBudget(budget, std::forward<Arguments>(arguments)...);
+    }
+
+
+
+    template<typename...Arguments>
+
+    BudgetedInvocationResult resumeCallbacksWithinBudget(const BudgetedInvocationResult& previousResult,
+                                                         std::chrono::steady_clock::duration budget,
+                                                         Arguments&&...arguments)const
+    {
+        if(!m_registry)
+            return BudgetedInvocationResult();
+
+        return m_registry->resumeCallbacksWithinBudget(previousResult, budget, std::forward<Arguments>(arguments)...);
+    }
+
+
+
+    template<typename...Arguments>
+
+    auto invokeCallbacksUntilOneOfThemReturnsANonEmptyContainer(Arguments&&...arguments)const
+        -> decltype(std::declval<const DependentRegistryType<Arguments...>&>().invokeCallbacksUntilOneOfThemReturnsANonEmptyContainer(std::forward<Arguments>(arguments)...))
+    {
+        using ReturnType = decltype(std::declval<const DependentRegistryType<Arguments...>&>().invokeCallbacksUntilOneOfThemReturnsANonEmptyContainer(std::forward<Arguments>(arguments)...));
+
+        if(!m_registry)
+            return ReturnType();
+
+        return m_registry->invokeCallbacksUntilOneOfThemReturnsANonEmptyContainer(std::forward<Arguments>(arguments)...);
+    }
+
+
+
+    template<typename...Arguments>
+
+    bool invokeCallbacksUntilOneOfThemReturnsANonZeroValue(Arguments&&...arguments)const
+    {
+        if(!m_registry)
+            return false;
+
+        return m_registry->invokeCallbacksUntilOneOfThemReturnsANonZeroValue(std::forward<Arguments>(arguments)...);
+    }
+
+
+
+private: // Private variables
+
+
+
+    // The wrapped callback system (null until
+    // the first callback is registered)
+
+    std::unique_ptr<CallbacksType>      m_registry;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Compact versions of the callback systems with the default policy
+//-------------------------------------------------------------------
+template<typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using CompactCallbacks = BasicCompactCallbacks<Callbacks<CallbackReturnType,CallbackArguments...>>;
+
+
+
+template<typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using CompactCallbacksReturningAContainer = BasicCompactCallbacks<CallbacksReturningAContainer<CallbackReturnType,CallbackArguments...>>;
+
+
+
+template<typename...CallbackArguments>
+
+using CompactCallbacksReturningABoolean = BasicCompactCallbacks<CallbacksReturningABoolean<CallbackArguments...>>;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of CallbacksLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // CALLBACKS_COMPACT_HPP
@@ -0,0 +1,508 @@
+#ifndef CALLBACKS_COPY_ON_WRITE_HPP
+#define CALLBACKS_COPY_ON_WRITE_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Copy-on-write storage for the callback systems defined in callbacks.hpp,
+/// meant for callback systems that are forked (for example a registry
+/// prepared once and cloned for each new session)
+///
+/// -- Cloning a callback system whose callbacks are stored copy-on-write
+///    only shares its callbacks with the clone (O(1), no allocation).  The
+///    callbacks are copied the first time either callback system modifies
+///    them:
+///
+///        CallbacksLIB::CopyOnWriteCallbacks<void,const Event&> prototype;
+///
+///        ...
+///
+///        auto sessionCallbacks = prototype.clone();
+///
+/// -- Registering or de-registering a callback counts as modifying them.
+///    Invoking the callbacks reads them in place, and only copies them when
+///    a one-shot or counted callback counts down or a tracked callback has
+///    expired (which is per callback system).  The callback system that is
+///    left as the only owner of the shared callbacks modifies them in place
+///
+/// -- The callables themselves are shared until the callbacks are copied,
+///    so a callable with state (for example a mutable lambda) sees the
+///    invocations of every callback system sharing it
+///
+/// -- De-registering all the callbacks of a clone that still shares them
+///    only drops its reference to them
+///
+/// -- The copy-on-write storage can be combined with the other policies:
+///
+///        BasicCallbacks<CopyOnWriteCallbacksPolicy<PmrCallbacksPolicy>,void,int> callbacks(&arena);
+///
+/// -- The number of owners of the shared callbacks is atomic, so clones can
+///    be used by different threads (each callback system is still meant to
+///    be used by one thread at a time)
+///
+///
+///
+/// Note: This class is defined within the namespace CallbacksLIB
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Classes are defined within the namespace CallbacksLIB
+//-------------------------------------------------------------------
+namespace CallbacksLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Vector whose copies share their elements until one of them is
+// modified (the elements are kept in a reference counted block
+// taken from its allocator)
+//
+// The non-const functions give the vector its own elements first,
+// the const functions never copy them
+//
+// It provides the subset of the std::vector interface used by the
+// callback systems
+//-------------------------------------------------------------------
+template<typename T,
+         typename Allocator = std::allocator<T>>
+
+class CopyOnWriteVector
+{
+private: // Private typedefs
+
+
+
+    using AllocatorTraits = std::allocator_traits<Allocator>;
+    using ElementsType = std::vector<T,Allocator>;
+
+
+
+    // The shared block (it keeps the allocator it was
+    // taken from in its vector of elements)
+
+    struct Block
+    {
+        explicit Block(const Allocator& allocator) : m_elements(allocator){}
+
+        Block(const ElementsType& elements, const Allocator& allocator) : m_elements(elements, allocator){}
+
+        std::atomic<std::size_t>        m_numberOfOwners{1};
+        ElementsType                    m_elements;
+    };
+
+    using BlockAllocatorType = typename AllocatorTraits::template rebind_alloc<Block>;
+    using BlockAllocatorTraits = std::allocator_traits<BlockAllocatorType>;
+
+
+
+public: // Public typedefs
+
+
+
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+
+
+public: // Constructors and destructor
+
+
+
+    CopyOnWriteVector(){}
+
+    explicit CopyOnWriteVector(const Allocator& allocator) : m_allocator(allocator){}
+
+
+
+    // Copies share the elements (the copy gets its own
+    // elements, from its own allocator, once modified)
+
+    CopyOnWriteVector(const CopyOnWriteVector& vector) :
+        m_allocator(AllocatorTraits::select_on_container_copy_construction(vector.m_allocator)),
+        m_block(vector.m_block)
+    {
+        if(m_block)
+            m_block->m_numberOfOwners.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    CopyOnWriteVector(CopyOnWriteVector&& vector) :
+        m_allocator(vector.m_allocator),
+        m_block(vector.m_block)
+    {
+        vector.m_block = nullptr;
+    }
+
+
+
+    ~CopyOnWriteVector()
+    {
+        release();
+    }
+
+
+
+public: // Assignment operators (the vector keeps its own allocator)
+
+
+
+    CopyOnWriteVector& operator=(const CopyOnWriteVector& vector)
+    {
+        if(this != &vector)
+        {
+            if(vector.m_block)
+                vector.m_block->m_numberOfOwners.fetch_add(1, std::memory_order_relaxed);
+
+            release();
+
+            m_block = vector.m_block;
+        }
+
+        return *this;
+    }
+
+    CopyOnWriteVector& operator=(CopyOnWriteVector&& vector)
+    {
+        if(this != &vector)
+        {
+            release();
+
+            m_block = vector.m_block;
+            vector.m_block = nullptr;
+        }
+
+        return *this;
+    }
+
+
+
+public: // Public functions
+
+
+
+    iterator begin(){ return elements_or_null(); }
+    iterator end(){ return elements_or_null() + size(); }
+
+    const_iterator begin()const{ return shared_elements_or_null(); }
+    const_iterator end()const{ return begin() + size(); }
+
+
+
+    size_type size()const{ return m_block ? m_block->m_elements.size() : 0; }
+    size_type capacity()const{ return m_block ? m_block->m_elements.capacity() : 0; }
+    size_type max_size()const{ return AllocatorTraits::max_size(m_allocator); }
+    bool empty()const{ return size() == 0; }
+
+
+
+    T& operator[](size_type index){ return elements_or_null()[index]; }
+    const T& operator[](size_type index)const{ return m_block->m_elements[index]; }
+
+    T& back(){ return (*this)[size() - 1]; }
+    const T& back()const{ return (*this)[size() - 1]; }
+
+
+
+    Allocator get_allocator()const
+    {
+        return m_allocator;
+    }
+
+
+
+    // Function used to check whether the elements
+    // are shared with another vector
+
+    bool is_shared()const
+    {
+        return m_block && m_block->m_numberOfOwners.load(std::memory_order_acquire) != 1;
+    }
+
+
+
+    // Function used to give the vector its own
+    // elements if they are shared
+
+    void unshare()
+    {
+        if(!is_shared())
+            return;
+
+        Block* block = create_block(m_block->m_elements);
+
+        release();
+
+        m_block = block;
+    }
+
+
+
+    void reserve(size_type capacity)
+    {
+        elements().reserve(capacity);
+    }
+
+
+
+    void push_back(const T& element)
+    {
+        elements().push_back(element);
+    }
+
+    void push_back(T&& element)
+    {
+        elements().push_back(std::move(element));
+    }
+
+
+
+    iterator insert(const_iterator position, T&& element)
+    {
+        size_type index = static_cast<size_type>(position - shared_elements_or_null());
+
+        ElementsType& vectorElements = elements();
+
+        vectorElements.insert(vectorElements.begin() + index, std::move(element));
+
+        return vectorElements.data() + index;
+    }
+
+
+
+    iterator erase(const_iterator position)
+    {
+        return erase(position, position + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        size_type firstIndex = static_cast<size_type>(first - shared_elements_or_null());
+        size_type lastIndex = static_cast<size_type>(last - shared_elements_or_null());
+
+        if(firstIndex == lastIndex)
+            return elements_or_null() + firstIndex;
+
+        ElementsType& vectorElements = elements();
+
+        vectorElements.erase(vectorElements.begin() + firstIndex, vectorElements.begin() + lastIndex);
+
+        return vectorElements.data() + firstIndex;
+    }
+
+
+
+    // Function used to remove the elements (shared
+    // elements are not copied, the vector only drops
+    // its reference to them)
+
+    void clear()
+    {
+        if(is_shared())
+            release();
+        else if(m_block)
+            m_block->m_elements.clear();
+    }
+
+
+
+private: // Private functions
+
+
+
+    // Function used to get the elements to modify them
+    // (creating them, or copying the shared ones)
+
+    ElementsType& elements()
+    {
+        if(!m_block)
+            m_block = create_block();
+        else
+            unshare();
+
+        return m_block->m_elements;
+    }
+
+
+
+    // Function used to get the first element to modify
+    // the elements in place (null if there are none)
+
+    T* elements_or_null()
+    {
+        if(!m_block)
+            return nullptr;
+
+        unshare();
+
+        return m_block->m_elements.data();
+    }
+
+
+
+    // Function used to get the first element without
+    // copying shared elements (null if there are none)
+
+    const T* shared_elements_or_null()const
+    {
+        return m_block ? m_block->m_elements.data() : nullptr;
+    }
+
+
+
+    // Function used to take a new block from the
+    // allocator (empty or copying the specified
+    // elements)
+
+    template<typename...BlockArguments>
+
+    Block* create_block(const BlockArguments&...blockArguments)
+    {
+        BlockAllocatorType blockAllocator(m_allocator);
+
+        Block* block = BlockAllocatorTraits::allocate(blockAllocator, 1);
+
+        try
+        {
+            ::new(static_cast<void*>(block)) Block(blockArguments..., m_allocator);
+        }
+        catch(...)
+        {
+            BlockAllocatorTraits::deallocate(blockAllocator, block, 1);
+            throw;
+        }
+
+        return block;
+    }
+
+
+
+    // Function used to drop the reference to the block
+    // (the last owner destroys it)
+
+    void release()
+    {
+        if(!m_block)
+            return;
+
+        if(m_block->m_numberOfOwners.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            BlockAllocatorType blockAllocator(m_block->m_elements.get_allocator());
+
+            m_block->~Block();
+
+            BlockAllocatorTraits::deallocate(blockAllocator, m_block, 1);
+        }
+
+        m_block = nullptr;
+    }
+
+
+
+private: // Private variables
+
+
+
+    Allocator                           m_allocator;
+
+
+
+    // The (possibly shared) elements, null until
+    // the first element is added
+
+    Block*                              m_block = nullptr;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Copy-on-write vectors share their elements with their copies
+//-------------------------------------------------------------------
+template<typename T, typename Allocator>
+
+struct IsCopyOnWriteStorage<CopyOnWriteVector<T,Allocator>> : std::true_type
+{
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Policy storing the callbacks copy-on-write (the other options are
+// taken from the base policy)
+//-------------------------------------------------------------------
+template<typename BasePolicy = DefaultCallbacksPolicy>
+
+struct CopyOnWriteCallbacksPolicy : BasePolicy
+{
+    template<typename CallbackType, typename CallbackAllocatorType>
+
+    using StorageType = CopyOnWriteVector<CallbackType,CallbackAllocatorType>;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Aliases of the copy-on-write callback systems
+//-------------------------------------------------------------------
+template<typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using CopyOnWriteCallbacks = BasicCallbacks<CopyOnWriteCallbacksPolicy<>,CallbackReturnType,CallbackArguments...>;
+
+
+
+template<typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using CopyOnWriteCallbacksReturningAContainer = BasicCallbacksReturningAContainer<CopyOnWriteCallbacksPolicy<>,CallbackReturnType,CallbackArguments...>;
+
+
+
+template<typename...CallbackArguments>
+
+using CopyOnWriteCallbacksReturningABoolean = BasicCallbacksReturningABoolean<CopyOnWriteCallbacksPolicy<>,CallbackArguments...>;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of CallbacksLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // CALLBACKS_COPY_ON_WRITE_HPP
@@ -0,0 +1,386 @@
+#ifndef CALLBACKS_EXCEPTIONS_HPP
+#define CALLBACKS_EXCEPTIONS_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Optional exception policies for the callback systems defined in
+/// callbacks.hpp, which decide what happens when a callback throws
+///
+/// -- By default (PropagateExceptions) the exception propagates to the
+///    caller and the callbacks after the throwing one are not invoked
+///
+/// -- The other policies are selected through the policy of the callback
+///    system:
+///
+///    1.  IsolatingCallbacksPolicy:   The exception is caught, handed to an
+///                                    optional handler, and the remaining
+///                                    callbacks are still invoked
+///
+///                                        BasicCallbacks<IsolatingCallbacksPolicy,void,int> callbacks;
+///
+///                                        callbacks.exception_policy().set_exception_handler([](CallbackID callbackID, std::exception_ptr exception)
+///                                        {
+///                                            ...
+///                                        });
+///
+///    2.  CollectingCallbacksPolicy:  The exceptions are caught, the
+///                                    remaining callbacks are still invoked,
+///                                    and once they all ran a single
+///                                    CallbackExceptions holding every
+///                                    caught exception is thrown
+///
+///    3.  NoexceptCallbacksPolicy:    The callbacks promise not to throw, so
+///                                    the invocation has no try/catch at all
+///                                    (a callback that throws anyway ends the
+///                                    program through std::terminate)
+///
+/// -- The default and the noexcept policies add no code to the invocation,
+///    the isolating and collecting policies add one try block around each
+///    callback, which costs nothing until a callback actually throws
+///
+///
+///
+/// Note: This class is defined within the namespace CallbacksLIB
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <utility>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Classes are defined within the namespace CallbacksLIB
+//-------------------------------------------------------------------
+namespace CallbacksLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Exception thrown by a callback, along with the callback ID
+//-------------------------------------------------------------------
+struct CallbackException
+{
+    CallbackID                          m_callbackID = 0;
+    std::exception_ptr                  m_exception;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Exception thrown by CollectExceptions once all the callbacks
+// have been invoked, holding every exception they threw
+//-------------------------------------------------------------------
+class CallbackExceptions : public std::exception
+{
+public: // Constructors and destructor
+
+
+
+    explicit CallbackExceptions(std::vector<CallbackException> exceptions) : m_exceptions(std::move(exceptions)){}
+    ~CallbackExceptions(){}
+
+
+
+public: // Public functions
+
+
+
+    const char* what()const noexcept override
+    {
+        return "One or more callbacks threw an exception";
+    }
+
+
+
+    // Function used to get the exceptions thrown by
+    // the callbacks (in the order they were invoked)
+
+    const std::vector<CallbackException>& exceptions()const
+    {
+        return m_exceptions;
+    }
+
+
+
+private: // Private variables
+
+
+
+    std::vector<CallbackException>      m_exceptions;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Exception policy catching the exception thrown by a callback and
+// moving on to the next callback
+//-------------------------------------------------------------------
+class IsolateExceptions
+{
+public: // Public typedefs
+
+
+
+    using ExceptionHandlerType = std::function<void(CallbackID callbackID, std::exception_ptr exception)>;
+
+
+
+public: // Public classes
+
+
+
+    class InvocationScope
+    {
+    public:
+
+        explicit InvocationScope(IsolateExceptions& policy) : m_policy(policy){}
+
+        template<typename InvokeFunction>
+
+        bool invoke(CallbackID callbackID, InvokeFunction&& invokeFunction)
+        {
+            try
+            {
+                return invokeFunction();
+            }
+            catch(...)
+            {
+                m_policy.isolate(callbackID, std::current_exception());
+            }
+
+            return false;
+        }
+
+        void finish(){}
+
+    private:
+
+        IsolateExceptions&              m_policy;
+    };
+
+
+
+public: // Configuration functions
+
+
+
+    // Function called with each isolated exception
+    // (from the thread invoking the callbacks)
+    //
+    // NOTE:  An exception thrown by the handler
+    //        propagates to the caller
+
+    void set_exception_handler(ExceptionHandlerType exceptionHandler)
+    {
+        m_exceptionHandler = std::move(exceptionHandler);
+    }
+
+
+
+public: // Public functions
+
+
+
+    InvocationScope begin_invocation()
+    {
+        return InvocationScope(*this);
+    }
+
+
+
+    // Function used to get how many exceptions
+    // have been isolated so far
+
+    std::uint64_t get_number_of_isolated_exceptions()const
+    {
+        return m_numberOfIsolatedExceptions;
+    }
+
+
+
+private: // Private functions
+
+
+
+    void isolate(CallbackID callbackID, std::exception_ptr exception)
+    {
+        ++m_numberOfIsolatedExceptions;
+
+        if(m_exceptionHandler)
+            m_exceptionHandler(callbackID, std::move(exception));
+    }
+
+
+
+private: // Private variables
+
+
+
+    ExceptionHandlerType                m_exceptionHandler;
+    std::uint64_t                       m_numberOfIsolatedExceptions = 0;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Exception policy catching the exceptions thrown by the callbacks,
+// invoking the remaining callbacks, and then throwing all of them
+// at once as a CallbackExceptions
+//-------------------------------------------------------------------
+class CollectExceptions
+{
+public: // Public classes
+
+
+
+    class InvocationScope
+    {
+    public:
+
+        template<typename InvokeFunction>
+
+        bool invoke(CallbackID callbackID, InvokeFunction&& invokeFunction)
+        {
+            try
+            {
+                return invokeFunction();
+            }
+            catch(...)
+            {
+                CallbackException callbackException;
+                callbackException.m_callbackID = callbackID;
+                callbackException.m_exception = std::current_exception();
+
+                m_exceptions.push_back(std::move(callbackException));
+            }
+
+            return false;
+        }
+
+        void finish()
+        {
+            if(!m_exceptions.empty())
+                throw CallbackExceptions(std::move(m_exceptions));
+        }
+
+    private:
+
+        // Only allocated once a callback throws
+
+        std::vector<CallbackException>  m_exceptions;
+    };
+
+
+
+public: // Public functions
+
+
+
+    InvocationScope begin_invocation()const
+    {
+        return InvocationScope();
+    }
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Exception policy for callbacks that never throw
+//
+// Each callback is invoked through a noexcept function, so the
+// compiler doesn't emit any unwinding code for the invocation, and
+// a callback throwing anyway calls std::terminate
+//-------------------------------------------------------------------
+class NoexceptCallbacks
+{
+public: // Public classes
+
+
+
+    class InvocationScope
+    {
+    public:
+
+        template<typename InvokeFunction>
+
+        bool invoke(CallbackID callbackID, InvokeFunction&& invokeFunction)noexcept
+        {
+            (void)callbackID;
+
+            return invokeFunction();
+        }
+
+        void finish()noexcept{}
+    };
+
+
+
+public: // Public functions
+
+
+
+    InvocationScope begin_invocation()const noexcept
+    {
+        return InvocationScope();
+    }
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Policies selecting the exception policies
+//-------------------------------------------------------------------
+struct IsolatingCallbacksPolicy : DefaultCallbacksPolicy
+{
+    using ExceptionPolicyType = IsolateExceptions;
+};
+
+struct CollectingCallbacksPolicy : DefaultCallbacksPolicy
+{
+    using ExceptionPolicyType = CollectExceptions;
+};
+
+struct NoexceptCallbacksPolicy : DefaultCallbacksPolicy
+{
+    using ExceptionPolicyType = NoexceptCallbacks;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of CallbacksLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // CALLBACKS_EXCEPTIONS_HPP
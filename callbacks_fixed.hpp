@@ -0,0 +1,478 @@
+#ifndef CALLBACKS_FIXED_HPP
+#define CALLBACKS_FIXED_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Fixed-capacity version of the callback systems defined in callbacks.hpp,
+/// meant for real-time and embedded code where registering and invoking
+/// callbacks must never touch the heap
+///
+/// -- A fixed callback system stores up to N callbacks, and the state of
+///    their callables, inline in the object itself:
+///
+///        CallbacksLIB::FixedCallbacks<8,void,int> callbacks;
+///
+///        if(callbacks.register_callback(onSample) == 0)
+///        {
+///            // The callback system is full
+///        }
+///
+/// -- Registration fails (returns 0) once N callbacks are registered.  The
+///    callbacks that were de-registered or whose tracked object died are
+///    removed first, so their slots are reused
+///
+/// -- The guarantees are checked at compile time: registering a callable
+///    that doesn't fit the inline storage of a callback (CallableCapacity
+///    bytes, 3 pointers by default) triggers a static_assert, instead of
+///    silently allocating.  Function pointers, member function pointers
+///    bound to an object pointer, and lambdas capturing a few references
+///    always fit
+///
+/// -- Nothing else allocates while registering or invoking the callbacks,
+///    except for connect() (whose connection token is shared), for the
+///    metadata attached with set_callback_metadata(), for the container
+///    returned by invokeCallbacks() of FixedCallbacksReturningAContainer,
+///    and for the bulk functions: register_callbacks() returns its IDs in a
+///    std::vector, and deregister_callbacks() sorts a std::vector copy of
+///    the IDs to remove.  Code that must never touch the heap registers and
+///    de-registers the callbacks one by one instead
+///
+/// -- The object holds two arrays of N callbacks (the second one journals
+///    the callbacks registered while invoking them), and an array of N
+///    trackers holding the objects tracked by the tracked callbacks
+///
+///
+///
+/// Note: This class is defined within the namespace CallbacksLIB
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+#include "callbacks_function.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Classes are defined within the namespace CallbacksLIB
+//-------------------------------------------------------------------
+namespace CallbacksLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Allocator that can't allocate, used by the callables of the fixed
+// callback systems so that a callable too large to be stored inline
+// is rejected at compile time
+//-------------------------------------------------------------------
+template<typename T>
+
+class InlineOnlyAllocator
+{
+public: // Public typedefs
+
+
+
+    using value_type = T;
+
+
+
+public: // Constructors
+
+
+
+    InlineOnlyAllocator(){}
+
+    template<typename U>
+
+    InlineOnlyAllocator(const InlineOnlyAllocator<U>&){}
+
+
+
+public: // Public functions
+
+
+
+    T* allocate(std::size_t numberOfObjects)
+    {
+        static_assert(sizeof(T) == 0, "The callable is too large to be stored inline by a fixed callback system (increase its CallableCapacity)");
+
+        (void)numberOfObjects;
+
+        return nullptr;
+    }
+
+
+
+    void deallocate(T* objects, std::size_t numberOfObjects)
+    {
+        (void)objects;
+        (void)numberOfObjects;
+    }
+
+
+
+    template<typename U>
+
+    bool operator==(const InlineOnlyAllocator<U>&)const
+    {
+        return true;
+    }
+
+    template<typename U>
+
+    bool operator!=(const InlineOnlyAllocator<U>&)const
+    {
+        return false;
+    }
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Vector storing up to N elements inline
+//
+// It provides the subset of the std::vector interface used by the
+// callback systems, and max_size() reports its capacity so that the
+// callback systems stop registering callbacks once it is full
+//-------------------------------------------------------------------
+template<typename T,
+         std::size_t N,
+         typename Allocator>
+
+class FixedCapacityVector
+{
+    static_assert(N > 0, "A fixed-capacity vector must be able to store at least one element");
+
+public: // Public typedefs
+
+
+
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+
+
+public: // Constructors and destructor
+
+
+
+    FixedCapacityVector(){}
+
+    explicit FixedCapacityVector(const Allocator& allocator) : m_allocator(allocator){}
+
+
+
+    FixedCapacityVector(const FixedCapacityVector& vector) : m_allocator(vector.m_allocator)
+    {
+        for(const auto& element : vector)
+            push_back(element);
+    }
+
+    FixedCapacityVector(FixedCapacityVector&& vector) : m_allocator(vector.m_allocator)
+    {
+        for(auto& element : vector)
+            push_back(std::move(element));
+
+        vector.clear();
+    }
+
+
+
+    ~FixedCapacityVector()
+    {
+        clear();
+    }
+
+
+
+public: // Assignment operators
+
+
+
+    FixedCapacityVector& operator=(const FixedCapacityVector& vector)
+    {
+        if(this != &vector)
+        {
+            clear();
+
+            for(const auto& element : vector)
+                push_back(element);
+        }
+
+        return *this;
+    }
+
+    FixedCapacityVector& operator=(FixedCapacityVector&& vector)
+    {
+        if(this != &vector)
+        {
+            clear();
+
+            for(auto& element : vector)
+                push_back(std::move(element));
+
+            vector.clear();
+        }
+
+        return *this;
+    }
+
+
+
+public: // Public functions
+
+
+
+    iterator begin(){ return data(); }
+    iterator end(){ return data() + m_size; }
+
+    const_iterator begin()const{ return data(); }
+    const_iterator end()const{ return data() + m_size; }
+
+
+
+    size_type size()const{ return m_size; }
+    size_type capacity()const{ return N; }
+    size_type max_size()const{ return N; }
+    bool empty()const{ return m_size == 0; }
+
+
+
+    T& operator[](size_type index){ return data()[index]; }
+    const T& operator[](size_type index)const{ return data()[index]; }
+
+    T& back(){ return data()[m_size - 1]; }
+    const T& back()const{ return data()[m_size - 1]; }
+
+
+
+    Allocator get_allocator()const
+    {
+        return m_allocator;
+    }
+
+
+
+    // The capacity can't change (reserving more than
+    // N elements throws, like reserving more than
+    // max_size() elements in a std::vector)
+
+    void reserve(size_type capacity)const
+    {
+        if(capacity > N)
+            throw std::length_error("FixedCapacityVector can't store that many elements");
+    }
+
+
+
+    void push_back(const T& element)
+    {
+        check_capacity();
+
+        ::new(static_cast<void*>(data() + m_size)) T(element);
+
+        ++m_size;
+    }
+
+    void push_back(T&& element)
+    {
+        check_capacity();
+
+        ::new(static_cast<void*>(data() + m_size)) T(std::move(element));
+
+        ++m_size;
+    }
+
+
+
+    // Function used to insert an element before the
+    // specified position (the following elements are
+    // shifted one slot to the right)
+
+    iterator insert(const_iterator position, T&& element)
+    {
+        check_capacity();
+
+        std::size_t index = static_cast<std::size_t>(position - begin());
+
+        if(index == m_size)
+        {
+            push_back(std::move(element));
+            return begin() + index;
+        }
+
+        ::new(static_cast<void*>(data() + m_size)) T(std::move(back()));
+
+        ++m_size;
+
+        for(std::size_t i = m_size - 2; i > index; --i)
+            data()[i] = std::move(data()[i - 1]);
+
+        data()[index] = std::move(element);
+
+        return begin() + index;
+    }
+
+
+
+    iterator erase(const_iterator position)
+    {
+        return erase(position, position + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        iterator destination = begin() + (first - begin());
+        iterator source = begin() + (last - begin());
+
+        if(destination == source)
+            return destination;
+
+        iterator newEnd = std::move(source, end(), destination);
+
+        for(iterator element = newEnd; element != end(); ++element)
+            element->~T();
+
+        m_size = static_cast<std::size_t>(newEnd - begin());
+
+        return destination;
+    }
+
+
+
+    void clear()
+    {
+        for(auto& element : *this)
+            element.~T();
+
+        m_size = 0;
+    }
+
+
+
+private: // Private functions
+
+
+
+    T* data()
+    {
+        return reinterpret_cast<T*>(m_storage);
+    }
+
+    const T* data()const
+    {
+        return reinterpret_cast<const T*>(m_storage);
+    }
+
+
+
+    void check_capacity()const
+    {
+        if(m_size == N)
+            throw std::length_error("FixedCapacityVector is full");
+    }
+
+
+
+private: // Private variables
+
+
+
+    Allocator                           m_allocator;
+    std::size_t                         m_size = 0;
+
+    alignas(T) unsigned char            m_storage[N * sizeof(T)];
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Policy storing up to N callbacks, and callables of up to
+// CallableCapacity bytes, inline in the callback system
+//-------------------------------------------------------------------
+template<std::size_t N,
+         std::size_t CallableCapacity = 3 * sizeof(void*)>
+
+struct FixedCallbacksPolicy : DefaultCallbacksPolicy
+{
+    static_assert(N > 0, "A fixed callback system must be able to store at least one callback");
+    static_assert(CallableCapacity >= sizeof(void(*)()), "The callables of a fixed callback system must at least fit a function pointer");
+
+    using AllocatorType = InlineOnlyAllocator<char>;
+
+    template<typename Signature>
+
+    using FunctionType = CallbackFunction<Signature,InlineOnlyAllocator<char>,CallableCapacity>;
+
+    template<typename CallbackType, typename CallbackAllocatorType>
+
+    using StorageType = FixedCapacityVector<CallbackType,N,CallbackAllocatorType>;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Aliases of the fixed callback systems
+//-------------------------------------------------------------------
+template<std::size_t N,
+         typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using FixedCallbacks = BasicCallbacks<FixedCallbacksPolicy<N>,CallbackReturnType,CallbackArguments...>;
+
+
+
+template<std::size_t N,
+         typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using FixedCallbacksReturningAContainer = BasicCallbacksReturningAContainer<FixedCallbacksPolicy<N>,CallbackReturnType,CallbackArguments...>;
+
+
+
+template<std::size_t N,
+         typename...CallbackArguments>
+
+using FixedCallbacksReturningABoolean = BasicCallbacksReturningABoolean<FixedCallbacksPolicy<N>,CallbackArguments...>;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of CallbacksLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // CALLBACKS_FIXED_HPP
@@ -0,0 +1,565 @@
+#ifndef CALLBACKS_FUNCTION_HPP
+#define CALLBACKS_FUNCTION_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Allocator-aware replacement of std::function used to store the callbacks
+/// of the callback systems defined in callbacks.hpp
+///
+/// -- Small callables (up to three pointers by default, for example function
+///    pointers or lambdas capturing a few references) are stored inline,
+///    larger ones are allocated with the allocator of the function
+///
+/// -- A function constructed with a different allocator than the callback
+///    system it is registered with is moved to the allocator of the callback
+///    system, so that the state of all the callbacks of a callback system
+///    comes from the same place (for example an arena):
+///
+///        std::pmr::monotonic_buffer_resource arena;
+///
+///        BasicCallbacks<PmrCallbacksPolicy,void,int> callbacks(&arena);
+///
+///    (see callbacks_allocator.hpp for the policies)
+///
+/// -- To skip that move, construct the function with the allocator of the
+///    callback system directly:
+///
+///        callbacks.register_callback(decltype(callbacks)::CallbackFunctionType(std::allocator_arg,
+///                                                                             callbacks.get_allocator(),
+///                                                                             largeLambda));
+///
+/// -- Like std::function, invoking an empty function throws
+///    std::bad_function_call
+///
+///
+///
+/// Note: This class is defined within the namespace CallbacksLIB
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Classes are defined within the namespace CallbacksLIB
+//-------------------------------------------------------------------
+namespace CallbacksLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Allocator-aware function wrapper
+//-------------------------------------------------------------------
+template<typename Signature,
+         typename Allocator = std::allocator<char>,
+         std::size_t InlineCapacity = 3 * sizeof(void*)>
+
+class CallbackFunction;
+
+
+
+template<typename CallbackReturnType, typename...CallbackArguments, typename Allocator, std::size_t InlineCapacity>
+
+class CallbackFunction<CallbackReturnType(CallbackArguments...), Allocator, InlineCapacity>
+{
+public: // Public typedefs
+
+
+
+    using AllocatorType = Allocator;
+
+
+
+public: // Public constants
+
+
+
+    // Callables up to this size (that can be moved
+    // without throwing) are stored inline
+
+    static const std::size_t            s_inlineCapacity = InlineCapacity;
+
+
+
+public: // Constructors and destructor
+
+
+
+    // Constructors of empty functions
+
+    CallbackFunction(){}
+
+    CallbackFunction(std::nullptr_t){}
+
+    CallbackFunction(std::allocator_arg_t, const Allocator& allocator) : m_allocator(allocator){}
+
+
+
+    // Constructors storing a callable (with a
+    // default-constructed allocator, or with the
+    // specified allocator)
+
+    template<typename Callable,
+             typename = typename std::enable_if<!std::is_same<typename std::decay<Callable>::type,CallbackFunction>::value>::type>
+
+    CallbackFunction(Callable&& callable)
+    {
+        store(std::forward<Callable>(callable));
+    }
+
+
+
+    template<typename Callable,
+             typename = typename std::enable_if<!std::is_same<typename std::decay<Callable>::type,CallbackFunction>::value>::type>
+
+    CallbackFunction(std::allocator_arg_t, const Allocator& allocator, Callable&& callable) : m_allocator(allocator)
+    {
+        store(std::forward<Callable>(callable));
+    }
+
+
+
+    // Copy constructors (the copy keeps the allocator
+    // of the original, or uses the specified one)
+
+    CallbackFunction(const CallbackFunction& function) : m_allocator(function.m_allocator)
+    {
+        if(function.m_operations)
+            function.m_operations->m_copy(function, *this);
+    }
+
+    CallbackFunction(std::allocator_arg_t, const Allocator& allocator, const CallbackFunction& function) : m_allocator(allocator)
+    {
+        if(function.m_operations)
+            function.m_operations->m_copy(function, *this);
+    }
+
+
+
+    // Move constructors (the moved function keeps its
+    // allocator, or its callable is moved to storage
+    // from the specified allocator if it differs)
+
+    CallbackFunction(CallbackFunction&& function)noexcept : m_allocator(function.m_allocator)
+    {
+        if(function.m_operations)
+            function.m_operations->m_move(function, *this);
+    }
+
+    CallbackFunction(std::allocator_arg_t, const Allocator& allocator, CallbackFunction&& function) : m_allocator(allocator)
+    {
+        adopt(function);
+    }
+
+
+
+    // Destructor
+
+    ~CallbackFunction()
+    {
+        reset();
+    }
+
+
+
+public: // Assignment operators (the function keeps its own allocator)
+
+
+
+    CallbackFunction& operator=(const CallbackFunction& function)
+    {
+        if(this != &function)
+        {
+            reset();
+
+            if(function.m_operations)
+                function.m_operations->m_copy(function, *this);
+        }
+
+        return *this;
+    }
+
+
+
+    CallbackFunction& operator=(CallbackFunction&& function)
+    {
+        if(this != &function)
+        {
+            reset();
+            adopt(function);
+        }
+
+        return *this;
+    }
+
+
+
+    CallbackFunction& operator=(std::nullptr_t)
+    {
+        reset();
+
+        return *this;
+    }
+
+
+
+public: // Public functions
+
+
+
+    CallbackReturnType operator()(CallbackArguments...arguments)const
+    {
+        if(!m_operations)
+            throw std::bad_function_call();
+
+        return m_operations->m_invoke(*this, std::forward<CallbackArguments>(arguments)...);
+    }
+
+
+
+    explicit operator bool()const
+    {
+        return m_operations != nullptr;
+    }
+
+
+
+    Allocator get_allocator()const
+    {
+        return m_allocator;
+    }
+
+
+
+private: // Private classes
+
+
+
+    // The operations on the stored callable
+
+    struct Operations
+    {
+        CallbackReturnType              (*m_invoke)(const CallbackFunction& function, CallbackArguments&&...arguments);
+        void                            (*m_copy)(const CallbackFunction& source, CallbackFunction& destination);
+        void                            (*m_move)(CallbackFunction& source, CallbackFunction& destination);
+        void                            (*m_relocate)(CallbackFunction& source, CallbackFunction& destination);
+        void                            (*m_destroy)(CallbackFunction& function);
+    };
+
+
+
+    // The operations implemented for a callable type
+
+    template<typename Callable>
+
+    struct CallableOperations
+    {
+        using CallableAllocatorType = typename std::allocator_traits<Allocator>::template rebind_alloc<Callable>;
+        using CallableAllocatorTraits = std::allocator_traits<CallableAllocatorType>;
+
+        using IsInline = std::integral_constant<bool, sizeof(Callable) <= s_inlineCapacity &&
+                                                      alignof(Callable) <= alignof(void*) &&
+                                                      std::is_nothrow_move_constructible<Callable>::value>;
+
+        static const Operations* operations()
+        {
+            static const Operations callableOperations = {&invoke, &copy, &move, &relocate, &destroy};
+
+            return &callableOperations;
+        }
+
+
+
+        // Access to the callable
+
+        static Callable& callable(const CallbackFunction& function)
+        {
+            return callable(function, IsInline());
+        }
+
+        static Callable& callable(const CallbackFunction& function, std::true_type)
+        {
+            return *reinterpret_cast<Callable*>(const_cast<unsigned char*>(function.m_storage.m_buffer));
+        }
+
+        static Callable& callable(const CallbackFunction& function, std::false_type)
+        {
+            return *static_cast<Callable*>(function.m_storage.m_object);
+        }
+
+
+
+        // Construction of the callable in the
+        // storage of a function
+
+        template<typename...Arguments>
+
+        static void construct(CallbackFunction& function, Arguments&&...arguments)
+        {
+            construct(IsInline(), function, std::forward<Arguments>(arguments)...);
+
+            function.m_operations = operations();
+        }
+
+        template<typename...Arguments>
+
+        static void construct(std::true_type, CallbackFunction& function, Arguments&&...arguments)
+        {
+            ::new(static_cast<void*>(function.m_storage.m_buffer)) Callable(std::forward<Arguments>(arguments)...);
+        }
+
+        template<typename...Arguments>
+
+        static void construct(std::false_type, CallbackFunction& function, Arguments&&...arguments)
+        {
+            CallableAllocatorType callableAllocator(function.m_allocator);
+
+            Callable* object = CallableAllocatorTraits::allocate(callableAllocator, 1);
+
+            try
+            {
+                CallableAllocatorTraits::construct(callableAllocator, object, std::forward<Arguments>(arguments)...);
+            }
+            catch(...)
+            {
+                CallableAllocatorTraits::deallocate(callableAllocator, object, 1);
+                throw;
+            }
+
+            function.m_storage.m_object = object;
+        }
+
+
+
+        // Destruction of the callable
+
+        static void destroy(CallbackFunction& function)
+        {
+            destroy(IsInline(), function);
+
+            function.m_operations = nullptr;
+        }
+
+        static void destroy(std::true_type, CallbackFunction& function)
+        {
+            callable(function).~Callable();
+        }
+
+        static void destroy(std::false_type, CallbackFunction& function)
+        {
+            CallableAllocatorType callableAllocator(function.m_allocator);
+
+            Callable* object = static_cast<Callable*>(function.m_storage.m_object);
+
+            CallableAllocatorTraits::destroy(callableAllocator, object);
+            CallableAllocatorTraits::deallocate(callableAllocator, object, 1);
+        }
+
+
+
+        // Invocation of the callable
+
+        static CallbackReturnType invoke(const CallbackFunction& function, CallbackArguments&&...arguments)
+        {
+            return invoke(std::is_void<CallbackReturnType>(), callable(function), std::forward<CallbackArguments>(arguments)...);
+        }
+
+        static CallbackReturnType invoke(std::false_type, Callable& object, CallbackArguments&&...arguments)
+        {
+            return object(std::forward<CallbackArguments>(arguments)...);
+        }
+
+        static void invoke(std::true_type, Callable& object, CallbackArguments&&...arguments)
+        {
+            object(std::forward<CallbackArguments>(arguments)...);
+        }
+
+
+
+        // Copy and move of the callable to another function
+        // (a move steals the allocated callable, which is
+        // only allowed between equal allocators, while a
+        // relocation moves it to the other allocator)
+
+        static void copy(const CallbackFunction& source, CallbackFunction& destination)
+        {
+            construct(destination, callable(source));
+        }
+
+        static void move(CallbackFunction& source, CallbackFunction& destination)
+        {
+            move(IsInline(), source, destination);
+        }
+
+        static void move(std::true_type, CallbackFunction& source, CallbackFunction& destination)
+        {
+            relocate(source, destination);
+        }
+
+        static void move(std::false_type, CallbackFunction& source, CallbackFunction& destination)
+        {
+            destination.m_storage.m_object = source.m_storage.m_object;
+            destination.m_operations = source.m_operations;
+            source.m_operations = nullptr;
+        }
+
+        static void relocate(CallbackFunction& source, CallbackFunction& destination)
+        {
+            construct(destination, std::move(callable(source)));
+            destroy(source);
+        }
+    };
+
+
+
+private: // Private functions
+
+
+
+    template<typename Callable>
+
+    void store(Callable&& callable)
+    {
+        using CallableType = typename std::decay<Callable>::type;
+
+        if(is_empty(callable))
+            return;
+
+        CallableOperations<CallableType>::construct(*this, std::forward<Callable>(callable));
+    }
+
+
+
+    // Null function pointers and empty std::functions
+    // make an empty function (like std::function)
+
+    template<typename Callable>
+
+    static bool is_empty(const Callable& callable)
+    {
+        return is_empty(callable, std::integral_constant<bool, std::is_pointer<Callable>::value ||
+                                                               std::is_member_pointer<Callable>::value>());
+    }
+
+    template<typename Callable>
+
+    static bool is_empty(const Callable& callable, std::true_type)
+    {
+        return callable == nullptr;
+    }
+
+    template<typename Callable>
+
+    static bool is_empty(const Callable&, std::false_type)
+    {
+        return false;
+    }
+
+    template<typename Signature>
+
+    static bool is_empty(const std::function<Signature>& callable)
+    {
+        return !callable;
+    }
+
+
+
+    // Function used to take over the callable of another
+    // function (stealing its storage if both functions
+    // share the same allocator)
+
+    void adopt(CallbackFunction& function)
+    {
+        if(!function.m_operations)
+            return;
+
+        if(m_allocator == function.m_allocator)
+            function.m_operations->m_move(function, *this);
+        else
+            function.m_operations->m_relocate(function, *this);
+    }
+
+
+
+    void reset()
+    {
+        if(m_operations)
+            m_operations->m_destroy(*this);
+    }
+
+
+
+private: // Private variables
+
+
+
+    // The allocator of the callable (when not inline)
+
+    Allocator                           m_allocator;
+
+
+
+    // The operations on the stored callable
+    // (nullptr if the function is empty)
+
+    const Operations*                   m_operations = nullptr;
+
+
+
+    // The callable (stored inline or allocated)
+
+    union Storage
+    {
+        void*                           m_object;
+        alignas(void*) unsigned char    m_buffer[s_inlineCapacity];
+    }                                   m_storage;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// CallbackFunction can be moved to the allocator of a callback system
+//-------------------------------------------------------------------
+template<typename Signature, typename Allocator, std::size_t InlineCapacity>
+
+struct IsAllocatorAwareFunction<CallbackFunction<Signature,Allocator,InlineCapacity>> : std::true_type
+{
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of CallbacksLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // CALLBACKS_FUNCTION_HPP
@@ -0,0 +1,356 @@
+#ifndef CALLBACKS_ID_INDEX_HPP
+#define CALLBACKS_ID_INDEX_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Packed ID index for the callback systems defined in callbacks.hpp, meant
+/// for callback systems holding many callbacks that are de-registered
+/// individually
+///
+/// -- Without an index, de-registering a callback compares the IDs of the
+///    registered callbacks one by one, loading a whole callback (48 bytes
+///    with std::function) for each 8-byte ID.  The packed index keeps a copy
+///    of the IDs side by side, in the same order as the callbacks, so the
+///    search reads 8 IDs per cache line:
+///
+///        CallbacksLIB::IndexedCallbacks<void,const Event&> callbacks;
+///
+/// -- The packed IDs are compared 4 at a time with AVX2 or 2 at a time with
+///    SSE4.1, chosen at runtime from what the processor supports (the
+///    compiler doesn't need to target it), with a scalar loop elsewhere
+///
+/// -- The index is updated with the callbacks: inserting or erasing one
+///    callback moves the following IDs by one slot (8 bytes each instead of
+///    the whole callbacks), and the passes that remove or add several
+///    callbacks at once rebuild it
+///
+/// -- The IDs are stored in a std::vector (on the heap), and cloning the
+///    callback system copies them, even with a copy-on-write storage
+///
+/// -- The ID index can be combined with the other policies:
+///
+///        BasicCallbacks<PackedIdIndexCallbacksPolicy<SegmentedCallbacksPolicy<>>,void,int> callbacks;
+///
+///
+///
+/// Note: This class is defined within the namespace CallbacksLIB
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CALLBACKS_HAS_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Classes are defined within the namespace CallbacksLIB
+//-------------------------------------------------------------------
+namespace CallbacksLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Functions used to find an ID in an array of packed IDs (they
+// return the number of IDs if it's not there)
+//-------------------------------------------------------------------
+class PackedCallbackIdSearch
+{
+public: // Public typedefs
+
+
+
+    using FindFunction = std::size_t(*)(const CallbackID*, std::size_t, CallbackID);
+
+
+
+public: // Public functions
+
+
+
+    // Function used to find an ID with the fastest
+    // search the processor supports
+
+    static std::size_t find(const CallbackID* ids, std::size_t numberOfIds, CallbackID callbackID)
+    {
+        static const FindFunction findFunction = select_find_function();
+
+        return findFunction(ids, numberOfIds, callbackID);
+    }
+
+
+
+    // Function used to get the name of the search used
+    // by find() ("avx2", "sse4.1" or "scalar")
+
+    static const char* instruction_set()
+    {
+        FindFunction findFunction = select_find_function();
+
+#ifdef CALLBACKS_HAS_X86_DISPATCH
+        if(findFunction == &find_avx2)
+            return "avx2";
+
+        if(findFunction == &find_sse41)
+            return "sse4.1";
+#endif
+
+        (void)findFunction;
+
+        return "scalar";
+    }
+
+
+
+    static std::size_t find_scalar(const CallbackID* ids, std::size_t numberOfIds, CallbackID callbackID)
+    {
+        for(std::size_t i = 0; i < numberOfIds; ++i)
+        {
+            if(ids[i] == callbackID)
+                return i;
+        }
+
+        return numberOfIds;
+    }
+
+
+
+#ifdef CALLBACKS_HAS_X86_DISPATCH
+
+    // Compares 8 IDs per iteration (two 256-bit loads
+    // whose comparisons are merged before testing them)
+
+    __attribute__((target("avx2")))
+    static std::size_t find_avx2(const CallbackID* ids, std::size_t numberOfIds, CallbackID callbackID)
+    {
+        const __m256i key = _mm256_set1_epi64x(static_cast<long long>(callbackID));
+
+        std::size_t i = 0;
+
+        for(; i + 8 <= numberOfIds; i += 8)
+        {
+            __m256i first = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ids + i)), key);
+            __m256i second = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ids + i + 4)), key);
+
+            if(!_mm256_testz_si256(_mm256_or_si256(first, second), _mm256_or_si256(first, second)))
+                return i + find_scalar(ids + i, 8, callbackID);
+        }
+
+        return i + find_scalar(ids + i, numberOfIds - i, callbackID);
+    }
+
+
+
+    // Compares 4 IDs per iteration (two 128-bit loads
+    // whose comparisons are merged before testing them)
+
+    __attribute__((target("sse4.1")))
+    static std::size_t find_sse41(const CallbackID* ids, std::size_t numberOfIds, CallbackID callbackID)
+    {
+        const __m128i key = _mm_set1_epi64x(static_cast<long long>(callbackID));
+
+        std::size_t i = 0;
+
+        for(; i + 4 <= numberOfIds; i += 4)
+        {
+            __m128i first = _mm_cmpeq_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ids + i)), key);
+            __m128i second = _mm_cmpeq_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ids + i + 2)), key);
+
+            if(!_mm_testz_si128(_mm_or_si128(first, second), _mm_or_si128(first, second)))
+                return i + find_scalar(ids + i, 4, callbackID);
+        }
+
+        return i + find_scalar(ids + i, numberOfIds - i, callbackID);
+    }
+
+#endif
+
+
+
+private: // Private functions
+
+
+
+    // Function used to choose the search once, from
+    // what the processor supports
+
+    static FindFunction select_find_function()
+    {
+#ifdef CALLBACKS_HAS_X86_DISPATCH
+        __builtin_cpu_init();
+
+        if(__builtin_cpu_supports("avx2"))
+            return &find_avx2;
+
+        if(__builtin_cpu_supports("sse4.1"))
+            return &find_sse41;
+#endif
+
+        return &find_scalar;
+    }
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// ID index keeping a packed copy of the IDs of the callbacks, in the
+// same order as the callbacks
+//-------------------------------------------------------------------
+class PackedCallbackIdIndex
+{
+public: // Public functions
+
+
+
+    // Function used to find the index of the callback with
+    // the specified ID (returns the number of callbacks if
+    // there is none)
+
+    template<typename ContainerType>
+
+    std::size_t find(const ContainerType& callbacks, CallbackID callbackID)const
+    {
+        std::size_t i = PackedCallbackIdSearch::find(m_ids.data(), m_ids.size(), callbackID);
+
+        return (i < m_ids.size()) ? i : callbacks.size();
+    }
+
+
+
+    // Functions called when a callback is inserted at or
+    // erased from the specified index
+
+    void insert(std::size_t index, CallbackID callbackID)
+    {
+        m_ids.insert(m_ids.begin() + index, callbackID);
+    }
+
+    void erase(std::size_t index)
+    {
+        m_ids.erase(m_ids.begin() + index);
+    }
+
+
+
+    // Function called when room is made for the
+    // specified number of callbacks
+
+    void reserve(std::size_t numberOfCallbacks)
+    {
+        m_ids.reserve(numberOfCallbacks);
+    }
+
+
+
+    // Functions called when the callbacks were rearranged
+    // (several of them added or removed in one pass), or
+    // all removed
+
+    template<typename ContainerType>
+
+    void rebuild(const ContainerType& callbacks)
+    {
+        m_ids.reserve(callbacks.size());
+        m_ids.clear();
+
+        for(const auto& callback : callbacks)
+            m_ids.push_back(callback.m_id);
+    }
+
+    void clear()
+    {
+        m_ids.clear();
+    }
+
+
+
+    // Function used to get the packed IDs
+
+    const std::vector<CallbackID>& ids()const
+    {
+        return m_ids;
+    }
+
+
+
+private: // Private variables
+
+
+
+    std::vector<CallbackID>             m_ids;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Policy finding the callbacks through a packed ID index (the other
+// options are taken from the base policy)
+//-------------------------------------------------------------------
+template<typename BasePolicy = DefaultCallbacksPolicy>
+
+struct PackedIdIndexCallbacksPolicy : BasePolicy
+{
+    using IdIndexType = PackedCallbackIdIndex;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Aliases of the indexed callback systems
+//-------------------------------------------------------------------
+template<typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using IndexedCallbacks = BasicCallbacks<PackedIdIndexCallbacksPolicy<>,CallbackReturnType,CallbackArguments...>;
+
+
+
+template<typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using IndexedCallbacksReturningAContainer = BasicCallbacksReturningAContainer<PackedIdIndexCallbacksPolicy<>,CallbackReturnType,CallbackArguments...>;
+
+
+
+template<typename...CallbackArguments>
+
+using IndexedCallbacksReturningABoolean = BasicCallbacksReturningABoolean<PackedIdIndexCallbacksPolicy<>,CallbackArguments...>;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of CallbacksLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // CALLBACKS_ID_INDEX_HPP
@@ -0,0 +1,606 @@
+#ifndef CALLBACKS_INSTRUMENTATION_HPP
+#define CALLBACKS_INSTRUMENTATION_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Optional instrumentation for the callback systems defined in
+/// callbacks.hpp, which records how many times each callback was invoked
+/// and how long each invocation took
+///
+/// -- The instrumentation is selected through the policy of the callback
+///    system, so callback systems using the default policy don't pay for it:
+///
+///        BasicCallbacks<LatencyInstrumentedCallbacksPolicy,void,int> callbacks;
+///
+///        ...
+///
+///        for(const auto& handler : callbacks.instrumentation().get_latency_snapshot())
+///            std::cout << handler.m_callbackID << ": " << handler.m_p99Nanoseconds << std::endl;
+///
+/// -- Invocations are timed with a cheap cycle counter (the time stamp
+///    counter on x86, the virtual counter on ARM64) and recorded in
+///    HDR-style histograms (log-linear buckets with a ~3% precision),
+///    from which the latency percentiles are computed
+///
+/// -- The statistics of a callback are kept while it is registered.  When
+///    it is removed, they are folded into the statistics of all the removed
+///    callbacks and its histogram is reused, so the memory used stays
+///    bounded by the number of callbacks registered at the same time
+///
+///
+///
+/// Note: This class is defined within the namespace CallbacksLIB
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Classes are defined within the namespace CallbacksLIB
+//-------------------------------------------------------------------
+namespace CallbacksLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Class used to read a cheap, monotonic cycle counter and convert
+// its ticks to nanoseconds
+//-------------------------------------------------------------------
+class CycleCounter
+{
+public: // Public functions
+
+
+
+    // Function used to read the counter
+
+    static std::uint64_t now()
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        std::uint64_t ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+#else
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+
+
+    // Function used to get the duration of a tick
+    // (calibrated once against the steady clock)
+
+    static double nanoseconds_per_tick()
+    {
+        static const double nanosecondsPerTick = calibrate();
+
+        return nanosecondsPerTick;
+    }
+
+
+
+private: // Private functions
+
+
+
+    static double calibrate()
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        std::uint64_t startTicks = now();
+
+        while(std::chrono::steady_clock::now() - startTime < std::chrono::milliseconds(2))
+        {
+        }
+
+        auto endTime = std::chrono::steady_clock::now();
+        std::uint64_t endTicks = now();
+
+        double elapsedNanoseconds = std::chrono::duration<double,std::nano>(endTime - startTime).count();
+
+        return (endTicks > startTicks) ? elapsedNanoseconds / static_cast<double>(endTicks - startTicks) : 1.0;
+    }
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// HDR-style histogram of durations (in ticks)
+//
+// Durations below 32 ticks have their own bucket, then each power
+// of two is split in 32 linear sub-buckets, so recorded values are
+// precise to about 3%.  Durations of 2^40 ticks or more (several
+// minutes) are recorded in the last bucket
+//-------------------------------------------------------------------
+class LatencyHistogram
+{
+public: // Public constants
+
+
+
+    static const int            s_subBucketBits = 5;
+    static const int            s_subBucketCount = 1 << s_subBucketBits;
+    static const int            s_maximumExponent = 40;
+    static const int            s_numberOfBuckets = (s_maximumExponent - s_subBucketBits + 1) * s_subBucketCount;
+
+
+
+public: // Constructors and destructor
+
+
+
+    LatencyHistogram() : m_counts(s_numberOfBuckets, 0){}
+    LatencyHistogram(const LatencyHistogram&) = default;
+    LatencyHistogram(LatencyHistogram&&) = default;
+    ~LatencyHistogram(){}
+
+    LatencyHistogram& operator=(const LatencyHistogram&) = default;
+    LatencyHistogram& operator=(LatencyHistogram&&) = default;
+
+
+
+public: // Public functions
+
+
+
+    // Function used to add the durations recorded
+    // by another histogram
+
+    void merge(const LatencyHistogram& histogram)
+    {
+        for(int i = 0; i < s_numberOfBuckets; ++i)
+            m_counts[i] += histogram.m_counts[i];
+
+        m_totalCount += histogram.m_totalCount;
+
+        if(histogram.m_maximumTicks > m_maximumTicks)
+            m_maximumTicks = histogram.m_maximumTicks;
+    }
+
+
+
+    // Function used to discard the recorded durations
+    // (keeping the buckets allocated)
+
+    void clear()
+    {
+        std::fill(m_counts.begin(), m_counts.end(), 0);
+
+        m_totalCount = 0;
+        m_maximumTicks = 0;
+    }
+
+
+
+    // Function used to record a duration
+
+    void record(std::uint64_t ticks)
+    {
+        ++m_counts[bucket_index(ticks)];
+        ++m_totalCount;
+
+        if(ticks > m_maximumTicks)
+            m_maximumTicks = ticks;
+    }
+
+
+
+    // Function used to get the duration (in ticks)
+    // below which the specified percentage of the
+    // recorded durations fall
+
+    double value_at_percentile(double percentile)const
+    {
+        if(m_totalCount == 0)
+            return 0;
+
+        std::uint64_t targetCount = static_cast<std::uint64_t>(percentile / 100.0 * static_cast<double>(m_totalCount) + 0.5);
+
+        if(targetCount < 1)
+            targetCount = 1;
+
+        std::uint64_t cumulativeCount = 0;
+
+        for(int i = 0; i < s_numberOfBuckets; ++i)
+        {
+            cumulativeCount += m_counts[i];
+
+            if(cumulativeCount >= targetCount)
+            {
+                double value = bucket_lower_bound(i) + 0.5 * (bucket_width(i) - 1);
+
+                return (value < static_cast<double>(m_maximumTicks)) ? value : static_cast<double>(m_maximumTicks);
+            }
+        }
+
+        return static_cast<double>(m_maximumTicks);
+    }
+
+
+
+    std::uint64_t total_count()const
+    {
+        return m_totalCount;
+    }
+
+
+
+    std::uint64_t maximum()const
+    {
+        return m_maximumTicks;
+    }
+
+
+
+private: // Private functions
+
+
+
+    static int most_significant_bit(std::uint64_t value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(value);
+#else
+        int bit = 0;
+
+        while(value >>= 1)
+            ++bit;
+
+        return bit;
+#endif
+    }
+
+
+
+    static int bucket_index(std::uint64_t ticks)
+    {
+        if(ticks < static_cast<std::uint64_t>(s_subBucketCount))
+            return static_cast<int>(ticks);
+
+        int exponent = most_significant_bit(ticks);
+
+        if(exponent >= s_maximumExponent)
+            return s_numberOfBuckets - 1;
+
+        int shift = exponent - s_subBucketBits;
+        int subBucket = static_cast<int>(ticks >> shift) - s_subBucketCount;
+
+        return (shift + 1) * s_subBucketCount + subBucket;
+    }
+
+
+
+    static double bucket_lower_bound(int index)
+    {
+        if(index < s_subBucketCount)
+            return index;
+
+        int shift = index / s_subBucketCount - 1;
+        int subBucket = index % s_subBucketCount;
+
+        return static_cast<double>(static_cast<std::uint64_t>(s_subBucketCount + subBucket) << shift);
+    }
+
+
+
+    static double bucket_width(int index)
+    {
+        if(index < s_subBucketCount)
+            return 1;
+
+        return static_cast<double>(std::uint64_t(1) << (index / s_subBucketCount - 1));
+    }
+
+
+
+private: // Private variables
+
+
+
+    std::vector<std::uint64_t>          m_counts;
+    std::uint64_t                       m_totalCount = 0;
+    std::uint64_t                       m_maximumTicks = 0;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Latency summary of a callback
+//-------------------------------------------------------------------
+struct CallbackLatencySnapshot
+{
+    CallbackID                          m_callbackID = 0;
+    std::uint64_t                       m_numberOfCalls = 0;
+    double                              m_p50Nanoseconds = 0;
+    double                              m_p99Nanoseconds = 0;
+    double                              m_p999Nanoseconds = 0;
+    double                              m_maximumNanoseconds = 0;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Instrumentation recording the number of calls and a latency
+// histogram for each registered callback
+//
+// NOTE:  When a callback is removed, its statistics are folded
+//        into those of the removed callbacks (see the function
+//        get_removed_callbacks_latency_snapshot()) and its
+//        histogram is kept to be reused by a later callback
+//-------------------------------------------------------------------
+class LatencyInstrumentation
+{
+public: // Public functions
+
+
+
+    // Function wrapped around each invocation of
+    // all the callbacks (not measured)
+
+    template<typename InvokeFunction>
+
+    auto measure_invocation(const void* callbacks, const char* invokerName, InvokeFunction&& invokeFunction) -> decltype(invokeFunction())
+    {
+        (void)callbacks;
+        (void)invokerName;
+
+        return invokeFunction();
+    }
+
+
+
+    // Function wrapped around each callback invocation
+
+    template<typename InvokeFunction>
+
+    auto measure(CallbackID callbackID, InvokeFunction&& invokeFunction) -> decltype(invokeFunction())
+    {
+        auto histogram = m_histograms.find(callbackID);
+
+        if(histogram == m_histograms.end())
+            histogram = add_histogram(callbackID);
+
+        Recorder recorder(histogram->second);
+
+        return invokeFunction();
+    }
+
+
+
+    // Function used to get the latency summary of every
+    // registered callback that has been invoked at least
+    // once
+
+    std::vector<CallbackLatencySnapshot> get_latency_snapshot()const
+    {
+        std::vector<CallbackLatencySnapshot> snapshot;
+
+        snapshot.reserve(m_histograms.size());
+
+        for(const auto& histogram : m_histograms)
+            snapshot.push_back(create_snapshot(histogram.first, histogram.second));
+
+        return snapshot;
+    }
+
+
+
+    // Function used to get the latency summary of
+    // a single callback (the number of calls is zero
+    // if the callback has never been invoked or has
+    // been removed)
+
+    CallbackLatencySnapshot get_latency_snapshot(CallbackID callbackID)const
+    {
+        auto histogram = m_histograms.find(callbackID);
+
+        if(histogram == m_histograms.end())
+        {
+            CallbackLatencySnapshot emptySnapshot;
+            emptySnapshot.m_callbackID = callbackID;
+            return emptySnapshot;
+        }
+
+        return create_snapshot(callbackID, histogram->second);
+    }
+
+
+
+    // Function used to get the latency summary of all
+    // the callbacks that have been removed (its ID is 0)
+
+    CallbackLatencySnapshot get_removed_callbacks_latency_snapshot()const
+    {
+        return create_snapshot(0, m_removedCallbacksHistogram);
+    }
+
+
+
+    // Functions called when callbacks are removed, which
+    // fold their statistics into those of the removed
+    // callbacks and keep their histograms for reuse
+
+    void forget(CallbackID callbackID)
+    {
+        auto histogram = m_histograms.find(callbackID);
+
+        if(histogram == m_histograms.end())
+            return;
+
+        recycle_histogram(histogram->second);
+
+        m_histograms.erase(histogram);
+    }
+
+    void forget_all()
+    {
+        for(auto& histogram : m_histograms)
+            recycle_histogram(histogram.second);
+
+        m_histograms.clear();
+    }
+
+
+
+    // Function used to discard all the statistics
+
+    void reset()
+    {
+        for(auto& histogram : m_histograms)
+        {
+            histogram.second.clear();
+            m_spareHistograms.push_back(std::move(histogram.second));
+        }
+
+        m_histograms.clear();
+        m_removedCallbacksHistogram.clear();
+    }
+
+
+
+private: // Private classes
+
+
+
+    // Helper recording the duration of an invocation
+    // when it goes out of scope (so that invocations
+    // returning void or throwing are recorded too)
+
+    class Recorder
+    {
+    public:
+
+        Recorder(LatencyHistogram& histogram) : m_histogram(histogram), m_startTicks(CycleCounter::now()){}
+        ~Recorder(){ m_histogram.record(CycleCounter::now() - m_startTicks); }
+
+    private:
+
+        LatencyHistogram&               m_histogram;
+        std::uint64_t                   m_startTicks;
+    };
+
+
+
+private: // Private functions
+
+
+
+    // Function used to add the histogram of a callback
+    // invoked for the first time (reusing the histogram
+    // of a removed callback when there is one)
+
+    std::unordered_map<CallbackID,LatencyHistogram>::iterator add_histogram(CallbackID callbackID)
+    {
+        if(m_spareHistograms.empty())
+            return m_histograms.emplace(callbackID, LatencyHistogram()).first;
+
+        auto histogram = m_histograms.emplace(callbackID, std::move(m_spareHistograms.back())).first;
+
+        m_spareHistograms.pop_back();
+
+        return histogram;
+    }
+
+
+
+    void recycle_histogram(LatencyHistogram& histogram)
+    {
+        m_removedCallbacksHistogram.merge(histogram);
+
+        histogram.clear();
+
+        m_spareHistograms.push_back(std::move(histogram));
+    }
+
+
+
+    static CallbackLatencySnapshot create_snapshot(CallbackID callbackID, const LatencyHistogram& histogram)
+    {
+        double nanosecondsPerTick = CycleCounter::nanoseconds_per_tick();
+
+        CallbackLatencySnapshot snapshot;
+
+        snapshot.m_callbackID = callbackID;
+        snapshot.m_numberOfCalls = histogram.total_count();
+        snapshot.m_p50Nanoseconds = histogram.value_at_percentile(50.0) * nanosecondsPerTick;
+        snapshot.m_p99Nanoseconds = histogram.value_at_percentile(99.0) * nanosecondsPerTick;
+        snapshot.m_p999Nanoseconds = histogram.value_at_percentile(99.9) * nanosecondsPerTick;
+        snapshot.m_maximumNanoseconds = static_cast<double>(histogram.maximum()) * nanosecondsPerTick;
+
+        return snapshot;
+    }
+
+
+
+private: // Private variables
+
+
+
+    // The latency histogram of each registered callback,
+    // the histogram of all the removed callbacks, and the
+    // histograms kept for reuse
+
+    std::unordered_map<CallbackID,LatencyHistogram> m_histograms;
+    LatencyHistogram                                m_removedCallbacksHistogram;
+    std::vector<LatencyHistogram>                   m_spareHistograms;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Policy enabling the latency instrumentation
+//-------------------------------------------------------------------
+struct LatencyInstrumentedCallbacksPolicy : DefaultCallbacksPolicy
+{
+    using InstrumentationType = LatencyInstrumentation;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of CallbacksLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // CALLBACKS_INSTRUMENTATION_HPP
@@ -0,0 +1,642 @@
+#ifndef CALLBACKS_RECLAMATION_HPP
+#define CALLBACKS_RECLAMATION_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Optional deferred destruction for the callback systems defined in
+/// callbacks.hpp, which hands the removed callbacks to a background thread
+/// instead of destroying them on the thread that removed them
+///
+/// -- Destroying a callable runs the destructors of everything it captured
+///    (freeing large buffers, releasing the last reference to a shared
+///    object...), which can take arbitrarily long.  With deferred
+///    reclamation, de-registering a callback only moves it to a queue, and
+///    deregister_all_callbacks() hands over the whole container of
+///    callbacks (the callback system gets an empty one with the same
+///    capacity):
+///
+///        BasicCallbacks<DeferredReclamationCallbacksPolicy,void,int> callbacks;
+///
+/// -- The callbacks are destroyed by a CallbacksReclaimer, which owns the
+///    background thread.  By default all the callback systems share the
+///    global one, but a callback system can use its own:
+///
+///        CallbacksReclaimer reclaimer;
+///
+///        callbacks.reclamation().set_reclaimer(reclaimer);
+///
+/// -- Queuing removed callbacks takes a lock for a few instructions, but
+///    never runs the destructors of the captured state.  The callbacks
+///    removed together (the one-shot callbacks used up by an invocation, a
+///    bulk de-registration...) are queued as a single batch
+///
+/// -- The removed callbacks are carried to the reclaimer by two holders
+///    per callback system, which take turns and are reused (with the
+///    capacity of their container) once the reclaimer has emptied them, so
+///    in the steady state queuing doesn't allocate.  Only when both holders
+///    are still queued does a new holder get allocated
+///
+/// -- The global reclaimer is never destroyed (its thread is stopped by
+///    the end of the process), so callback systems destroyed during the
+///    destruction of the static objects can still use it
+///
+/// -- Callbacks whose storage or callables use a custom allocator (see
+///    callbacks_allocator.hpp) are destroyed right away, since the memory
+///    they give back might belong to a resource that is not thread-safe or
+///    that doesn't outlive the callback system
+///
+/// -- The captured state is destroyed on the background thread, so its
+///    destructors must not depend on the thread that registered it
+///
+/// -- Callbacks still registered when the callback system is destroyed are
+///    destroyed right away (by the destructor of the callback system)
+///
+///
+///
+/// Note: This class is defined within the namespace CallbacksLIB
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Classes are defined within the namespace CallbacksLIB
+//-------------------------------------------------------------------
+namespace CallbacksLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Background thread destroying the objects queued by the callback
+// systems
+//-------------------------------------------------------------------
+class CallbacksReclaimer
+{
+public: // Constructors and destructor
+
+
+
+    CallbacksReclaimer() : m_thread(&CallbacksReclaimer::run, this){}
+
+
+
+    // The destructor destroys the objects that are
+    // still queued and stops the thread
+
+    ~CallbacksReclaimer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isStopping = true;
+        }
+
+        m_wakeUp.notify_one();
+        m_thread.join();
+    }
+
+
+
+    CallbacksReclaimer(const CallbacksReclaimer&) = delete;
+    CallbacksReclaimer& operator=(const CallbacksReclaimer&) = delete;
+
+
+
+public: // Public functions
+
+
+
+    // The reclaimer shared by the callback systems that
+    // don't specify their own (leaked on purpose, so that
+    // it outlives the static objects using it)
+
+    static CallbacksReclaimer& global()
+    {
+        static CallbacksReclaimer* reclaimer = new CallbacksReclaimer();
+
+        return *reclaimer;
+    }
+
+
+
+    // Type-erased queued object, whose destroy() function
+    // is called on the background thread (the holder
+    // itself is destroyed once nothing refers to it, so
+    // it can be kept to be queued again)
+
+    class Garbage
+    {
+    public:
+
+        virtual ~Garbage(){}
+
+        virtual void destroy(){}
+    };
+
+
+
+    // Function used to queue an object, which is destroyed
+    // later on the background thread
+
+    template<typename ObjectType>
+
+    void reclaim(ObjectType&& object)
+    {
+        reclaim_garbage(std::make_shared<GarbageHolder<typename std::decay<ObjectType>::type>>(std::forward<ObjectType>(object)));
+    }
+
+
+
+    // Function used to queue a holder (its destroy()
+    // function is called on the background thread)
+
+    void reclaim_garbage(std::shared_ptr<Garbage> garbage)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_queue.push_back(std::move(garbage));
+            ++m_numberOfQueuedObjects;
+        }
+
+        m_wakeUp.notify_one();
+    }
+
+
+
+    // Function used to wait until all the objects queued
+    // so far have been destroyed
+
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        std::uint64_t numberOfQueuedObjects = m_numberOfQueuedObjects;
+
+        m_reclaimed.wait(lock, [&]{ return m_numberOfReclaimedObjects >= numberOfQueuedObjects; });
+    }
+
+
+
+    // Function used to get how many objects have been
+    // destroyed by the background thread
+
+    std::uint64_t get_number_of_reclaimed_objects()const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        return m_numberOfReclaimedObjects;
+    }
+
+
+
+private: // Private classes
+
+
+
+    template<typename ObjectType>
+
+    class GarbageHolder : public Garbage
+    {
+    public:
+
+        template<typename Object>
+
+        explicit GarbageHolder(Object&& object) : m_object(std::forward<Object>(object)){}
+
+    private:
+
+        ObjectType                      m_object;
+    };
+
+
+
+private: // Private functions
+
+
+
+    // The background thread swaps the queue out and
+    // destroys its objects without holding the lock
+    // (swapping the queue back and forth keeps the
+    // capacity of both vectors)
+
+    void run()
+    {
+        std::vector<std::shared_ptr<Garbage>> garbage;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while(true)
+        {
+            m_wakeUp.wait(lock, [&]{ return m_isStopping || !m_queue.empty(); });
+
+            if(m_queue.empty() && m_isStopping)
+                return;
+
+            garbage.swap(m_queue);
+
+            lock.unlock();
+
+            std::size_t numberOfObjects = garbage.size();
+
+            for(const auto& queuedGarbage : garbage)
+                queuedGarbage->destroy();
+
+            garbage.clear();
+
+            lock.lock();
+
+            m_numberOfReclaimedObjects += numberOfObjects;
+
+            m_reclaimed.notify_all();
+        }
+    }
+
+
+
+private: // Private variables
+
+
+
+    mutable std::mutex                      m_mutex;
+    std::condition_variable                 m_wakeUp;
+    std::condition_variable                 m_reclaimed;
+
+
+
+    // The objects waiting to be destroyed
+
+    std::vector<std::shared_ptr<Garbage>>   m_queue;
+
+
+
+    // Counters (used by flush())
+
+    std::uint64_t                           m_numberOfQueuedObjects = 0;
+    std::uint64_t                           m_numberOfReclaimedObjects = 0;
+
+
+
+    bool                                    m_isStopping = false;
+
+
+
+    // The background thread (started last, once
+    // all the other members are initialized)
+
+    std::thread                             m_thread;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Trait telling whether an allocator takes its memory from the heap
+// (the memory it gives back can then be freed by any thread)
+//-------------------------------------------------------------------
+template<typename AllocatorType>
+
+struct IsHeapAllocator : std::is_same<typename std::allocator_traits<AllocatorType>::template rebind_alloc<char>,
+                                      std::allocator<char>>
+{
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Trait telling whether a callable type gives back its memory to the
+// heap (callables without an allocator, like std::function, do)
+//-------------------------------------------------------------------
+template<typename FunctionType, typename = void>
+
+struct HasHeapFunctionAllocator : std::true_type
+{
+};
+
+template<typename FunctionType>
+
+struct HasHeapFunctionAllocator<FunctionType,
+                                decltype(void(std::declval<const FunctionType&>().get_allocator()))> :
+    IsHeapAllocator<decltype(std::declval<const FunctionType&>().get_allocator())>
+{
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Reclamation policy handing the removed callbacks to a reclaimer
+//-------------------------------------------------------------------
+class DeferredReclamation
+{
+public: // Constructors and destructor
+
+
+
+    DeferredReclamation() = default;
+
+
+
+    // The batch being built and the holders are not
+    // copied, only the reclaimer that is used
+
+    DeferredReclamation(const DeferredReclamation& reclamation) : m_reclaimer(reclamation.m_reclaimer){}
+    DeferredReclamation(DeferredReclamation&& reclamation) = default;
+
+    DeferredReclamation& operator=(const DeferredReclamation& reclamation)
+    {
+        m_reclaimer = reclamation.m_reclaimer;
+        return *this;
+    }
+
+    DeferredReclamation& operator=(DeferredReclamation&& reclamation) = default;
+
+
+
+public: // Public functions
+
+
+
+    // Functions used to choose the reclaimer destroying
+    // the callbacks (the global one by default)
+
+    void set_reclaimer(CallbacksReclaimer& reclaimer)
+    {
+        m_reclaimer = &reclaimer;
+    }
+
+    CallbacksReclaimer& reclaimer()const
+    {
+        return *m_reclaimer;
+    }
+
+
+
+    // Function called with a callback that is about to be
+    // removed (its slot is left with an empty callback),
+    // which adds it to the batch of the current pass
+
+    template<typename CallbackType>
+
+    void retire(CallbackType& callback)const
+    {
+        if(!HasHeapFunctionAllocator<typename CallbackType::CallbackFunctionType>::value)
+            return;
+
+        if(!m_batch)
+            m_batch.reset(new RetiredCallbacks<CallbackType>());
+
+        static_cast<RetiredCallbacks<CallbackType>&>(*m_batch).m_callbacks.push_back(std::move(callback));
+    }
+
+
+
+    // Function called to remove all the callbacks of a
+    // container (the callbacks are handed over, and the
+    // container is left empty with the same capacity)
+
+    template<typename ContainerType>
+
+    void retire_all(ContainerType& callbacks)const
+    {
+        using CallbackType = typename ContainerType::value_type;
+
+        if(callbacks.empty())
+            return;
+
+        if(!IsHeapAllocator<typename ContainerType::allocator_type>::value ||
+           !HasHeapFunctionAllocator<typename CallbackType::CallbackFunctionType>::value)
+        {
+            callbacks.clear();
+            return;
+        }
+
+        if(!m_retiredContainers)
+            m_retiredContainers.reset(new ContainerHolders<ContainerType>());
+
+        static_cast<ContainerHolders<ContainerType>&>(*m_retiredContainers).hand_over(callbacks, *m_reclaimer);
+    }
+
+
+
+    // Function called once a pass has retired the callbacks
+    // it removes, which queues them as a single batch
+
+    void end_pass()const
+    {
+        if(m_batch)
+            m_batch->queue(*m_reclaimer);
+    }
+
+
+
+private: // Private classes
+
+
+
+    // Holder carrying a container of removed callbacks to
+    // the reclaimer, which empties it (keeping its capacity)
+    // and marks it as free again
+
+    template<typename ContainerType>
+
+    class RetiredContainer : public CallbacksReclaimer::Garbage
+    {
+    public:
+
+        explicit RetiredContainer(const typename ContainerType::allocator_type& allocator) : m_container(allocator){}
+
+        void destroy() override
+        {
+            m_container.clear();
+            m_isQueued.store(false, std::memory_order_release);
+        }
+
+        ContainerType                   m_container;
+        std::atomic<bool>               m_isQueued{false};
+    };
+
+
+
+    // The two holders of a callback system taking turns to
+    // carry its containers of removed callbacks
+
+    class ContainerHoldersBase
+    {
+    public:
+
+        virtual ~ContainerHoldersBase(){}
+    };
+
+
+
+    template<typename ContainerType>
+
+    class ContainerHolders : public ContainerHoldersBase
+    {
+    public:
+
+        // Function used to hand the callbacks of a container
+        // over to the reclaimer, leaving the container empty
+        // with (at least) the same capacity
+
+        void hand_over(ContainerType& callbacks, CallbacksReclaimer& reclaimer)
+        {
+            for(auto& holder : m_holders)
+            {
+                if(!holder)
+                    holder = std::make_shared<RetiredContainer<ContainerType>>(callbacks.get_allocator());
+
+                if(holder->m_isQueued.load(std::memory_order_acquire))
+                    continue;
+
+                // The holders only grow until they reach
+                // the capacity of the callback system
+
+                if(holder->m_container.capacity() < callbacks.capacity())
+                    holder->m_container.reserve(callbacks.capacity());
+
+                ContainerType retiredCallbacks(std::move(callbacks));
+
+                callbacks = std::move(holder->m_container);
+                holder->m_container = std::move(retiredCallbacks);
+
+                holder->m_isQueued.store(true, std::memory_order_relaxed);
+
+                reclaimer.reclaim_garbage(holder);
+                return;
+            }
+
+            // Both holders are still queued (the reclaimer
+            // is lagging behind), so the callbacks are queued
+            // in a new holder
+
+            ContainerType emptyCallbacks(callbacks.get_allocator());
+
+            emptyCallbacks.reserve(callbacks.capacity());
+
+            ContainerType retiredCallbacks(std::move(callbacks));
+
+            callbacks = std::move(emptyCallbacks);
+
+            reclaimer.reclaim(std::move(retiredCallbacks));
+        }
+
+    private:
+
+        std::shared_ptr<RetiredContainer<ContainerType>> m_holders[2];
+    };
+
+
+
+    // Batch of the callbacks retired by the current pass
+
+    class RetiredCallbacksBatch
+    {
+    public:
+
+        virtual ~RetiredCallbacksBatch(){}
+
+        virtual void queue(CallbacksReclaimer& reclaimer) = 0;
+    };
+
+
+
+    template<typename CallbackType>
+
+    class RetiredCallbacks : public RetiredCallbacksBatch
+    {
+    public:
+
+        void queue(CallbacksReclaimer& reclaimer) override
+        {
+            if(m_callbacks.empty())
+                return;
+
+            // The next batch gets the same capacity, so
+            // that a pass doesn't grow it one by one
+
+            m_holders.hand_over(m_callbacks, reclaimer);
+        }
+
+        std::vector<CallbackType>       m_callbacks;
+
+    private:
+
+        ContainerHolders<std::vector<CallbackType>> m_holders;
+    };
+
+
+
+private: // Private variables
+
+
+
+    CallbacksReclaimer*                 m_reclaimer = &CallbacksReclaimer::global();
+
+
+
+    // The batch of the current pass (empty between
+    // passes, kept with its capacity for the next one)
+
+    mutable std::unique_ptr<RetiredCallbacksBatch> m_batch;
+
+
+
+    // The holders carrying the containers handed over
+    // by retire_all()
+
+    mutable std::unique_ptr<ContainerHoldersBase> m_retiredContainers;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Policy enabling the deferred reclamation
+//-------------------------------------------------------------------
+struct DeferredReclamationCallbacksPolicy : DefaultCallbacksPolicy
+{
+    using ReclamationType = DeferredReclamation;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of CallbacksLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // CALLBACKS_RECLAMATION_HPP
@@ -0,0 +1,492 @@
+#ifndef CALLBACKS_SEGMENTED_HPP
+#define CALLBACKS_SEGMENTED_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Segmented storage for the callback systems defined in callbacks.hpp,
+/// which never relocates the registered callbacks when it grows
+///
+/// -- A std::vector moves every callback (and its callable) to a new buffer
+///    each time it outgrows its capacity, so the thread that happens to
+///    register at that point pays for all of them.  The segmented storage
+///    instead adds fixed-size segments, and the callbacks already
+///    registered stay where they are:
+///
+///        CallbacksLIB::SegmentedCallbacks<void,int> callbacks;
+///
+/// -- The segments are kept once allocated (they are only released when the
+///    callback system is destroyed), so registering and de-registering
+///    callbacks in steady state doesn't allocate.  Combined with reserve(),
+///    registration is allocation-free from the start:
+///
+///        callbacks.reserve(256);
+///
+/// -- The segmented storage can be combined with the other policies:
+///
+///        BasicCallbacks<SegmentedCallbacksPolicy<32,PmrCallbacksPolicy>,void,int> callbacks(&arena);
+///
+/// -- Callbacks registered with a higher priority than callbacks already
+///    registered are still inserted before them (shifting the following
+///    callbacks by one slot), and de-registered callbacks are compacted
+///
+///
+///
+/// Note: This class is defined within the namespace CallbacksLIB
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Classes are defined within the namespace CallbacksLIB
+//-------------------------------------------------------------------
+namespace CallbacksLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Vector storing its elements in segments of SegmentSize elements
+// (taken from its allocator), so that growing never moves the
+// elements already stored
+//
+// It provides the subset of the std::vector interface used by the
+// callback systems
+//-------------------------------------------------------------------
+template<typename T,
+         std::size_t SegmentSize,
+         typename Allocator = std::allocator<T>>
+
+class SegmentedVector
+{
+    static_assert(SegmentSize > 0 && (SegmentSize & (SegmentSize - 1)) == 0, "The segment size must be a power of two");
+
+private: // Private typedefs
+
+
+
+    using AllocatorTraits = std::allocator_traits<Allocator>;
+    using SegmentsAllocatorType = typename AllocatorTraits::template rebind_alloc<T*>;
+
+
+
+public: // Public classes
+
+
+
+    // Random access iterator (an index in the
+    // table of segments)
+
+    template<typename ValueType>
+
+    class Iterator
+    {
+    public:
+
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = typename std::remove_const<ValueType>::type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = ValueType*;
+        using reference = ValueType&;
+
+        Iterator(){}
+        Iterator(T* const* segments, std::size_t index) : m_segments(segments), m_index(index){}
+
+        template<typename OtherValueType,
+                 typename = typename std::enable_if<std::is_convertible<OtherValueType*,ValueType*>::value>::type>
+
+        Iterator(const Iterator<OtherValueType>& iterator) : m_segments(iterator.m_segments), m_index(iterator.m_index){}
+
+        reference operator*()const{ return m_segments[m_index / SegmentSize][m_index % SegmentSize]; }
+        pointer operator->()const{ return &**this; }
+        reference operator[](difference_type offset)const{ return *(*this + offset); }
+
+        Iterator& operator++(){ ++m_index; return *this; }
+        Iterator& operator--(){ --m_index; return *this; }
+        Iterator operator++(int){ Iterator iterator(*this); ++m_index; return iterator; }
+        Iterator operator--(int){ Iterator iterator(*this); --m_index; return iterator; }
+
+        Iterator& operator+=(difference_type offset){ m_index += offset; return *this; }
+        Iterator& operator-=(difference_type offset){ m_index -= offset; return *this; }
+
+        Iterator operator+(difference_type offset)const{ return Iterator(m_segments, m_index + offset); }
+        Iterator operator-(difference_type offset)const{ return Iterator(m_segments, m_index - offset); }
+        friend Iterator operator+(difference_type offset, const Iterator& iterator){ return iterator + offset; }
+
+        difference_type operator-(const Iterator& iterator)const{ return static_cast<difference_type>(m_index) - static_cast<difference_type>(iterator.m_index); }
+
+        bool operator==(const Iterator& iterator)const{ return m_index == iterator.m_index; }
+        bool operator!=(const Iterator& iterator)const{ return m_index != iterator.m_index; }
+        bool operator<(const Iterator& iterator)const{ return m_index < iterator.m_index; }
+        bool operator>(const Iterator& iterator)const{ return m_index > iterator.m_index; }
+        bool operator<=(const Iterator& iterator)const{ return m_index <= iterator.m_index; }
+        bool operator>=(const Iterator& iterator)const{ return m_index >= iterator.m_index; }
+
+    private:
+
+        template<typename OtherValueType> friend class Iterator;
+        friend class SegmentedVector;
+
+        T* const*                       m_segments = nullptr;
+        std::size_t                     m_index = 0;
+    };
+
+
+
+public: // Public typedefs
+
+
+
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+    using iterator = Iterator<T>;
+    using const_iterator = Iterator<const T>;
+
+
+
+public: // Constructors and destructor
+
+
+
+    SegmentedVector(){}
+
+    explicit SegmentedVector(const Allocator& allocator) :
+        m_allocator(allocator),
+        m_segments(SegmentsAllocatorType(allocator))
+    {
+    }
+
+
+
+    SegmentedVector(const SegmentedVector& vector) :
+        m_allocator(AllocatorTraits::select_on_container_copy_construction(vector.m_allocator)),
+        m_segments(SegmentsAllocatorType(m_allocator))
+    {
+        reserve(vector.size());
+
+        for(const auto& element : vector)
+            push_back(element);
+    }
+
+    SegmentedVector(SegmentedVector&& vector) :
+        m_allocator(vector.m_allocator),
+        m_segments(std::move(vector.m_segments)),
+        m_size(vector.m_size)
+    {
+        vector.m_segments.clear();
+        vector.m_size = 0;
+    }
+
+
+
+    ~SegmentedVector()
+    {
+        clear();
+        release();
+    }
+
+
+
+public: // Assignment operators (the vector keeps its own allocator)
+
+
+
+    SegmentedVector& operator=(const SegmentedVector& vector)
+    {
+        if(this != &vector)
+        {
+            clear();
+            reserve(vector.size());
+
+            for(const auto& element : vector)
+                push_back(element);
+        }
+
+        return *this;
+    }
+
+    SegmentedVector& operator=(SegmentedVector&& vector)
+    {
+        if(this != &vector)
+        {
+            clear();
+
+            if(m_allocator == vector.m_allocator)
+            {
+                release();
+
+                m_segments = std::move(vector.m_segments);
+                m_size = vector.m_size;
+
+                vector.m_segments.clear();
+                vector.m_size = 0;
+            }
+            else
+            {
+                reserve(vector.size());
+
+                for(auto& element : vector)
+                    push_back(std::move(element));
+
+                vector.clear();
+            }
+        }
+
+        return *this;
+    }
+
+
+
+public: // Public functions
+
+
+
+    iterator begin(){ return iterator(m_segments.data(), 0); }
+    iterator end(){ return iterator(m_segments.data(), m_size); }
+
+    const_iterator begin()const{ return const_iterator(m_segments.data(), 0); }
+    const_iterator end()const{ return const_iterator(m_segments.data(), m_size); }
+
+
+
+    size_type size()const{ return m_size; }
+    size_type capacity()const{ return m_segments.size() * SegmentSize; }
+    size_type max_size()const{ return AllocatorTraits::max_size(m_allocator); }
+    bool empty()const{ return m_size == 0; }
+
+
+
+    T& operator[](size_type index){ return m_segments[index / SegmentSize][index % SegmentSize]; }
+    const T& operator[](size_type index)const{ return m_segments[index / SegmentSize][index % SegmentSize]; }
+
+    T& back(){ return (*this)[m_size - 1]; }
+    const T& back()const{ return (*this)[m_size - 1]; }
+
+
+
+    Allocator get_allocator()const
+    {
+        return m_allocator;
+    }
+
+
+
+    // Function used to allocate the segments needed
+    // to store the specified number of elements
+
+    void reserve(size_type capacity)
+    {
+        size_type numberOfSegments = (capacity + SegmentSize - 1) / SegmentSize;
+
+        if(numberOfSegments <= m_segments.size())
+            return;
+
+        m_segments.reserve(numberOfSegments);
+
+        while(m_segments.size() < numberOfSegments)
+        {
+            T* segment = AllocatorTraits::allocate(m_allocator, SegmentSize);
+
+            m_segments.push_back(segment);
+        }
+    }
+
+
+
+    void push_back(const T& element)
+    {
+        reserve(m_size + 1);
+
+        ::new(static_cast<void*>(&(*this)[m_size])) T(element);
+
+        ++m_size;
+    }
+
+    void push_back(T&& element)
+    {
+        reserve(m_size + 1);
+
+        ::new(static_cast<void*>(&(*this)[m_size])) T(std::move(element));
+
+        ++m_size;
+    }
+
+
+
+    // Function used to insert an element before the
+    // specified position (the following elements are
+    // shifted one slot to the right)
+
+    iterator insert(const_iterator position, T&& element)
+    {
+        size_type index = position.m_index;
+
+        if(index == m_size)
+        {
+            push_back(std::move(element));
+            return begin() + index;
+        }
+
+        push_back(std::move(back()));
+
+        for(size_type i = m_size - 2; i > index; --i)
+            (*this)[i] = std::move((*this)[i - 1]);
+
+        (*this)[index] = std::move(element);
+
+        return begin() + index;
+    }
+
+
+
+    iterator erase(const_iterator position)
+    {
+        return erase(position, position + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        size_type destination = first.m_index;
+        size_type source = last.m_index;
+
+        if(destination == source)
+            return begin() + destination;
+
+        for(; source < m_size; ++source, ++destination)
+            (*this)[destination] = std::move((*this)[source]);
+
+        for(size_type i = destination; i < m_size; ++i)
+            (*this)[i].~T();
+
+        m_size = destination;
+
+        return begin() + first.m_index;
+    }
+
+
+
+    // Function used to destroy the elements (the
+    // segments are kept for the next elements)
+
+    void clear()
+    {
+        for(auto& element : *this)
+            element.~T();
+
+        m_size = 0;
+    }
+
+
+
+private: // Private functions
+
+
+
+    // Function used to give the segments back to
+    // the allocator (the elements must have been
+    // destroyed)
+
+    void release()
+    {
+        for(T* segment : m_segments)
+            AllocatorTraits::deallocate(m_allocator, segment, SegmentSize);
+
+        m_segments.clear();
+    }
+
+
+
+private: // Private variables
+
+
+
+    Allocator                           m_allocator;
+
+
+
+    // The table of segments and the number
+    // of elements stored in them
+
+    std::vector<T*,SegmentsAllocatorType> m_segments;
+    size_type                           m_size = 0;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Policy storing the callbacks in segments of SegmentSize callbacks
+// (the other options are taken from the base policy)
+//-------------------------------------------------------------------
+template<std::size_t SegmentSize = 16,
+         typename BasePolicy = DefaultCallbacksPolicy>
+
+struct SegmentedCallbacksPolicy : BasePolicy
+{
+    template<typename CallbackType, typename CallbackAllocatorType>
+
+    using StorageType = SegmentedVector<CallbackType,SegmentSize,CallbackAllocatorType>;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Aliases of the segmented callback systems
+//-------------------------------------------------------------------
+template<typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using SegmentedCallbacks = BasicCallbacks<SegmentedCallbacksPolicy<>,CallbackReturnType,CallbackArguments...>;
+
+
+
+template<typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using SegmentedCallbacksReturningAContainer = BasicCallbacksReturningAContainer<SegmentedCallbacksPolicy<>,CallbackReturnType,CallbackArguments...>;
+
+
+
+template<typename...CallbackArguments>
+
+using SegmentedCallbacksReturningABoolean = BasicCallbacksReturningABoolean<SegmentedCallbacksPolicy<>,CallbackArguments...>;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of CallbacksLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // CALLBACKS_SEGMENTED_HPP
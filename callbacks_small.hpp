@@ -0,0 +1,511 @@
+#ifndef CALLBACKS_SMALL_HPP
+#define CALLBACKS_SMALL_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Small-registry version of the callback systems defined in callbacks.hpp,
+/// meant for the (common) callback systems that only ever hold a handful of
+/// callbacks
+///
+/// -- The first K callbacks are stored inline in the callback system, so
+///    registering them doesn't allocate and invoking them doesn't chase a
+///    pointer to a separately allocated vector.  Beyond K callbacks they
+///    spill to the heap (like a std::vector):
+///
+///        CallbacksLIB::SmallCallbacks<4,void,int> callbacks;
+///
+/// -- While the callback system holds at most K callbacks, they are invoked
+///    with an unrolled loop
+///
+/// -- The small storage can be combined with the other policies:
+///
+///        BasicCallbacks<SmallCallbacksPolicy<4,PmrCallbacksPolicy>,void,int> callbacks(&arena);
+///
+/// -- Once spilled, the callbacks stay on the heap (the capacity is kept
+///    for the next registrations, like a std::vector)
+///
+///
+///
+/// Note: This class is defined within the namespace CallbacksLIB
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Classes are defined within the namespace CallbacksLIB
+//-------------------------------------------------------------------
+namespace CallbacksLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Vector storing up to K elements inline, and its elements on the
+// heap (taken from its allocator) once it grows past K
+//
+// It provides the subset of the std::vector interface used by the
+// callback systems
+//-------------------------------------------------------------------
+template<typename T,
+         std::size_t K,
+         typename Allocator = std::allocator<T>>
+
+class SmallVector
+{
+    static_assert(K > 0, "A small vector must be able to store at least one element inline");
+
+public: // Public typedefs
+
+
+
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+
+
+public: // Constructors and destructor
+
+
+
+    SmallVector(){}
+
+    explicit SmallVector(const Allocator& allocator) : m_allocator(allocator){}
+
+
+
+    SmallVector(const SmallVector& vector) :
+        m_allocator(AllocatorTraits::select_on_container_copy_construction(vector.m_allocator))
+    {
+        reserve(vector.size());
+
+        for(const auto& element : vector)
+            push_back(element);
+    }
+
+    SmallVector(SmallVector&& vector) : m_allocator(vector.m_allocator)
+    {
+        steal(vector);
+    }
+
+
+
+    ~SmallVector()
+    {
+        clear();
+        release();
+    }
+
+
+
+public: // Assignment operators (the vector keeps its own allocator)
+
+
+
+    SmallVector& operator=(const SmallVector& vector)
+    {
+        if(this != &vector)
+        {
+            clear();
+            reserve(vector.size());
+
+            for(const auto& element : vector)
+                push_back(element);
+        }
+
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& vector)
+    {
+        if(this != &vector)
+        {
+            clear();
+
+            if(m_allocator == vector.m_allocator)
+            {
+                release();
+                steal(vector);
+            }
+            else
+            {
+                reserve(vector.size());
+
+                for(auto& element : vector)
+                    push_back(std::move(element));
+
+                vector.clear();
+            }
+        }
+
+        return *this;
+    }
+
+
+
+public: // Public functions
+
+
+
+    iterator begin(){ return m_data; }
+    iterator end(){ return m_data + m_size; }
+
+    const_iterator begin()const{ return m_data; }
+    const_iterator end()const{ return m_data + m_size; }
+
+
+
+    size_type size()const{ return m_size; }
+    size_type capacity()const{ return m_capacity; }
+    size_type max_size()const{ return AllocatorTraits::max_size(m_allocator); }
+    bool empty()const{ return m_size == 0; }
+
+
+
+    // Function used to tell whether the elements
+    // are still stored inline
+
+    bool is_inline()const
+    {
+        return m_data == inline_data();
+    }
+
+
+
+    T& operator[](size_type index){ return m_data[index]; }
+    const T& operator[](size_type index)const{ return m_data[index]; }
+
+    T& back(){ return m_data[m_size - 1]; }
+    const T& back()const{ return m_data[m_size - 1]; }
+
+
+
+    Allocator get_allocator()const
+    {
+        return m_allocator;
+    }
+
+
+
+    // Function used to make room for the specified
+    // number of elements (moving them to the heap
+    // if they don't fit inline)
+
+    void reserve(size_type capacity)
+    {
+        if(capacity <= m_capacity)
+            return;
+
+        T* newData = AllocatorTraits::allocate(m_allocator, capacity);
+
+        size_type numberOfMovedElements = 0;
+
+        try
+        {
+            for(; numberOfMovedElements < m_size; ++numberOfMovedElements)
+                ::new(static_cast<void*>(newData + numberOfMovedElements)) T(std::move_if_noexcept(m_data[numberOfMovedElements]));
+        }
+        catch(...)
+        {
+            for(size_type i = 0; i < numberOfMovedElements; ++i)
+                newData[i].~T();
+
+            AllocatorTraits::deallocate(m_allocator, newData, capacity);
+            throw;
+        }
+
+        for(auto& element : *this)
+            element.~T();
+
+        release();
+
+        m_data = newData;
+        m_capacity = capacity;
+    }
+
+
+
+    void push_back(const T& element)
+    {
+        if(m_size == m_capacity)
+        {
+            // The element could live in the storage
+            // that is about to be released
+
+            T copy(element);
+
+            grow();
+
+            ::new(static_cast<void*>(m_data + m_size)) T(std::move(copy));
+        }
+        else
+        {
+            ::new(static_cast<void*>(m_data + m_size)) T(element);
+        }
+
+        ++m_size;
+    }
+
+    void push_back(T&& element)
+    {
+        if(m_size == m_capacity)
+            grow();
+
+        ::new(static_cast<void*>(m_data + m_size)) T(std::move(element));
+
+        ++m_size;
+    }
+
+
+
+    // Function used to insert an element before the
+    // specified position (the following elements are
+    // shifted one slot to the right)
+
+    iterator insert(const_iterator position, T&& element)
+    {
+        size_type index = static_cast<size_type>(position - begin());
+
+        if(index == m_size)
+        {
+            push_back(std::move(element));
+            return begin() + index;
+        }
+
+        if(m_size == m_capacity)
+            grow();
+
+        ::new(static_cast<void*>(m_data + m_size)) T(std::move(back()));
+
+        ++m_size;
+
+        for(size_type i = m_size - 2; i > index; --i)
+            m_data[i] = std::move(m_data[i - 1]);
+
+        m_data[index] = std::move(element);
+
+        return begin() + index;
+    }
+
+
+
+    iterator erase(const_iterator position)
+    {
+        return erase(position, position + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        iterator destination = begin() + (first - begin());
+        iterator source = begin() + (last - begin());
+
+        if(destination == source)
+            return destination;
+
+        iterator newEnd = std::move(source, end(), destination);
+
+        for(iterator element = newEnd; element != end(); ++element)
+            element->~T();
+
+        m_size = static_cast<size_type>(newEnd - begin());
+
+        return destination;
+    }
+
+
+
+    void clear()
+    {
+        for(auto& element : *this)
+            element.~T();
+
+        m_size = 0;
+    }
+
+
+
+private: // Private typedefs
+
+
+
+    using AllocatorTraits = std::allocator_traits<Allocator>;
+
+
+
+private: // Private functions
+
+
+
+    T* inline_data()const
+    {
+        return reinterpret_cast<T*>(const_cast<unsigned char*>(m_inlineStorage));
+    }
+
+
+
+    // Function used to double the capacity
+
+    void grow()
+    {
+        reserve(2 * m_capacity);
+    }
+
+
+
+    // Function used to give the heap storage back
+    // to the allocator (the elements must have been
+    // destroyed or moved)
+
+    void release()
+    {
+        if(!is_inline())
+            AllocatorTraits::deallocate(m_allocator, m_data, m_capacity);
+
+        m_data = inline_data();
+        m_capacity = K;
+    }
+
+
+
+    // Function used to take over the elements of
+    // another (empty) vector, stealing its heap
+    // storage if it has spilled
+
+    void steal(SmallVector& vector)
+    {
+        if(vector.is_inline())
+        {
+            for(auto& element : vector)
+                push_back(std::move(element));
+
+            vector.clear();
+            return;
+        }
+
+        m_data = vector.m_data;
+        m_size = vector.m_size;
+        m_capacity = vector.m_capacity;
+
+        vector.m_data = vector.inline_data();
+        vector.m_size = 0;
+        vector.m_capacity = K;
+    }
+
+
+
+private: // Private variables
+
+
+
+    Allocator                           m_allocator;
+
+
+
+    // The elements (pointing to the inline
+    // storage until the vector spills)
+
+    T*                                  m_data = inline_data();
+    size_type                           m_size = 0;
+    size_type                           m_capacity = K;
+
+
+
+    alignas(T) unsigned char            m_inlineStorage[K * sizeof(T)];
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Small vectors are invoked with an unrolled loop while they hold
+// at most K elements
+//-------------------------------------------------------------------
+template<typename T, std::size_t K, typename Allocator>
+
+struct UnrolledInvocationSize<SmallVector<T,K,Allocator>> : std::integral_constant<std::size_t,K>
+{
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Policy storing the first K callbacks inline (the other options
+// are taken from the base policy)
+//-------------------------------------------------------------------
+template<std::size_t K,
+         typename BasePolicy = DefaultCallbacksPolicy>
+
+struct SmallCallbacksPolicy : BasePolicy
+{
+    template<typename CallbackType, typename CallbackAllocatorType>
+
+    using StorageType = SmallVector<CallbackType,K,CallbackAllocatorType>;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Aliases of the small callback systems
+//-------------------------------------------------------------------
+template<std::size_t K,
+         typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using SmallCallbacks = BasicCallbacks<SmallCallbacksPolicy<K>,CallbackReturnType,CallbackArguments...>;
+
+
+
+template<std::size_t K,
+         typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using SmallCallbacksReturningAContainer = BasicCallbacksReturningAContainer<SmallCallbacksPolicy<K>,CallbackReturnType,CallbackArguments...>;
+
+
+
+template<std::size_t K,
+         typename...CallbackArguments>
+
+using SmallCallbacksReturningABoolean = BasicCallbacksReturningABoolean<SmallCallbacksPolicy<K>,CallbackArguments...>;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of CallbacksLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // CALLBACKS_SMALL_HPP
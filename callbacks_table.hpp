@@ -0,0 +1,745 @@
+#ifndef CALLBACKS_TABLE_HPP
+#define CALLBACKS_TABLE_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Side table of callback systems keyed by object identity, meant for
+/// programs with millions of objects of which only a few have callbacks
+/// registered
+///
+/// -- Instead of embedding a callback system in each object, the callbacks
+///    of all the objects are kept in a table indexed by the address of the
+///    object, and only the objects that have at least one callback
+///    registered have an entry in the table:
+///
+///        using CollisionCallbacks = CallbacksLIB::CallbacksTable<void,const Particle&>;
+///
+///        CollisionCallbacks::global().register_callback(&particle, onCollision);
+///
+///        ...
+///
+///        CollisionCallbacks::global()(&particle, particle);
+///
+///    so the memory used is proportional to the number of subscriptions
+///    rather than to the number of objects
+///
+/// -- The index is an open-addressing hash table (linear probing, with
+///    backward-shift deletion so that there are no tombstones), and the
+///    per-object callback systems come from a pool that recycles the ones
+///    released by objects that lost all of their callbacks
+///
+/// -- The callback IDs are unique within the table (a recycled callback
+///    system starts assigning IDs after the last ID assigned by any of the
+///    callback systems released before), so a stale ID can't de-register
+///    the callback of another registration
+///
+/// -- Objects must de-register all of their callbacks when destroyed
+///    (usually in their destructor), otherwise a new object created at the
+///    same address would inherit them
+///
+/// -- Like the callback systems, a table must only be used by one thread
+///    at a time
+///
+///
+///
+/// Note: This class is defined within the namespace CallbacksLIB
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Classes are defined within the namespace CallbacksLIB
+//-------------------------------------------------------------------
+namespace CallbacksLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Table mapping objects to the callback system holding their
+// callbacks (any of the callback systems defined in callbacks.hpp)
+//-------------------------------------------------------------------
+template<typename CallbacksType>
+
+class BasicCallbacksTable
+{
+public: // Public typedefs
+
+
+
+    using RegistryType = CallbacksType;
+    using CallbackFunctionType = typename CallbacksType::CallbackFunctionType;
+
+
+
+public: // Constructors and destructor
+
+
+
+    // Default constructor (doesn't allocate)
+
+    BasicCallbacksTable(){}
+
+
+
+    // Destructor
+
+    ~BasicCallbacksTable(){}
+
+
+
+    // The table holding the callbacks of all the
+    // objects of the process
+
+    static BasicCallbacksTable& global()
+    {
+        static BasicCallbacksTable globalTable;
+
+        return globalTable;
+    }
+
+
+
+public: // Public functions
+
+
+
+    // Functions used to register callbacks for an object
+    // (see the functions of the same name defined by the
+    // callback systems)
+    //
+    // The returned IDs are unique within the table, so an
+    // ID kept after its object lost all of its callbacks
+    // never de-registers a callback registered later
+
+    CallbackID register_callback(const void* object, CallbackFunctionType callback, int priority = 0)
+    {
+        return register_for_object(object, [&](CallbacksType& callbacks)
+        {
+            return callbacks.register_callback(std::move(callback), priority);
+        });
+    }
+
+    CallbackID register_callback_n_times(const void* object, CallbackFunctionType callback, int numberOfInvocations, int priority = 0)
+    {
+        if(numberOfInvocations <= 0)
+            return 0;
+
+        return register_for_object(object, [&](CallbacksType& callbacks)
+        {
+            return callbacks.register_callback_n_times(std::move(callback), numberOfInvocations, priority);
+        });
+    }
+
+    CallbackID register_one_shot_callback(const void* object, CallbackFunctionType callback, int priority = 0)
+    {
+        return register_for_object(object, [&](CallbacksType& callbacks)
+        {
+            return callbacks.register_one_shot_callback(std::move(callback), priority);
+        });
+    }
+
+    CallbackID register_tracked_callback(const void* object, std::weak_ptr<void> owner, CallbackFunctionType callback, int priority = 0)
+    {
+        return register_for_object(object, [&](CallbacksType& callbacks)
+        {
+            return callbacks.register_tracked_callback(std::move(owner), std::move(callback), priority);
+        });
+    }
+
+    ScopedConnection connect(const void* object, CallbackFunctionType callback, int priority = 0)
+    {
+        return register_for_object(object, [&](CallbacksType& callbacks)
+        {
+            return callbacks.connect(std::move(callback), priority);
+        });
+    }
+
+
+
+    // Function used to de-register a callback of an object
+    // (the object leaves the table once it has no callback
+    // left)
+
+    bool deregister_callback(const void* object, const CallbackID& callbackID)
+    {
+        std::size_t slotIndex = find_slot(object);
+
+        if(slotIndex == s_notFound)
+            return false;
+
+        std::uint32_t listIndex = m_slots[slotIndex].m_listIndex;
+
+        bool wasDeregistered = m_lists[listIndex].deregister_callback(callbackID);
+
+        release_list_if_empty(object, listIndex);
+
+        return wasDeregistered;
+    }
+
+
+
+    // Function used to de-register all the callbacks of
+    // an object (for example when it is destroyed)
+
+    void deregister_all_callbacks(const void* object)
+    {
+        std::size_t slotIndex = find_slot(object);
+
+        if(slotIndex == s_notFound)
+            return;
+
+        std::uint32_t listIndex = m_slots[slotIndex].m_listIndex;
+
+        m_lists[listIndex].deregister_all_callbacks();
+
+        release_list_if_empty(object, listIndex);
+    }
+
+
+
+    // Function used to remove the callbacks whose tracked
+    // owner (or connection) has been destroyed, from the
+    // callbacks of all the objects
+    //
+    // Returns the number of callbacks that were removed
+
+    std::size_t collect_expired_callbacks()
+    {
+        std::size_t numberOfCollectedCallbacks = 0;
+
+        std::vector<const void*> emptyObjects;
+
+        for(const auto& slot : m_slots)
+        {
+            if(!slot.m_object)
+                continue;
+
+            numberOfCollectedCallbacks += m_lists[slot.m_listIndex].collect_expired_callbacks();
+
+            if(!m_lists[slot.m_listIndex].has_callbacks())
+                emptyObjects.push_back(slot.m_object);
+        }
+
+        for(const void* object : emptyObjects)
+        {
+            std::size_t slotIndex = find_slot(object);
+
+            release_list_if_empty(object, m_slots[slotIndex].m_listIndex);
+        }
+
+        return numberOfCollectedCallbacks;
+    }
+
+
+
+    // Functions used to query the callbacks of an object
+
+    bool has_callbacks(const void* object)const
+    {
+        const CallbacksType* objectCallbacks = find(object);
+
+        return objectCallbacks && objectCallbacks->has_callbacks();
+    }
+
+    std::size_t get_number_of_callbacks(const void* object)const
+    {
+        const CallbacksType* objectCallbacks = find(object);
+
+        return objectCallbacks ? objectCallbacks->get_number_of_callbacks() : 0;
+    }
+
+
+
+    // Function used to get the number of objects that
+    // currently have an entry in the table
+
+    std::size_t get_number_of_objects()const
+    {
+        return m_numberOfObjects;
+    }
+
+
+
+    // Function used to get the callback system holding
+    // the callbacks of an object (nullptr if the object
+    // has no callback), for example to call one of the
+    // short-circuit invokers
+    //
+    // NOTE:  The returned callback system is only valid
+    //        until the object loses all of its callbacks
+    //        (and callbacks it retires are only released
+    //        by the table's own functions)
+
+    const CallbacksType* find(const void* object)const
+    {
+        std::size_t slotIndex = find_slot(object);
+
+        return (slotIndex == s_notFound) ? nullptr : &m_lists[m_slots[slotIndex].m_listIndex];
+    }
+
+
+
+    // Function used to free the pooled callback systems
+    // that are not used by any object (they are otherwise
+    // kept to be recycled)
+
+    void release_unused_lists()
+    {
+        if(m_invocationDepth > 0)
+            return;
+
+        // Pooled lists can only be freed from the
+        // end of the pool (the others are referred
+        // to by their index)
+
+        std::vector<bool> isFree(m_lists.size(), false);
+
+        for(std::uint32_t listIndex : m_freeLists)
+            isFree[listIndex] = true;
+
+        std::size_t numberOfLists = m_lists.size();
+
+        while(numberOfLists > 0 && isFree[numberOfLists - 1])
+            --numberOfLists;
+
+        if(numberOfLists == m_lists.size())
+            return;
+
+        while(m_lists.size() > numberOfLists)
+            m_lists.pop_back();
+
+        m_freeLists.erase(std::remove_if(m_freeLists.begin(),
+                                         m_freeLists.end(),
+                                         [numberOfLists](std::uint32_t listIndex)
+                                         {
+                                             return listIndex >= numberOfLists;
+                                         }),
+                          m_freeLists.end());
+    }
+
+
+
+    // Function invoking all the callbacks of an object
+
+    template<typename...Arguments>
+
+    void invokeCallbacks(const void* object, Arguments&&...arguments)
+    {
+        std::size_t slotIndex = find_slot(object);
+
+        if(slotIndex == s_notFound)
+            return;
+
+        std::uint32_t listIndex = m_slots[slotIndex].m_listIndex;
+
+        {
+            InvocationGuard guard(*this);
+
+            m_lists[listIndex].invokeCallbacks(std::forward<Arguments>(arguments)...);
+        }
+
+        if(m_invocationDepth == 0)
+            release_emptied_lists();
+
+        // One-shot callbacks might have left
+        // the object without any callback
+
+        release_list_if_empty(object, listIndex);
+    }
+
+
+
+    template<typename...Arguments>
+
+    void operator()(const void* object, Arguments&&...arguments)
+    {
+        invokeCallbacks(object, std::forward<Arguments>(arguments)...);
+    }
+
+
+
+private: // Private classes
+
+
+
+    // An entry of the index
+
+    struct Slot
+    {
+        const void*                     m_object = nullptr;
+        std::uint32_t                   m_listIndex = 0;
+    };
+
+
+
+    // Helper tracking how deeply nested the current
+    // invocation is, so that the callback systems are
+    // never recycled while their callbacks run (the
+    // ones emptied meanwhile are released once the
+    // outermost invocation has returned)
+
+    class InvocationGuard
+    {
+    public:
+
+        InvocationGuard(BasicCallbacksTable& table) : m_table(table)
+        {
+            ++m_table.m_invocationDepth;
+        }
+
+        ~InvocationGuard()
+        {
+            --m_table.m_invocationDepth;
+        }
+
+    private:
+
+        BasicCallbacksTable&            m_table;
+    };
+
+
+
+private: // Private functions
+
+
+
+    // Function used to get the callback system of an
+    // object, adding the object to the table if needed
+
+    CallbacksType& registry(const void* object)
+    {
+        std::size_t slotIndex = find_slot(object);
+
+        if(slotIndex != s_notFound)
+            return m_lists[m_slots[slotIndex].m_listIndex];
+
+        // Keep the index at most half full so
+        // that the probe sequences stay short
+
+        if(2 * (m_numberOfObjects + 1) > m_slots.size())
+            grow_index();
+
+        std::uint32_t listIndex = acquire_list();
+
+        insert_slot(object, listIndex);
+
+        ++m_numberOfObjects;
+
+        return m_lists[listIndex];
+    }
+
+
+
+    // Function used to register a callback for an object,
+    // which leaves the table again if the registration
+    // throws and the object had no callback before
+
+    template<typename RegisterFunction>
+
+    auto register_for_object(const void* object, RegisterFunction&& registerFunction) -> decltype(registerFunction(std::declval<CallbacksType&>()))
+    {
+        CallbacksType& callbacks = registry(object);
+
+        try
+        {
+            return registerFunction(callbacks);
+        }
+        catch(...)
+        {
+            std::size_t slotIndex = find_slot(object);
+
+            if(slotIndex != s_notFound)
+                release_list_if_empty(object, m_slots[slotIndex].m_listIndex);
+
+            throw;
+        }
+    }
+
+
+
+    // Function used to get a callback system from the
+    // pool (recycling a released one if possible)
+
+    std::uint32_t acquire_list()
+    {
+        std::uint32_t listIndex = 0;
+
+        if(!m_freeLists.empty())
+        {
+            listIndex = m_freeLists.back();
+            m_freeLists.pop_back();
+        }
+        else
+        {
+            m_lists.emplace_back();
+            listIndex = static_cast<std::uint32_t>(m_lists.size() - 1);
+        }
+
+        // Skip the IDs that might still be held for
+        // the callbacks of the released lists
+
+        m_lists[listIndex].skip_callback_ids_up_to(m_lastReleasedCallbackID);
+
+        return listIndex;
+    }
+
+
+
+    // Function used to remove an object from the table
+    // and return its callback system to the pool once
+    // it has no callback left (deferred until the
+    // outermost invocation finishes)
+
+    void release_list_if_empty(const void* object, std::uint32_t listIndex)
+    {
+        if(m_lists[listIndex].has_callbacks())
+            return;
+
+        if(m_invocationDepth > 0)
+        {
+            m_objectsToRelease.push_back(object);
+            return;
+        }
+
+        std::size_t slotIndex = find_slot(object);
+
+        if(slotIndex == s_notFound || m_slots[slotIndex].m_listIndex != listIndex)
+            return;
+
+        erase_slot(slotIndex);
+
+        --m_numberOfObjects;
+
+        m_lastReleasedCallbackID = std::max(m_lastReleasedCallbackID, m_lists[listIndex].get_last_assigned_callback_id());
+
+        m_freeLists.push_back(listIndex);
+    }
+
+
+
+    // Function used to release the callback systems
+    // emptied during an invocation
+
+    void release_emptied_lists()
+    {
+        std::vector<const void*> objectsToRelease;
+
+        objectsToRelease.swap(m_objectsToRelease);
+
+        for(const void* object : objectsToRelease)
+        {
+            std::size_t slotIndex = find_slot(object);
+
+            if(slotIndex != s_notFound)
+                release_list_if_empty(object, m_slots[slotIndex].m_listIndex);
+        }
+    }
+
+
+
+    // Function used to hash the address of an object
+    // (Fibonacci hashing, so that the low bits of the
+    // address, which are usually zero, don't matter)
+
+    std::size_t home_slot(const void* object)const
+    {
+        std::uint64_t address = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(object));
+
+        return static_cast<std::size_t>((address * 0x9E3779B97F4A7C15ull) >> (64 - m_indexBits));
+    }
+
+
+
+    // Function used to find the slot of an object
+    // (returns s_notFound if the object isn't in
+    // the table)
+
+    std::size_t find_slot(const void* object)const
+    {
+        if(m_numberOfObjects == 0 || !object)
+            return s_notFound;
+
+        std::size_t mask = m_slots.size() - 1;
+
+        for(std::size_t slotIndex = home_slot(object); ; slotIndex = (slotIndex + 1) & mask)
+        {
+            if(m_slots[slotIndex].m_object == object)
+                return slotIndex;
+
+            if(!m_slots[slotIndex].m_object)
+                return s_notFound;
+        }
+    }
+
+
+
+    void insert_slot(const void* object, std::uint32_t listIndex)
+    {
+        std::size_t mask = m_slots.size() - 1;
+
+        std::size_t slotIndex = home_slot(object);
+
+        while(m_slots[slotIndex].m_object)
+            slotIndex = (slotIndex + 1) & mask;
+
+        m_slots[slotIndex].m_object = object;
+        m_slots[slotIndex].m_listIndex = listIndex;
+    }
+
+
+
+    // Function used to remove a slot, shifting back the
+    // following slots of the probe sequence so that no
+    // tombstone is needed
+
+    void erase_slot(std::size_t slotIndex)
+    {
+        std::size_t mask = m_slots.size() - 1;
+
+        std::size_t emptySlotIndex = slotIndex;
+
+        for(std::size_t nextSlotIndex = (slotIndex + 1) & mask; m_slots[nextSlotIndex].m_object; nextSlotIndex = (nextSlotIndex + 1) & mask)
+        {
+            // A slot can move back to the empty slot if
+            // its home slot isn't between the empty slot
+            // and itself (cyclically)
+
+            std::size_t homeSlotIndex = home_slot(m_slots[nextSlotIndex].m_object);
+
+            if(((nextSlotIndex - homeSlotIndex) & mask) >= ((nextSlotIndex - emptySlotIndex) & mask))
+            {
+                m_slots[emptySlotIndex] = m_slots[nextSlotIndex];
+                emptySlotIndex = nextSlotIndex;
+            }
+        }
+
+        m_slots[emptySlotIndex] = Slot();
+    }
+
+
+
+    // Function used to double the size of the index
+
+    void grow_index()
+    {
+        std::vector<Slot> oldSlots;
+
+        oldSlots.swap(m_slots);
+
+        m_indexBits = oldSlots.empty() ? 4 : m_indexBits + 1;
+
+        m_slots.assign(std::size_t(1) << m_indexBits, Slot());
+
+        for(const auto& slot : oldSlots)
+        {
+            if(slot.m_object)
+                insert_slot(slot.m_object, slot.m_listIndex);
+        }
+    }
+
+
+
+private: // Private variables
+
+
+
+    static const std::size_t            s_notFound = static_cast<std::size_t>(-1);
+
+
+
+    // The index (a power of two number of slots,
+    // at most half of them used)
+
+    std::vector<Slot>                   m_slots;
+    int                                 m_indexBits = 0;
+    std::size_t                         m_numberOfObjects = 0;
+
+
+
+    // The pool of callback systems (a deque, so
+    // that they never move) and the indices of
+    // the ones that can be recycled
+
+    std::deque<CallbacksType>           m_lists;
+    std::vector<std::uint32_t>          m_freeLists;
+
+
+
+    // The last ID assigned by the callback systems
+    // released so far (the callback systems taken
+    // from the pool assign IDs after it)
+
+    CallbackID                          m_lastReleasedCallbackID = 0;
+
+
+
+    // How many invocations are currently running, and
+    // the objects that lost all of their callbacks
+    // during the invocations
+
+    int                                 m_invocationDepth = 0;
+    std::vector<const void*>            m_objectsToRelease;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Tables of the callback systems with the default policy
+//-------------------------------------------------------------------
+template<typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using CallbacksTable = BasicCallbacksTable<Callbacks<CallbackReturnType,CallbackArguments...>>;
+
+
+
+template<typename CallbackReturnType,
+         typename...CallbackArguments>
+
+using CallbacksReturningAContainerTable = BasicCallbacksTable<CallbacksReturningAContainer<CallbackReturnType,CallbackArguments...>>;
+
+
+
+template<typename...CallbackArguments>
+
+using CallbacksReturningABooleanTable = BasicCallbacksTable<CallbacksReturningABoolean<CallbackArguments...>>;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of CallbacksLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // CALLBACKS_TABLE_HPP
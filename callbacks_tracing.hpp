@@ -0,0 +1,629 @@
+#ifndef CALLBACKS_TRACING_HPP
+#define CALLBACKS_TRACING_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Optional tracing of the callback systems defined in callbacks.hpp, which
+/// records when each callback system was invoked, which callbacks ran, how
+/// long they took and on which thread, and exports the timeline in the
+/// Chrome trace event format (viewable in chrome://tracing or Perfetto)
+///
+/// -- Tracing is selected through the policy of the callback system, and
+///    turned on and off at runtime:
+///
+///        BasicCallbacks<TracingCallbacksPolicy,void,int> callbacks;
+///
+///        callbacks.instrumentation().set_trace_name("udp_messages");
+///
+///        CallbacksTracer::enable();
+///
+///        ...
+///
+///        std::ofstream traceFile("trace.json");
+///        CallbacksTracer::write_chrome_trace(traceFile);
+///
+/// -- While tracing is off, invoking the callbacks costs one relaxed atomic
+///    load per invocation and per callback
+///
+/// -- Each thread records its events in its own fixed-size lock-free buffer
+///    (single producer, single consumer), so recording never takes a lock
+///    nor allocates.  When a buffer is full the new events are dropped (and
+///    counted) until the buffers are flushed by write_chrome_trace()
+///
+/// -- The buffer of a thread outlives the thread until its events are
+///    written, so the first write_chrome_trace() after a thread exited
+///    frees its buffer
+///
+///
+///
+/// Note: This class is defined within the namespace CallbacksLIB
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+#include "callbacks_instrumentation.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Classes are defined within the namespace CallbacksLIB
+//-------------------------------------------------------------------
+namespace CallbacksLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// A recorded span (either a whole invocation of a callback system
+// or the invocation of a single callback)
+//-------------------------------------------------------------------
+struct CallbackTraceEvent
+{
+    // The traced callback system
+
+    const void*                         m_callbacks = nullptr;
+
+
+
+    // The trace name of the callback system
+    // (must have static storage duration)
+
+    const char*                         m_traceName = nullptr;
+
+
+
+    // Name of the invoke function for invocation
+    // spans, nullptr for callback spans
+
+    const char*                         m_invokerName = nullptr;
+
+
+
+    // ID of the invoked callback (callback spans only)
+
+    CallbackID                          m_callbackID = 0;
+
+
+
+    // Start and duration of the span (in cycle counter ticks)
+
+    std::uint64_t                       m_startTicks = 0;
+    std::uint64_t                       m_durationTicks = 0;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Fixed-size single-producer/single-consumer ring buffer holding
+// the events recorded by one thread
+//-------------------------------------------------------------------
+class CallbackTraceBuffer
+{
+public: // Public constants
+
+
+
+    static const std::size_t    s_capacity = std::size_t(1) << 14;
+
+
+
+public: // Constructors and destructor
+
+
+
+    explicit CallbackTraceBuffer(int threadID) : m_events(s_capacity), m_threadID(threadID){}
+    ~CallbackTraceBuffer(){}
+
+
+
+public: // Public functions
+
+
+
+    // Function used by the owning thread to record an event
+    // (the event is dropped if the buffer is full)
+
+    void push(const CallbackTraceEvent& event)
+    {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        std::size_t tail = m_tail.load(std::memory_order_acquire);
+
+        if(head - tail >= s_capacity)
+        {
+            m_numberOfDroppedEvents.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        m_events[head & (s_capacity - 1)] = event;
+
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+
+
+    // Function used by the flushing thread to consume
+    // all the recorded events
+
+    template<typename EventConsumer>
+
+    void consume(EventConsumer&& eventConsumer)
+    {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        std::size_t head = m_head.load(std::memory_order_acquire);
+
+        for(; tail != head; ++tail)
+            eventConsumer(m_events[tail & (s_capacity - 1)]);
+
+        m_tail.store(tail, std::memory_order_release);
+    }
+
+
+
+    int thread_id()const
+    {
+        return m_threadID;
+    }
+
+
+
+    std::size_t number_of_dropped_events()const
+    {
+        return m_numberOfDroppedEvents.load(std::memory_order_relaxed);
+    }
+
+
+
+private: // Private variables
+
+
+
+    std::vector<CallbackTraceEvent>     m_events;
+    std::atomic<std::size_t>            m_head{0};
+    std::atomic<std::size_t>            m_tail{0};
+    std::atomic<std::size_t>            m_numberOfDroppedEvents{0};
+    int                                 m_threadID = 0;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Process-wide tracer owning the per-thread buffers
+//-------------------------------------------------------------------
+class CallbacksTracer
+{
+public: // Public functions
+
+
+
+    // Functions used to turn tracing on and off
+
+    static void enable()
+    {
+        state().m_isEnabled.store(true, std::memory_order_relaxed);
+    }
+
+    static void disable()
+    {
+        state().m_isEnabled.store(false, std::memory_order_relaxed);
+    }
+
+    static bool is_enabled()
+    {
+        return state().m_isEnabled.load(std::memory_order_relaxed);
+    }
+
+
+
+    // Function used to create the buffer of the calling
+    // thread ahead of time (otherwise it is created when
+    // the thread records its first event)
+
+    static void prepare_this_thread()
+    {
+        this_thread_buffer();
+    }
+
+
+
+    // Function used to record an event in the
+    // buffer of the calling thread
+
+    static void record(const CallbackTraceEvent& event)
+    {
+        this_thread_buffer().push(event);
+    }
+
+
+
+    // Function used to consume all the recorded events and
+    // write them in the Chrome trace event (JSON) format
+    //
+    // The buffers of the threads that exited are freed
+    // once their events are written (the tracer holds the
+    // last reference to them)
+    //
+    // Returns the number of events written
+
+    static std::size_t write_chrome_trace(std::ostream& output)
+    {
+        State& tracerState = state();
+
+        std::lock_guard<std::mutex> lock(tracerState.m_mutex);
+
+        double microsecondsPerTick = CycleCounter::nanoseconds_per_tick() / 1000.0;
+
+        std::size_t numberOfEvents = 0;
+        std::size_t numberOfDroppedEvents = tracerState.m_numberOfDroppedEventsOfExitedThreads;
+
+        output << "{\"traceEvents\":[";
+
+        for(auto& buffer : tracerState.m_buffers)
+        {
+            int threadID = buffer->thread_id();
+
+            // Checked before consuming the events, so that
+            // the events recorded by a thread before it
+            // exited are all written (the fence pairs with
+            // the release of the thread's reference)
+
+            bool hasThreadExited = (buffer.use_count() == 1);
+
+            if(hasThreadExited)
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+            numberOfDroppedEvents += buffer->number_of_dropped_events();
+
+            buffer->consume([&](const CallbackTraceEvent& event)
+            {
+                output << (numberOfEvents++ ? ",\n" : "\n");
+
+                write_event(output, event, threadID, tracerState.m_startTicks, microsecondsPerTick);
+            });
+
+            if(hasThreadExited)
+            {
+                tracerState.m_numberOfDroppedEventsOfExitedThreads += buffer->number_of_dropped_events();
+                buffer.reset();
+            }
+        }
+
+        tracerState.m_buffers.erase(std::remove(tracerState.m_buffers.begin(),
+                                                tracerState.m_buffers.end(),
+                                                nullptr),
+                                    tracerState.m_buffers.end());
+
+        output << "\n],\"otherData\":{\"dropped_events\":" << numberOfDroppedEvents << "}}\n";
+
+        return numberOfEvents;
+    }
+
+
+
+    // Function used to get the number of thread buffers
+    // (including those of the threads that exited since
+    // the last call to write_chrome_trace())
+
+    static std::size_t get_number_of_thread_buffers()
+    {
+        State& tracerState = state();
+
+        std::lock_guard<std::mutex> lock(tracerState.m_mutex);
+
+        return tracerState.m_buffers.size();
+    }
+
+
+
+private: // Private classes
+
+
+
+    // The state shared by all the threads (the thread IDs
+    // are never reused, and the events dropped by the
+    // threads that exited are still reported)
+
+    struct State
+    {
+        std::atomic<bool>                                   m_isEnabled{false};
+        std::mutex                                          m_mutex;
+        std::vector<std::shared_ptr<CallbackTraceBuffer>>   m_buffers;
+        int                                                 m_nextThreadID = 1;
+        std::size_t                                         m_numberOfDroppedEventsOfExitedThreads = 0;
+        std::uint64_t                                       m_startTicks = CycleCounter::now();
+    };
+
+
+
+private: // Private functions
+
+
+
+    static State& state()
+    {
+        static State tracerState;
+
+        return tracerState;
+    }
+
+
+
+    // Function used to get the buffer of the calling thread
+    // (created and registered the first time the thread
+    // records an event, the buffers outlive their threads
+    // until their events are written)
+
+    static CallbackTraceBuffer& this_thread_buffer()
+    {
+        thread_local std::shared_ptr<CallbackTraceBuffer> threadBuffer = create_thread_buffer();
+
+        return *threadBuffer;
+    }
+
+
+
+    static std::shared_ptr<CallbackTraceBuffer> create_thread_buffer()
+    {
+        State& tracerState = state();
+
+        std::lock_guard<std::mutex> lock(tracerState.m_mutex);
+
+        auto newBuffer = std::make_shared<CallbackTraceBuffer>(tracerState.m_nextThreadID++);
+
+        tracerState.m_buffers.push_back(newBuffer);
+
+        return newBuffer;
+    }
+
+
+
+    static void write_event(std::ostream& output,
+                            const CallbackTraceEvent& event,
+                            int threadID,
+                            std::uint64_t startTicks,
+                            double microsecondsPerTick)
+    {
+        char timestamps[96];
+
+        double startMicroseconds = (event.m_startTicks > startTicks) ? static_cast<double>(event.m_startTicks - startTicks) * microsecondsPerTick : 0.0;
+
+        std::snprintf(timestamps, sizeof(timestamps), "\"ts\":%.3f,\"dur\":%.3f",
+                      startMicroseconds,
+                      static_cast<double>(event.m_durationTicks) * microsecondsPerTick);
+
+        output << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << threadID << "," << timestamps << ",";
+
+        if(event.m_invokerName)
+        {
+            output << "\"cat\":\"invocation\",\"name\":\"";
+            write_escaped(output, event.m_traceName);
+            output << "\",\"args\":{\"invoker\":\"";
+            write_escaped(output, event.m_invokerName);
+            output << "\",\"callbacks\":\"" << event.m_callbacks << "\"}}";
+        }
+        else
+        {
+            output << "\"cat\":\"callback\",\"name\":\"";
+            write_escaped(output, event.m_traceName);
+            output << " #" << event.m_callbackID << "\","
+                   << "\"args\":{\"callback_id\":" << event.m_callbackID << ",\"callbacks\":\"" << event.m_callbacks << "\"}}";
+        }
+    }
+
+
+
+    // Function used to write a name inside a JSON string,
+    // escaping the quotes, the backslashes and the control
+    // characters (a null name is written as empty)
+
+    static void write_escaped(std::ostream& output, const char* text)
+    {
+        if(!text)
+            return;
+
+        for(; *text; ++text)
+        {
+            unsigned char character = static_cast<unsigned char>(*text);
+
+            if(character == '"' || character == '\\')
+            {
+                output << '\\' << *text;
+            }
+            else if(character < 0x20)
+            {
+                char escapedCharacter[8];
+
+                std::snprintf(escapedCharacter, sizeof(escapedCharacter), "\\u%04x", static_cast<unsigned int>(character));
+
+                output << escapedCharacter;
+            }
+            else
+            {
+                output << *text;
+            }
+        }
+    }
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Instrumentation recording a trace event for each invocation of
+// the callback system and for each invoked callback
+//-------------------------------------------------------------------
+class TracingInstrumentation
+{
+public: // Public functions
+
+
+
+    // Function used to set the name shown in the trace
+    // for this callback system
+    //
+    // NOTE:  The name is not copied, it must have static
+    //        storage duration (like a string literal)
+
+    void set_trace_name(const char* traceName)
+    {
+        m_traceName = traceName;
+    }
+
+
+
+    const char* trace_name()const
+    {
+        return m_traceName;
+    }
+
+
+
+    // Function wrapped around each invocation of
+    // all the callbacks
+
+    template<typename InvokeFunction>
+
+    auto measure_invocation(const void* callbacks, const char* invokerName, InvokeFunction&& invokeFunction) -> decltype(invokeFunction())
+    {
+        if(!CallbacksTracer::is_enabled())
+            return invokeFunction();
+
+        m_currentCallbacks = callbacks;
+
+        Recorder recorder(callbacks, m_traceName, invokerName, 0);
+
+        return invokeFunction();
+    }
+
+
+
+    // Function wrapped around each callback invocation
+
+    template<typename InvokeFunction>
+
+    auto measure(CallbackID callbackID, InvokeFunction&& invokeFunction) -> decltype(invokeFunction())
+    {
+        if(!CallbacksTracer::is_enabled())
+            return invokeFunction();
+
+        Recorder recorder(m_currentCallbacks, m_traceName, nullptr, callbackID);
+
+        return invokeFunction();
+    }
+
+
+
+    // Functions called when callbacks are removed (nothing
+    // is kept per callback)
+
+    void forget(CallbackID callbackID)
+    {
+        (void)callbackID;
+    }
+
+    void forget_all()
+    {
+    }
+
+
+
+private: // Private classes
+
+
+
+    // Helper recording a span when it goes out of scope
+    // (so that spans returning void or throwing are
+    // recorded too)
+
+    class Recorder
+    {
+    public:
+
+        Recorder(const void* callbacks, const char* traceName, const char* invokerName, CallbackID callbackID)
+        {
+            m_event.m_callbacks = callbacks;
+            m_event.m_traceName = traceName;
+            m_event.m_invokerName = invokerName;
+            m_event.m_callbackID = callbackID;
+            m_event.m_startTicks = CycleCounter::now();
+        }
+
+        ~Recorder()
+        {
+            m_event.m_durationTicks = CycleCounter::now() - m_event.m_startTicks;
+
+            CallbacksTracer::record(m_event);
+        }
+
+    private:
+
+        CallbackTraceEvent              m_event;
+    };
+
+
+
+private: // Private variables
+
+
+
+    // The name shown in the trace
+
+    const char*                         m_traceName = "Callbacks";
+
+
+
+    // The traced callback system (captured when the
+    // invocation starts, so that callback spans can
+    // refer to it)
+
+    const void*                         m_currentCallbacks = nullptr;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Policy enabling the tracing
+//-------------------------------------------------------------------
+struct TracingCallbacksPolicy : DefaultCallbacksPolicy
+{
+    using InstrumentationType = TracingInstrumentation;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of CallbacksLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // CALLBACKS_TRACING_HPP
@@ -0,0 +1,373 @@
+#ifndef CALLBACKS_WATCHDOG_HPP
+#define CALLBACKS_WATCHDOG_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Optional watchdog for the callback systems defined in callbacks.hpp,
+/// which reports the callbacks that repeatedly take longer than a
+/// configured time budget
+///
+/// -- The watchdog is selected through the policy of the callback system:
+///
+///        BasicCallbacks<WatchdogCallbacksPolicy,void,int> callbacks;
+///
+///        callbacks.instrumentation().set_callback_budget(std::chrono::microseconds(100));
+///        callbacks.instrumentation().set_report_threshold(3);
+///        callbacks.instrumentation().set_report_function([](const SlowCallbackReport& report)
+///        {
+///            std::cerr << "Callback " << report.m_callbackID << " is slow" << std::endl;
+///        });
+///
+/// -- A callback is reported once it exceeds the budget the configured
+///    number of times in a row (and again after every new streak).  The
+///    report function is called once the callback has returned, so it may
+///    throw like the callback itself would (if the callback threw, the
+///    report is made after its next invocation that returns)
+///
+/// -- What the watchdog knows about a callback is dropped when the callback
+///    is removed from the callback system
+///
+/// -- To keep a slow callback from stalling the callbacks after it, combine
+///    the watchdog with Callbacks::invokeCallbacksWithinBudget()
+///
+///
+///
+/// Note: This class is defined within the namespace CallbacksLIB
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Classes are defined within the namespace CallbacksLIB
+//-------------------------------------------------------------------
+namespace CallbacksLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// What the watchdog knows about a callback that exceeded its budget
+//-------------------------------------------------------------------
+struct SlowCallbackReport
+{
+    CallbackID                              m_callbackID = 0;
+
+
+
+    // How many times the callback was invoked, how many
+    // of those invocations exceeded the budget, and how
+    // many of the latest ones did in a row
+
+    std::uint64_t                           m_numberOfCalls = 0;
+    std::uint64_t                           m_numberOfViolations = 0;
+    std::uint64_t                           m_numberOfConsecutiveViolations = 0;
+
+
+
+    // Duration of the latest and of the longest invocation
+
+    std::chrono::steady_clock::duration     m_lastDuration = std::chrono::steady_clock::duration::zero();
+    std::chrono::steady_clock::duration     m_longestDuration = std::chrono::steady_clock::duration::zero();
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Instrumentation timing each callback against a budget and
+// reporting the callbacks that repeatedly exceed it
+//-------------------------------------------------------------------
+class WatchdogInstrumentation
+{
+public: // Public typedefs
+
+
+
+    using ReportFunctionType = std::function<void(const SlowCallbackReport& report)>;
+
+
+
+public: // Configuration functions
+
+
+
+    // Function used to set the time a single callback
+    // invocation is allowed to take
+
+    void set_callback_budget(std::chrono::steady_clock::duration callbackBudget)
+    {
+        m_callbackBudget = callbackBudget;
+    }
+
+
+
+    // Function used to set how many invocations in a row
+    // have to exceed the budget before a callback is
+    // reported (at least one)
+
+    void set_report_threshold(std::uint64_t reportThreshold)
+    {
+        m_reportThreshold = (reportThreshold > 0) ? reportThreshold : 1;
+    }
+
+
+
+    // Function called when a callback is reported
+    // (from the thread invoking the callbacks)
+
+    void set_report_function(ReportFunctionType reportFunction)
+    {
+        m_reportFunction = std::move(reportFunction);
+    }
+
+
+
+public: // Public functions
+
+
+
+    // Function wrapped around each invocation of
+    // all the callbacks (not measured)
+
+    template<typename InvokeFunction>
+
+    auto measure_invocation(const void* callbacks, const char* invokerName, InvokeFunction&& invokeFunction) -> decltype(invokeFunction())
+    {
+        (void)callbacks;
+        (void)invokerName;
+
+        return invokeFunction();
+    }
+
+
+
+    // Function wrapped around each callback invocation
+
+    template<typename InvokeFunction>
+
+    auto measure(CallbackID callbackID, InvokeFunction&& invokeFunction) -> decltype(invokeFunction())
+    {
+        WatchedCallback& watchedCallback = m_reports[callbackID];
+
+        watchedCallback.m_report.m_callbackID = callbackID;
+
+        auto result = [&]() -> decltype(invokeFunction())
+        {
+            Timer timer(*this, watchedCallback);
+
+            return invokeFunction();
+        }();
+
+        if(watchedCallback.m_isReportPending)
+        {
+            watchedCallback.m_isReportPending = false;
+
+            if(m_reportFunction)
+                m_reportFunction(watchedCallback.m_report);
+        }
+
+        return result;
+    }
+
+
+
+    // Functions called when a callback is removed from the
+    // callback system, or when all of them are removed
+
+    void forget(CallbackID callbackID)
+    {
+        m_reports.erase(callbackID);
+    }
+
+    void forget_all()
+    {
+        m_reports.clear();
+    }
+
+
+
+    // Function used to get the callbacks that are currently
+    // exceeding their budget at least as many times in a
+    // row as the report threshold
+
+    std::vector<SlowCallbackReport> get_slow_callbacks()const
+    {
+        std::vector<SlowCallbackReport> slowCallbacks;
+
+        for(const auto& report : m_reports)
+        {
+            if(report.second.m_report.m_numberOfConsecutiveViolations >= m_reportThreshold)
+                slowCallbacks.push_back(report.second.m_report);
+        }
+
+        return slowCallbacks;
+    }
+
+
+
+    // Function used to get what the watchdog knows about
+    // a callback (all counters are zero if it has never
+    // been invoked)
+
+    SlowCallbackReport get_report(CallbackID callbackID)const
+    {
+        auto report = m_reports.find(callbackID);
+
+        if(report == m_reports.end())
+        {
+            SlowCallbackReport emptyReport;
+            emptyReport.m_callbackID = callbackID;
+            return emptyReport;
+        }
+
+        return report->second.m_report;
+    }
+
+
+
+    // Function used to discard all the counters (not
+    // meant to be called from within a callback)
+
+    void reset()
+    {
+        m_reports.clear();
+    }
+
+
+
+private: // Private classes
+
+
+
+    // What the watchdog knows about a callback, and whether
+    // it's due to be reported once the callback returns
+
+    struct WatchedCallback
+    {
+        SlowCallbackReport                      m_report;
+        bool                                    m_isReportPending = false;
+    };
+
+
+
+    // Helper timing an invocation until it goes out of
+    // scope (so that throwing invocations are timed too),
+    // it only updates the counters so it can't throw
+
+    class Timer
+    {
+    public:
+
+        Timer(WatchdogInstrumentation& watchdog, WatchedCallback& watchedCallback) :
+            m_watchdog(watchdog),
+            m_watchedCallback(watchedCallback),
+            m_startTime(std::chrono::steady_clock::now())
+        {
+        }
+
+        ~Timer()
+        {
+            m_watchdog.record(m_watchedCallback, std::chrono::steady_clock::now() - m_startTime);
+        }
+
+    private:
+
+        WatchdogInstrumentation&                m_watchdog;
+        WatchedCallback&                        m_watchedCallback;
+        std::chrono::steady_clock::time_point   m_startTime;
+    };
+
+
+
+private: // Private functions
+
+
+
+    void record(WatchedCallback& watchedCallback, std::chrono::steady_clock::duration duration)
+    {
+        SlowCallbackReport& report = watchedCallback.m_report;
+
+        report.m_lastDuration = duration;
+        ++report.m_numberOfCalls;
+
+        if(duration > report.m_longestDuration)
+            report.m_longestDuration = duration;
+
+        if(duration <= m_callbackBudget)
+        {
+            report.m_numberOfConsecutiveViolations = 0;
+            return;
+        }
+
+        ++report.m_numberOfViolations;
+
+        if(++report.m_numberOfConsecutiveViolations == m_reportThreshold)
+            watchedCallback.m_isReportPending = true;
+    }
+
+
+
+private: // Private variables
+
+
+
+    // Configuration
+
+    std::chrono::steady_clock::duration         m_callbackBudget = std::chrono::milliseconds(1);
+    std::uint64_t                               m_reportThreshold = 3;
+    ReportFunctionType                          m_reportFunction;
+
+
+
+    // What the watchdog knows about each callback ID
+
+    std::unordered_map<CallbackID,WatchedCallback> m_reports;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Policy enabling the watchdog
+//-------------------------------------------------------------------
+struct WatchdogCallbacksPolicy : DefaultCallbacksPolicy
+{
+    using InstrumentationType = WatchdogInstrumentation;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of CallbacksLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // CALLBACKS_WATCHDOG_HPP
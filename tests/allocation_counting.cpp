@@ -0,0 +1,189 @@
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Replacements of the global operator new/delete that count every heap
+/// allocation (see allocation_counting.hpp)
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "allocation_counting.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// The allocation counter
+//-------------------------------------------------------------------
+namespace
+{
+    std::atomic<std::size_t> g_numberOfAllocations(0);
+
+
+
+    void* counted_allocation(std::size_t sizeInBytes)
+    {
+        g_numberOfAllocations.fetch_add(1, std::memory_order_relaxed);
+
+        void* memory = std::malloc(sizeInBytes ? sizeInBytes : 1);
+
+        if(!memory)
+            throw std::bad_alloc();
+
+        return memory;
+    }
+
+
+
+#ifdef __cpp_aligned_new
+    void* counted_aligned_allocation(std::size_t sizeInBytes, std::align_val_t alignment)
+    {
+        g_numberOfAllocations.fetch_add(1, std::memory_order_relaxed);
+
+        // The size passed to std::aligned_alloc must be
+        // a multiple of the alignment
+
+        std::size_t alignmentInBytes = static_cast<std::size_t>(alignment);
+        std::size_t roundedSizeInBytes = (sizeInBytes + alignmentInBytes - 1) / alignmentInBytes * alignmentInBytes;
+
+        void* memory = std::aligned_alloc(alignmentInBytes, roundedSizeInBytes ? roundedSizeInBytes : alignmentInBytes);
+
+        if(!memory)
+            throw std::bad_alloc();
+
+        return memory;
+    }
+#endif
+}
+
+
+
+std::size_t TestsLIB::total_number_of_allocations()
+{
+    return g_numberOfAllocations.load(std::memory_order_relaxed);
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Replaced global operators
+//-------------------------------------------------------------------
+void* operator new(std::size_t sizeInBytes)
+{
+    return counted_allocation(sizeInBytes);
+}
+
+
+
+void* operator new[](std::size_t sizeInBytes)
+{
+    return counted_allocation(sizeInBytes);
+}
+
+
+
+void* operator new(std::size_t sizeInBytes, const std::nothrow_t&) noexcept
+{
+    g_numberOfAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    return std::malloc(sizeInBytes ? sizeInBytes : 1);
+}
+
+
+
+void* operator new[](std::size_t sizeInBytes, const std::nothrow_t&) noexcept
+{
+    g_numberOfAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    return std::malloc(sizeInBytes ? sizeInBytes : 1);
+}
+
+
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+
+
+// Over-aligned allocations (used for example by
+// std::pmr::new_delete_resource)
+
+#ifdef __cpp_aligned_new
+void* operator new(std::size_t sizeInBytes, std::align_val_t alignment)
+{
+    return counted_aligned_allocation(sizeInBytes, alignment);
+}
+
+
+
+void* operator new[](std::size_t sizeInBytes, std::align_val_t alignment)
+{
+    return counted_aligned_allocation(sizeInBytes, alignment);
+}
+
+
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+#endif
+//-------------------------------------------------------------------
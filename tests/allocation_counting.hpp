@@ -0,0 +1,105 @@
+#ifndef ALLOCATION_COUNTING_HPP
+#define ALLOCATION_COUNTING_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Instrumented global allocator used by the tests to count how many heap
+/// allocations an operation performs
+///
+/// -- The replacements of the global operator new/delete live in
+///    allocation_counting.cpp, which must be linked into the test
+///    executable (exactly once)
+///
+/// -- AllocationCounter snapshots the global allocation count when it is
+///    created, so the allocations of an operation are counted with:
+///
+///        AllocationCounter counter;
+///        callbacks(arguments);
+///        auto numberOfAllocations = counter.allocations();
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include <cstddef>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Test helpers are defined within the namespace TestsLIB
+//-------------------------------------------------------------------
+namespace TestsLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Total number of allocations performed by the
+// replaced global operator new since the start
+// of the program
+//-------------------------------------------------------------------
+std::size_t total_number_of_allocations();
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Class used to count the allocations performed
+// since it was created
+//-------------------------------------------------------------------
+class AllocationCounter
+{
+public: // Constructors and destructor
+
+
+
+    AllocationCounter() : m_initialNumberOfAllocations(total_number_of_allocations()){}
+
+
+
+public: // Public functions
+
+
+
+    // Number of allocations performed since
+    // the counter was created
+
+    std::size_t allocations()const
+    {
+        return total_number_of_allocations() - m_initialNumberOfAllocations;
+    }
+
+
+
+private: // Private variables
+
+
+
+    std::size_t                         m_initialNumberOfAllocations = 0;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of TestsLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // ALLOCATION_COUNTING_HPP
@@ -0,0 +1,667 @@
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Test counting the heap allocations performed by each public function of
+/// Callbacks, CallbacksReturningABoolean, CallbacksReturningAContainer,
+/// CompactCallbacks, FixedCallbacks, SmallCallbacks, SegmentedCallbacks,
+/// CopyOnWriteCallbacks, IndexedCallbacks and of a callback system storing
+/// its callables in a CallbackFunction (and by
+/// the main functions of CallbacksTable and of the deferred reclamation, and
+/// by the clone of a callback system taking its memory from an arena)
+///
+/// -- Every operation is measured once the callback system reached its
+///    steady state (its vectors already grew during start-up), and the
+///    callbacks are plain function pointers, which std::function and
+///    CallbackFunction store without allocating
+///
+/// -- Operations declared as zero-allocation make the test fail if they
+///    allocate, the others are only reported
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+#include "callbacks_allocator.hpp"
+#include "callbacks_compact.hpp"
+#include "callbacks_fixed.hpp"
+#include "callbacks_small.hpp"
+#include "callbacks_segmented.hpp"
+#include "callbacks_reclamation.hpp"
+#include "callbacks_copy_on_write.hpp"
+#include "callbacks_id_index.hpp"
+#include "callbacks_table.hpp"
+#include "allocation_counting.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Helpers used by the test
+//-------------------------------------------------------------------
+namespace
+{
+
+
+
+// Number of callbacks registered while warming up
+// the callback systems
+
+const int g_warmUpSize = 64;
+
+
+
+// The callbacks registered in the tests
+
+int g_numberOfInvocations = 0;
+
+void voidCallback(int)
+{
+    ++g_numberOfInvocations;
+}
+
+bool booleanCallback(int)
+{
+    ++g_numberOfInvocations;
+    return false;
+}
+
+std::vector<int> containerCallback(int)
+{
+    ++g_numberOfInvocations;
+    return std::vector<int>();
+}
+
+
+
+// Callable too large to be stored inline by a
+// CallbackFunction (its state is allocated with
+// the allocator of the callback system)
+
+struct LargeCallback
+{
+    void operator()(int)const
+    {
+        ++g_numberOfInvocations;
+    }
+
+    char                                m_state[64] = {};
+};
+
+
+
+// Class used to measure the operations and
+// report the ones that allocated
+
+class AllocationReport
+{
+public:
+
+
+
+    // Function used to measure the allocations of
+    // an operation (if the operation is declared as
+    // zero-allocation, any allocation is a failure)
+
+    template<typename Operation>
+
+    void measure(const std::string& name, bool mustNotAllocate, Operation&& operation)
+    {
+        TestsLIB::AllocationCounter counter;
+
+        operation();
+
+        std::size_t numberOfAllocations = counter.allocations();
+
+        bool failed = mustNotAllocate && numberOfAllocations != 0;
+
+        std::printf("%-90s %4zu allocation(s)%s%s\n",
+                    name.c_str(),
+                    numberOfAllocations,
+                    mustNotAllocate ? "  [zero-allocation]" : "",
+                    failed ? "  FAILED" : "");
+
+        if(failed)
+            ++m_numberOfFailures;
+    }
+
+
+
+    int number_of_failures()const
+    {
+        return m_numberOfFailures;
+    }
+
+
+
+private:
+
+
+
+    int                                 m_numberOfFailures = 0;
+};
+
+
+
+// Function used to bring a callback system to its steady
+// state (vectors grown) and leave it empty
+
+template<typename CallbacksType, typename FunctionType>
+
+void warmUp(CallbacksType& callbacks, FunctionType function)
+{
+    for(int i = 0; i < g_warmUpSize; ++i)
+        callbacks.register_callback(function);
+
+    callbacks.deregister_all_callbacks();
+
+    // Also grow the trackers of the tracked
+    // callbacks
+
+    auto owner = std::make_shared<int>(0);
+
+    for(int i = 0; i < g_warmUpSize; ++i)
+        callbacks.register_tracked_callback(owner, function);
+
+    callbacks.deregister_all_callbacks();
+
+    // Also grow the vector journaling the
+    // callbacks registered while invoking
+
+    callbacks.register_one_shot_callback([&callbacks, function](int)
+    {
+        for(int i = 0; i < g_warmUpSize; ++i)
+            callbacks.register_callback(function);
+
+        return decltype(function(0))();
+    });
+
+    callbacks.invokeCallbacks(0);
+    callbacks.deregister_all_callbacks();
+}
+
+
+
+// Function measuring the functions shared by all the callback systems
+
+template<typename CallbacksType, typename FunctionType>
+
+void measureCommonFunctions(AllocationReport& report,
+                            const std::string& className,
+                            FunctionType function)
+{
+    CallbacksType callbacks;
+
+    warmUp(callbacks, function);
+
+    CallbacksLIB::CallbackID callbackID = 0;
+
+    report.measure(className + "::register_callback", true, [&]
+    {
+        callbackID = callbacks.register_callback(function);
+    });
+
+    report.measure(className + "::register_callback (with priority)", true, [&]
+    {
+        callbacks.register_callback(function, 10);
+    });
+
+    report.measure(className + "::register_callback_n_times", true, [&]
+    {
+        callbacks.register_callback_n_times(function, 3);
+    });
+
+    report.measure(className + "::register_one_shot_callback", true, [&]
+    {
+        callbacks.register_one_shot_callback(function);
+    });
+
+    auto owner = std::make_shared<int>(0);
+
+    report.measure(className + "::register_tracked_callback", true, [&]
+    {
+        callbacks.register_tracked_callback(owner, function);
+    });
+
+    CallbacksLIB::ScopedConnection connection;
+
+    report.measure(className + "::connect (allocates the connection token)", false, [&]
+    {
+        connection = callbacks.connect(function);
+    });
+
+    report.measure(className + "::invokeCallbacks", true, [&]
+    {
+        callbacks.invokeCallbacks(0);
+    });
+
+    report.measure(className + "::operator()", true, [&]
+    {
+        callbacks(0);
+    });
+
+    report.measure(className + "::invokeCallbacksLazily", true, [&]
+    {
+        callbacks.invokeCallbacksLazily([]{ return std::make_tuple(0); });
+    });
+
+    report.measure(className + "::get_number_of_callbacks", true, [&]
+    {
+        std::size_t numberOfCallbacks = callbacks.get_number_of_callbacks();
+        (void)numberOfCallbacks;
+    });
+
+    report.measure(className + "::invokeCallbacksWithinBudget", true, [&]
+    {
+        auto result = callbacks.invokeCallbacksWithinBudget(std::chrono::nanoseconds(0), 0);
+
+        callbacks.resumeCallbacksWithinBudget(result, std::chrono::seconds(1), 0);
+    });
+
+    report.measure(className + "::invokeCallbacks (registering from a callback)", true, [&]
+    {
+        callbacks.register_one_shot_callback([&callbacks, function](int)
+        {
+            callbacks.register_one_shot_callback(function);
+            return decltype(function(0))();
+        });
+
+        callbacks.invokeCallbacks(0);
+    });
+
+    report.measure(className + "::deregister_callback", true, [&]
+    {
+        callbacks.deregister_callback(callbackID);
+    });
+
+    owner.reset();
+    connection.disconnect();
+
+    report.measure(className + "::collect_expired_callbacks", true, [&]
+    {
+        callbacks.collect_expired_callbacks();
+    });
+
+    report.measure(className + "::get_expired_callbacks_statistics", true, [&]
+    {
+        CallbacksLIB::ExpiredCallbacksStatistics statistics = callbacks.get_expired_callbacks_statistics();
+        (void)statistics;
+    });
+
+    report.measure(className + "::deregister_all_callbacks", true, [&]
+    {
+        callbacks.deregister_all_callbacks();
+    });
+}
+
+
+
+// Function measuring the registrations into a fresh callback
+// system once its capacity has been reserved
+
+template<typename CallbacksType>
+
+void measureReservedRegistration(AllocationReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+
+    callbacks.reserve(g_warmUpSize);
+
+    report.measure(className + "::register_callback (after reserve)", true, [&]
+    {
+        for(int i = 0; i < g_warmUpSize; ++i)
+            callbacks.register_callback(&voidCallback);
+    });
+}
+
+
+
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// main function
+//-------------------------------------------------------------------
+int main()
+{
+    AllocationReport report;
+
+
+
+    // Functions shared by all the callback systems
+
+    measureCommonFunctions<CallbacksLIB::Callbacks<void,int>>(report, "Callbacks", &voidCallback);
+    measureCommonFunctions<CallbacksLIB::CallbacksReturningABoolean<int>>(report, "CallbacksReturningABoolean", &booleanCallback);
+    measureCommonFunctions<CallbacksLIB::CallbacksReturningAContainer<std::vector<int>,int>>(report, "CallbacksReturningAContainer", &containerCallback);
+    measureCommonFunctions<CallbacksLIB::CompactCallbacks<void,int>>(report, "CompactCallbacks", &voidCallback);
+    measureCommonFunctions<CallbacksLIB::BasicCallbacks<CallbacksLIB::AllocatorCallbacksPolicy<std::allocator<char>>,void,int>>(report, "BasicCallbacks<AllocatorCallbacksPolicy>", &voidCallback);
+    measureCommonFunctions<CallbacksLIB::FixedCallbacks<2 * g_warmUpSize,void,int>>(report, "FixedCallbacks", &voidCallback);
+    measureCommonFunctions<CallbacksLIB::SmallCallbacks<4,void,int>>(report, "SmallCallbacks", &voidCallback);
+    measureCommonFunctions<CallbacksLIB::SegmentedCallbacks<void,int>>(report, "SegmentedCallbacks", &voidCallback);
+    measureCommonFunctions<CallbacksLIB::CopyOnWriteCallbacks<void,int>>(report, "CopyOnWriteCallbacks", &voidCallback);
+    measureCommonFunctions<CallbacksLIB::IndexedCallbacks<void,int>>(report, "IndexedCallbacks", &voidCallback);
+
+
+
+    // Registration into a callback system whose
+    // capacity was reserved up front
+
+    measureReservedRegistration<CallbacksLIB::Callbacks<void,int>>(report, "Callbacks");
+    measureReservedRegistration<CallbacksLIB::SegmentedCallbacks<void,int>>(report, "SegmentedCallbacks");
+    measureReservedRegistration<CallbacksLIB::IndexedCallbacks<void,int>>(report, "IndexedCallbacks");
+
+
+
+    // Short-circuit invokers
+
+    {
+        CallbacksLIB::CallbacksReturningABoolean<int> callbacks;
+
+        warmUp(callbacks, &booleanCallback);
+
+        for(int i = 0; i < g_warmUpSize; ++i)
+            callbacks.register_callback(&booleanCallback);
+
+        report.measure("CallbacksReturningABoolean::invokeCallbacksUntilOneOfThemReturnsANonZeroValue", true, [&]
+        {
+            callbacks.invokeCallbacksUntilOneOfThemReturnsANonZeroValue(0);
+        });
+    }
+
+    {
+        CallbacksLIB::CallbacksReturningAContainer<std::vector<int>,int> callbacks;
+
+        warmUp(callbacks, &containerCallback);
+
+        for(int i = 0; i < g_warmUpSize; ++i)
+            callbacks.register_callback(&containerCallback);
+
+        report.measure("CallbacksReturningAContainer::invokeCallbacksUntilOneOfThemReturnsANonEmptyContainer", true, [&]
+        {
+            callbacks.invokeCallbacksUntilOneOfThemReturnsANonEmptyContainer(0);
+        });
+    }
+
+
+
+    // Clones of a callback system (a copy-on-write clone
+    // shares the callbacks until it modifies them)
+
+    {
+        CallbacksLIB::Callbacks<void,int> callbacks;
+        CallbacksLIB::CopyOnWriteCallbacks<void,int> copyOnWriteCallbacks;
+
+        for(int i = 0; i < g_warmUpSize; ++i)
+        {
+            callbacks.register_callback(&voidCallback);
+            copyOnWriteCallbacks.register_callback(&voidCallback);
+        }
+
+        report.measure("Callbacks::clone (copies the callbacks)", false, [&]
+        {
+            CallbacksLIB::Callbacks<void,int> clone = callbacks.clone();
+            (void)clone;
+        });
+
+        report.measure("CopyOnWriteCallbacks::clone", true, [&]
+        {
+            CallbacksLIB::CopyOnWriteCallbacks<void,int> clone = copyOnWriteCallbacks.clone();
+            (void)clone;
+        });
+
+        // Invoking callbacks that never count down their
+        // invocations leaves them shared
+
+        CallbacksLIB::CopyOnWriteCallbacks<void,int> sharingClone = copyOnWriteCallbacks.clone();
+
+        report.measure("CopyOnWriteCallbacks::invokeCallbacks (clone sharing the callbacks)", true, [&]
+        {
+            sharingClone.invokeCallbacks(0);
+        });
+
+        report.measure("CopyOnWriteCallbacks::invokeCallbacks (callback system sharing its callbacks with a clone)", true, [&]
+        {
+            copyOnWriteCallbacks.invokeCallbacks(0);
+        });
+    }
+
+
+
+#ifdef CALLBACKS_HAS_PMR
+    // Clone of a callback system taking its memory from an
+    // arena (the clone, and the callables it copies, keep
+    // using the arena instead of the global heap)
+
+    {
+        alignas(std::max_align_t) static unsigned char buffer[1 << 16];
+
+        std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+
+        CallbacksLIB::BasicCallbacks<CallbacksLIB::PmrCallbacksPolicy,void,int> callbacks(&arena);
+
+        for(int i = 0; i < g_warmUpSize; ++i)
+            callbacks.register_callback(LargeCallback());
+
+        report.measure("BasicCallbacks<PmrCallbacksPolicy>::clone (large callables, from an arena)", true, [&]
+        {
+            CallbacksLIB::BasicCallbacks<CallbacksLIB::PmrCallbacksPolicy,void,int> clone = callbacks.clone();
+            clone.invokeCallbacks(0);
+        });
+    }
+#endif
+
+
+
+    // Metadata attached to the callbacks (it is kept apart
+    // from them, so invoking them still doesn't allocate)
+
+    {
+        CallbacksLIB::Callbacks<void,int> callbacks;
+
+        warmUp(callbacks, &voidCallback);
+
+        CallbacksLIB::CallbackID callbackID = callbacks.register_callback(&voidCallback);
+
+        CallbacksLIB::CallbackMetadata metadata;
+
+        metadata.m_name = "callback with a name too long for the small string optimization";
+
+        report.measure("Callbacks::set_callback_metadata", false, [&]
+        {
+            callbacks.set_callback_metadata(callbackID, metadata);
+        });
+
+        report.measure("Callbacks::find_callback_metadata", true, [&]
+        {
+            const CallbacksLIB::CallbackMetadata* foundMetadata = callbacks.find_callback_metadata(callbackID);
+            (void)foundMetadata;
+        });
+
+        report.measure("Callbacks::invokeCallbacks (with metadata)", true, [&]
+        {
+            callbacks.invokeCallbacks(0);
+        });
+
+        report.measure("Callbacks::list_callbacks", false, [&]
+        {
+            std::vector<CallbacksLIB::CallbackInfo> info = callbacks.list_callbacks();
+            (void)info;
+        });
+    }
+
+
+
+    // Callbacks registered and de-registered in bulk
+    // (the returned IDs and the sorted copy of the IDs
+    // to de-register are allocated)
+
+    {
+        CallbacksLIB::Callbacks<void,int> callbacks;
+
+        warmUp(callbacks, &voidCallback);
+
+        std::vector<void(*)(int)> newCallbacks(8, &voidCallback);
+        std::vector<CallbacksLIB::CallbackID> callbackIDs;
+
+        report.measure("Callbacks::register_callbacks (allocates the IDs)", false, [&]
+        {
+            callbackIDs = callbacks.register_callbacks(newCallbacks);
+        });
+
+        report.measure("Callbacks::deregister_callbacks (sorts a copy of the IDs)", false, [&]
+        {
+            callbacks.deregister_callbacks(callbackIDs);
+        });
+    }
+
+    // Same with a fixed callback system (the bulk functions
+    // are the exception to its zero-allocation guarantee,
+    // see callbacks_fixed.hpp)
+
+    {
+        CallbacksLIB::FixedCallbacks<2 * g_warmUpSize,void,int> callbacks;
+
+        warmUp(callbacks, &voidCallback);
+
+        std::vector<void(*)(int)> newCallbacks(8, &voidCallback);
+        std::vector<CallbacksLIB::CallbackID> callbackIDs;
+
+        report.measure("FixedCallbacks::register_callbacks (allocates the IDs)", false, [&]
+        {
+            callbackIDs = callbacks.register_callbacks(newCallbacks);
+        });
+
+        report.measure("FixedCallbacks::deregister_callbacks (sorts a copy of the IDs)", false, [&]
+        {
+            callbacks.deregister_callbacks(callbackIDs);
+        });
+    }
+
+
+
+    // Callbacks whose destruction is deferred to the
+    // background reclaimer (measured once both holders
+    // carrying the removed callbacks reached the size
+    // of the callback system, and the reclaimer has
+    // emptied them)
+
+    {
+        CallbacksLIB::BasicCallbacks<CallbacksLIB::DeferredReclamationCallbacksPolicy,void,int> callbacks;
+        CallbacksLIB::CallbacksReclaimer& reclaimer = CallbacksLIB::CallbacksReclaimer::global();
+
+        warmUp(callbacks, &voidCallback);
+
+        for(int pass = 0; pass < 2; ++pass)
+        {
+            callbacks.deregister_callback(callbacks.register_callback(&voidCallback));
+            reclaimer.flush();
+
+            for(int i = 0; i < g_warmUpSize; ++i)
+                callbacks.register_one_shot_callback(&voidCallback);
+
+            callbacks.invokeCallbacks(0);
+            reclaimer.flush();
+
+            for(int i = 0; i < g_warmUpSize; ++i)
+                callbacks.register_callback(&voidCallback);
+
+            callbacks.deregister_all_callbacks();
+            reclaimer.flush();
+        }
+
+        CallbacksLIB::CallbackID callbackID = callbacks.register_callback(&voidCallback);
+
+        report.measure("BasicCallbacks<DeferredReclamationCallbacksPolicy>::deregister_callback (queues the callback)", true, [&]
+        {
+            callbacks.deregister_callback(callbackID);
+        });
+
+        reclaimer.flush();
+
+        for(int i = 0; i < g_warmUpSize; ++i)
+            callbacks.register_one_shot_callback(&voidCallback);
+
+        report.measure("BasicCallbacks<DeferredReclamationCallbacksPolicy>::invokeCallbacks (queues the used up one-shot callbacks together)", true, [&]
+        {
+            callbacks.invokeCallbacks(0);
+        });
+
+        reclaimer.flush();
+
+        for(int i = 0; i < g_warmUpSize; ++i)
+            callbacks.register_callback(&voidCallback);
+
+        report.measure("BasicCallbacks<DeferredReclamationCallbacksPolicy>::deregister_all_callbacks (queues the callbacks)", true, [&]
+        {
+            callbacks.deregister_all_callbacks();
+        });
+
+        reclaimer.flush();
+    }
+
+
+
+    // Callbacks kept in a table (once the index grew and
+    // the pool holds a recycled callback system)
+
+    {
+        CallbacksLIB::CallbacksTable<void,int> table;
+
+        int objects[g_warmUpSize];
+
+        for(int i = 0; i < g_warmUpSize; ++i)
+        {
+            for(int j = 0; j < g_warmUpSize; ++j)
+                table.register_callback(&objects[i], &voidCallback);
+        }
+
+        for(int i = 0; i < g_warmUpSize; ++i)
+            table.deregister_all_callbacks(&objects[i]);
+
+        CallbacksLIB::CallbackID callbackID = 0;
+
+        report.measure("CallbacksTable::register_callback (recycled callback system)", true, [&]
+        {
+            callbackID = table.register_callback(&objects[0], &voidCallback);
+        });
+
+        report.measure("CallbacksTable::invokeCallbacks", true, [&]
+        {
+            table.invokeCallbacks(&objects[0], 0);
+            table.invokeCallbacks(&objects[1], 0);
+        });
+
+        report.measure("CallbacksTable::deregister_callback", true, [&]
+        {
+            table.deregister_callback(&objects[0], callbackID);
+        });
+    }
+
+
+
+    if(report.number_of_failures() != 0)
+    {
+        std::printf("\n%d zero-allocation operation(s) allocated\n", report.number_of_failures());
+        return 1;
+    }
+
+    return 0;
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,298 @@
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Test checking the circuit breaker defined in callbacks_circuit_breaker.hpp
+///
+/// -- The failing callbacks throw, and the back-off intervals are 50ms
+///    long (or zero, to probe the callbacks right away), with a margin of
+///    10ms when waiting for a probe, so the whole test takes a fraction of
+///    a second
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+#include "callbacks_circuit_breaker.hpp"
+#include "test_report.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Helpers used by the test
+//-------------------------------------------------------------------
+namespace
+{
+
+
+
+using TestsLIB::TestReport;
+using CallbacksLIB::CircuitState;
+
+using GuardedCallbacks = CallbacksLIB::BasicCallbacks<CallbacksLIB::CircuitBreakerCallbacksPolicy,void,int>;
+
+
+
+// Function used to invoke the callbacks and tell
+// whether one of them threw
+
+bool invokeAndCatch(const GuardedCallbacks& callbacks)
+{
+    try
+    {
+        callbacks.invokeCallbacks(0);
+    }
+    catch(const std::runtime_error&)
+    {
+        return true;
+    }
+
+    return false;
+}
+
+
+
+// Callback failing (throwing) while told to, and
+// counting its invocations
+
+class FailingCallback
+{
+public:
+
+
+
+    FailingCallback(const bool& isFailing, int& numberOfCalls) : m_isFailing(&isFailing), m_numberOfCalls(&numberOfCalls)
+    {
+    }
+
+
+
+    void operator()(int)const
+    {
+        ++*m_numberOfCalls;
+
+        if(*m_isFailing)
+            throw std::runtime_error("callback failed");
+    }
+
+
+
+private:
+
+
+
+    const bool*                         m_isFailing;
+    int*                                m_numberOfCalls;
+};
+
+
+
+// A circuit trips after the configured number of failures
+// in a row, the callback is skipped while it is open, and
+// it is probed once the back-off interval has elapsed
+// (closing the circuit if the probe succeeds)
+
+void checkCircuitStates(TestReport& report)
+{
+    GuardedCallbacks callbacks;
+
+    callbacks.circuit_breaker().set_failure_threshold(3);
+    callbacks.circuit_breaker().set_backoff(std::chrono::milliseconds(50), std::chrono::milliseconds(200));
+
+    bool isFailing = true;
+    int numberOfCalls = 0;
+    int numberOfOtherCalls = 0;
+
+    callbacks.register_callback([&numberOfOtherCalls](int){ ++numberOfOtherCalls; }, 1);
+    auto callbackID = callbacks.register_callback(FailingCallback(isFailing, numberOfCalls));
+
+    bool isCorrect = invokeAndCatch(callbacks) &&
+                     invokeAndCatch(callbacks) &&
+                     callbacks.circuit_breaker().get_state(callbackID) == CircuitState::Closed &&
+                     invokeAndCatch(callbacks) &&
+                     callbacks.circuit_breaker().get_state(callbackID) == CircuitState::Open &&
+                     callbacks.circuit_breaker().get_number_of_trips(callbackID) == 1 &&
+                     callbacks.circuit_breaker().get_tripped_callbacks() == std::vector<CallbacksLIB::CallbackID>({callbackID});
+
+    report.check("CircuitBreaker trips a circuit after the configured number of failures", isCorrect);
+
+    isCorrect = !invokeAndCatch(callbacks) &&
+                numberOfCalls == 3 &&
+                numberOfOtherCalls == 4;
+
+    report.check("CircuitBreaker skips a callback while its circuit is open", isCorrect);
+
+    isFailing = false;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+
+    isCorrect = !invokeAndCatch(callbacks) &&
+                numberOfCalls == 4 &&
+                callbacks.circuit_breaker().get_state(callbackID) == CircuitState::Closed &&
+                callbacks.circuit_breaker().get_tripped_callbacks().empty() &&
+                !invokeAndCatch(callbacks) &&
+                numberOfCalls == 5;
+
+    report.check("CircuitBreaker closes a circuit once a probe succeeds", isCorrect);
+}
+
+
+
+// A failed probe opens the circuit again for twice as
+// long, and the failures of a removed callback are
+// forgotten
+
+void checkFailedProbes(TestReport& report)
+{
+    GuardedCallbacks callbacks;
+
+    callbacks.circuit_breaker().set_failure_threshold(1);
+    callbacks.circuit_breaker().set_backoff(std::chrono::milliseconds(50), std::chrono::milliseconds(200));
+
+    bool isFailing = true;
+    int numberOfCalls = 0;
+
+    auto callbackID = callbacks.register_callback(FailingCallback(isFailing, numberOfCalls));
+
+    bool isCorrect = invokeAndCatch(callbacks) &&
+                     callbacks.circuit_breaker().get_state(callbackID) == CircuitState::Open;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+
+    isCorrect = isCorrect &&
+                invokeAndCatch(callbacks) &&
+                numberOfCalls == 2 &&
+                callbacks.circuit_breaker().get_state(callbackID) == CircuitState::Open &&
+                callbacks.circuit_breaker().get_number_of_trips(callbackID) == 2;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+
+    isCorrect = isCorrect &&
+                !invokeAndCatch(callbacks) &&
+                numberOfCalls == 2;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+
+    isCorrect = isCorrect &&
+                invokeAndCatch(callbacks) &&
+                numberOfCalls == 3;
+
+    report.check("CircuitBreaker doubles the back-off interval after a failed probe", isCorrect);
+
+    callbacks.deregister_callback(callbackID);
+
+    isCorrect = callbacks.circuit_breaker().get_state(callbackID) == CircuitState::Closed &&
+                callbacks.circuit_breaker().get_number_of_trips(callbackID) == 0 &&
+                callbacks.circuit_breaker().get_tripped_callbacks().empty();
+
+    report.check("CircuitBreaker forgets the circuit of a removed callback", isCorrect);
+}
+
+
+
+// Invocations exceeding the latency threshold count
+// as failures
+
+void checkSlowCallbacks(TestReport& report)
+{
+    GuardedCallbacks callbacks;
+
+    callbacks.circuit_breaker().set_failure_threshold(2);
+    callbacks.circuit_breaker().set_latency_threshold(std::chrono::milliseconds(1));
+
+    auto slowCallbackID = callbacks.register_callback([](int)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(3));
+    });
+
+    auto fastCallbackID = callbacks.register_callback([](int){});
+
+    callbacks.invokeCallbacks(0);
+
+    bool isCorrect = callbacks.circuit_breaker().get_state(slowCallbackID) == CircuitState::Closed;
+
+    callbacks.invokeCallbacks(0);
+
+    isCorrect = isCorrect &&
+                callbacks.circuit_breaker().get_state(slowCallbackID) == CircuitState::Open &&
+                callbacks.circuit_breaker().get_state(fastCallbackID) == CircuitState::Closed;
+
+    report.check("CircuitBreaker counts the slow invocations as failures", isCorrect);
+}
+
+
+
+// A callback resetting its own circuit while it is being
+// probed leaves the circuit breaker in a valid state
+
+void checkResetFromWithin(TestReport& report)
+{
+    GuardedCallbacks callbacks;
+
+    callbacks.circuit_breaker().set_failure_threshold(1);
+    callbacks.circuit_breaker().set_backoff(std::chrono::milliseconds(0), std::chrono::milliseconds(0));
+
+    int numberOfCalls = 0;
+    GuardedCallbacks* registry = &callbacks;
+
+    auto callbackID = callbacks.register_callback([&numberOfCalls, registry](int)
+    {
+        ++numberOfCalls;
+
+        if(numberOfCalls > 1)
+            registry->circuit_breaker().reset();
+
+        if(numberOfCalls != 2)
+            throw std::runtime_error("callback failed");
+    });
+
+    bool isCorrect = invokeAndCatch(callbacks) &&
+                     callbacks.circuit_breaker().get_state(callbackID) == CircuitState::Open &&
+                     !invokeAndCatch(callbacks) &&
+                     callbacks.circuit_breaker().get_state(callbackID) == CircuitState::Closed &&
+                     callbacks.circuit_breaker().get_number_of_trips(callbackID) == 0 &&
+                     invokeAndCatch(callbacks) &&
+                     callbacks.circuit_breaker().get_state(callbackID) == CircuitState::Open &&
+                     callbacks.circuit_breaker().get_number_of_trips(callbackID) == 1 &&
+                     numberOfCalls == 3;
+
+    report.check("CircuitBreaker records the result of a callback that reset its circuit", isCorrect);
+}
+
+
+
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// main function
+//-------------------------------------------------------------------
+int main()
+{
+    TestReport report;
+
+    checkCircuitStates(report);
+    checkFailedProbes(report);
+    checkSlowCallbacks(report);
+    checkResetFromWithin(report);
+
+    return report.exit_code();
+}
+//-------------------------------------------------------------------
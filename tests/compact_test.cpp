@@ -0,0 +1,205 @@
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Test checking the compact callback systems defined in callbacks_compact.hpp
+///
+/// -- The checks look at when the wrapped callback system gets allocated,
+///    and at the callbacks invoked through the compact callback system
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+#include "callbacks_compact.hpp"
+#include "test_report.hpp"
+
+#include <chrono>
+#include <tuple>
+#include <utility>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Helpers used by the test
+//-------------------------------------------------------------------
+namespace
+{
+
+
+
+using TestsLIB::TestReport;
+
+using CompactCallbacks = CallbacksLIB::CompactCallbacks<void,int>;
+
+
+
+// The tags recorded by the invoked callbacks
+
+using Tags = std::vector<int>;
+
+
+
+// Nothing allocates the wrapped callback system until a
+// callback is registered
+
+void checkEmptyCallbacks(TestReport& report)
+{
+    CompactCallbacks callbacks;
+
+    int numberOfFactoryCalls = 0;
+
+    callbacks.invokeCallbacks(0);
+    callbacks(0);
+    callbacks.invokeCallbacksLazily([&numberOfFactoryCalls]
+    {
+        ++numberOfFactoryCalls;
+        return std::make_tuple(0);
+    });
+
+    bool isCorrect = sizeof(CompactCallbacks) == sizeof(void*) &&
+                     !callbacks.deregister_callback(1) &&
+                     callbacks.deregister_callbacks({1, 2}) == 0 &&
+                     callbacks.collect_expired_callbacks() == 0 &&
+                     callbacks.get_number_of_callbacks() == 0 &&
+                     !callbacks.has_callbacks() &&
+                     callbacks.capacity() == 0 &&
+                     callbacks.invokeCallbacksWithinBudget(std::chrono::seconds(1), 0).m_numberOfCallbacksInvoked == 0 &&
+                     !callbacks.clone().is_allocated() &&
+                     !callbacks.is_allocated() &&
+                     numberOfFactoryCalls == 0;
+
+    callbacks.deregister_all_callbacks();
+
+    isCorrect = isCorrect && !callbacks.is_allocated();
+
+    report.check("CompactCallbacks doesn't allocate anything until a callback is registered", isCorrect);
+}
+
+
+
+// Once allocated, the compact callback system behaves like
+// the wrapped one, and stays allocated when it's emptied
+
+void checkRegisteredCallbacks(TestReport& report)
+{
+    CompactCallbacks callbacks;
+    Tags tags;
+
+    auto firstCallbackID = callbacks.register_callback([&tags](int argument){ tags.push_back(argument); });
+    callbacks.register_callback([&tags](int){ tags.push_back(1); }, 1);
+    callbacks.register_one_shot_callback([&tags](int){ tags.push_back(2); });
+
+    callbacks.invokeCallbacks(7);
+    callbacks(8);
+
+    bool isCorrect = callbacks.is_allocated() &&
+                     tags == Tags({1, 7, 2, 1, 8}) &&
+                     callbacks.get_number_of_callbacks() == 2 &&
+                     callbacks.deregister_callback(firstCallbackID) &&
+                     !callbacks.deregister_callback(firstCallbackID);
+
+    callbacks.deregister_all_callbacks();
+
+    tags.clear();
+
+    callbacks.invokeCallbacks(0);
+
+    isCorrect = isCorrect &&
+                callbacks.is_allocated() &&
+                !callbacks.has_callbacks() &&
+                tags.empty();
+
+    report.check("CompactCallbacks invokes the callbacks once they are registered", isCorrect);
+}
+
+
+
+// Clones are independent of the original, and moving a
+// compact callback system keeps its callback IDs valid
+
+void checkClonesAndMoves(TestReport& report)
+{
+    CompactCallbacks callbacks;
+    Tags tags;
+
+    auto callbackID = callbacks.register_callback([&tags](int){ tags.push_back(1); });
+
+    CompactCallbacks clone = callbacks.clone();
+
+    clone.register_callback([&tags](int){ tags.push_back(2); });
+
+    callbacks.invokeCallbacks(0);
+
+    bool isCorrect = tags == Tags({1}) &&
+                     clone.deregister_callback(callbackID) &&
+                     callbacks.get_number_of_callbacks() == 1;
+
+    CompactCallbacks movedCallbacks(std::move(callbacks));
+
+    tags.clear();
+
+    movedCallbacks.invokeCallbacks(0);
+    clone.invokeCallbacks(0);
+
+    isCorrect = isCorrect &&
+                tags == Tags({1, 2}) &&
+                movedCallbacks.deregister_callback(callbackID) &&
+                !movedCallbacks.has_callbacks();
+
+    report.check("CompactCallbacks clones are independent and moves keep the callback IDs", isCorrect);
+}
+
+
+
+// The short-circuit invokers return a default result
+// while nothing is allocated
+
+void checkShortCircuitInvokers(TestReport& report)
+{
+    CallbacksLIB::CompactCallbacksReturningABoolean<int> callbacks;
+
+    bool isCorrect = !callbacks.invokeCallbacksUntilOneOfThemReturnsANonZeroValue(0) &&
+                     !callbacks.is_allocated();
+
+    callbacks.register_callback([](int argument){ return argument > 0; });
+
+    isCorrect = isCorrect &&
+                !callbacks.invokeCallbacksUntilOneOfThemReturnsANonZeroValue(0) &&
+                callbacks.invokeCallbacksUntilOneOfThemReturnsANonZeroValue(1);
+
+    report.check("CompactCallbacksReturningABoolean returns false while empty", isCorrect);
+}
+
+
+
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// main function
+//-------------------------------------------------------------------
+int main()
+{
+    TestReport report;
+
+    checkEmptyCallbacks(report);
+    checkRegisteredCallbacks(report);
+    checkClonesAndMoves(report);
+    checkShortCircuitInvokers(report);
+
+    return report.exit_code();
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,254 @@
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Test checking the exception policies defined in callbacks_exceptions.hpp
+///
+/// -- Each callback system gets a callback throwing a std::runtime_error,
+///    one returning normally and one throwing a std::logic_error, in that
+///    order, so the checks can tell which callbacks ran and which
+///    exceptions were caught
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+#include "callbacks_exceptions.hpp"
+#include "test_report.hpp"
+
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Helpers used by the test
+//-------------------------------------------------------------------
+namespace
+{
+
+
+
+using TestsLIB::TestReport;
+using CallbacksLIB::CallbackID;
+
+using IsolatingCallbacks = CallbacksLIB::BasicCallbacks<CallbacksLIB::IsolatingCallbacksPolicy,void,int>;
+using CollectingCallbacks = CallbacksLIB::BasicCallbacks<CallbacksLIB::CollectingCallbacksPolicy,void,int>;
+using NonThrowingCallbacks = CallbacksLIB::BasicCallbacks<CallbacksLIB::NoexceptCallbacksPolicy,void,int>;
+
+
+
+// The tags recorded by the invoked callbacks
+
+using Tags = std::vector<int>;
+
+
+
+// Function used to register the three callbacks (the
+// throwing ones are one-shot callbacks, so they must
+// be removed even though they threw)
+
+template<typename CallbacksType>
+
+std::vector<CallbackID> registerCallbacks(CallbacksType& callbacks, Tags& tags)
+{
+    std::vector<CallbackID> callbackIDs;
+
+    callbackIDs.push_back(callbacks.register_one_shot_callback([&tags](int)
+    {
+        tags.push_back(1);
+        throw std::runtime_error("first callback failed");
+    }));
+
+    callbackIDs.push_back(callbacks.register_callback([&tags](int)
+    {
+        tags.push_back(2);
+    }));
+
+    callbackIDs.push_back(callbacks.register_one_shot_callback([&tags](int)
+    {
+        tags.push_back(3);
+        throw std::logic_error("third callback failed");
+    }));
+
+    return callbackIDs;
+}
+
+
+
+// Function used to check the type of a caught exception
+
+template<typename ExceptionType>
+
+bool isException(const std::exception_ptr& exception)
+{
+    try
+    {
+        std::rethrow_exception(exception);
+    }
+    catch(const ExceptionType&)
+    {
+        return true;
+    }
+    catch(...)
+    {
+    }
+
+    return false;
+}
+
+
+
+// The isolating policy hands each exception to the handler
+// and keeps invoking the remaining callbacks
+
+void checkIsolatedExceptions(TestReport& report)
+{
+    IsolatingCallbacks callbacks;
+    Tags tags;
+
+    std::vector<CallbackID> throwingCallbackIDs;
+    std::vector<std::exception_ptr> exceptions;
+
+    callbacks.exception_policy().set_exception_handler([&](CallbackID callbackID, std::exception_ptr exception)
+    {
+        throwingCallbackIDs.push_back(callbackID);
+        exceptions.push_back(exception);
+    });
+
+    auto callbackIDs = registerCallbacks(callbacks, tags);
+
+    bool isCorrect = true;
+
+    try
+    {
+        callbacks.invokeCallbacks(0);
+    }
+    catch(...)
+    {
+        isCorrect = false;
+    }
+
+    isCorrect = isCorrect &&
+                tags == Tags({1, 2, 3}) &&
+                throwingCallbackIDs == std::vector<CallbackID>({callbackIDs[0], callbackIDs[2]}) &&
+                isException<std::runtime_error>(exceptions[0]) &&
+                isException<std::logic_error>(exceptions[1]) &&
+                callbacks.exception_policy().get_number_of_isolated_exceptions() == 2 &&
+                callbacks.get_number_of_callbacks() == 1;
+
+    tags.clear();
+
+    callbacks.invokeCallbacks(0);
+
+    isCorrect = isCorrect && tags == Tags({2});
+
+    report.check("IsolateExceptions keeps invoking the callbacks after one throws", isCorrect);
+}
+
+
+
+// The collecting policy invokes all the callbacks, then
+// throws all the exceptions at once
+
+void checkCollectedExceptions(TestReport& report)
+{
+    CollectingCallbacks callbacks;
+    Tags tags;
+
+    auto callbackIDs = registerCallbacks(callbacks, tags);
+
+    bool isCorrect = false;
+
+    try
+    {
+        callbacks.invokeCallbacks(0);
+    }
+    catch(const CallbacksLIB::CallbackExceptions& exceptions)
+    {
+        isCorrect = exceptions.exceptions().size() == 2 &&
+                    exceptions.exceptions()[0].m_callbackID == callbackIDs[0] &&
+                    exceptions.exceptions()[1].m_callbackID == callbackIDs[2] &&
+                    isException<std::runtime_error>(exceptions.exceptions()[0].m_exception) &&
+                    isException<std::logic_error>(exceptions.exceptions()[1].m_exception);
+    }
+
+    isCorrect = isCorrect &&
+                tags == Tags({1, 2, 3}) &&
+                callbacks.get_number_of_callbacks() == 1;
+
+    tags.clear();
+
+    try
+    {
+        callbacks.invokeCallbacks(0);
+    }
+    catch(...)
+    {
+        isCorrect = false;
+    }
+
+    isCorrect = isCorrect && tags == Tags({2});
+
+    report.check("CollectExceptions throws the exceptions of all the callbacks once they ran", isCorrect);
+}
+
+
+
+// The noexcept policy invokes the callbacks without any
+// try/catch
+
+void checkNoexceptCallbacks(TestReport& report)
+{
+    NonThrowingCallbacks callbacks;
+    Tags tags;
+
+    callbacks.register_callback([&tags](int){ tags.push_back(1); });
+    callbacks.register_one_shot_callback([&tags](int){ tags.push_back(2); });
+
+    callbacks.invokeCallbacks(0);
+    callbacks.invokeCallbacks(0);
+
+    auto doesNotStop = []{ return false; };
+
+    CallbacksLIB::NoexceptCallbacks::InvocationScope scope = callbacks.exception_policy().begin_invocation();
+
+    bool isCorrect = noexcept(scope.invoke(0, doesNotStop)) &&
+                     noexcept(scope.finish()) &&
+                     tags == Tags({1, 2, 1});
+
+    report.check("NoexceptCallbacks invokes the callbacks", isCorrect);
+}
+
+
+
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// main function
+//-------------------------------------------------------------------
+int main()
+{
+    TestReport report;
+
+    checkIsolatedExceptions(report);
+    checkCollectedExceptions(report);
+    checkNoexceptCallbacks(report);
+
+    return report.exit_code();
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,1028 @@
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Test checking the behavior of the callback systems with every storage:
+/// Callbacks, SegmentedCallbacks, SmallCallbacks, FixedCallbacks,
+/// IndexedCallbacks and CopyOnWriteCallbacks
+///
+/// -- Each callback system goes through the same checks, one group for each
+///    feature of the callback systems (the features that only some callback
+///    systems have are checked after them)
+///
+/// -- The callbacks record their tag in a vector when they are invoked, so
+///    each check compares the recorded tags with the expected ones (the
+///    callables capture at most three pointers so that they fit the inline
+///    storage of FixedCallbacks)
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+#include "callbacks_fixed.hpp"
+#include "callbacks_small.hpp"
+#include "callbacks_segmented.hpp"
+#include "callbacks_copy_on_write.hpp"
+#include "callbacks_id_index.hpp"
+#include "test_report.hpp"
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Helpers used by the test
+//-------------------------------------------------------------------
+namespace
+{
+
+
+
+using TestsLIB::TestReport;
+
+
+
+// The tags recorded by the invoked callbacks
+
+using Tags = std::vector<int>;
+
+
+
+// Callback recording its tag when invoked (small
+// enough to be stored inline by FixedCallbacks)
+
+class Recorder
+{
+public:
+
+
+
+    Recorder(Tags& tags, int tag) : m_tags(&tags), m_tag(tag)
+    {
+    }
+
+
+
+    void operator()(int)const
+    {
+        m_tags->push_back(m_tag);
+    }
+
+
+
+private:
+
+
+
+    Tags*                               m_tags;
+    int                                 m_tag;
+};
+
+
+
+Recorder recorder(Tags& tags, int tag)
+{
+    return Recorder(tags, tag);
+}
+
+
+
+// Function used to invoke the callbacks and get
+// the tags they recorded
+
+template<typename CallbacksType>
+
+Tags invoke(const CallbacksType& callbacks, Tags& tags)
+{
+    tags.clear();
+
+    callbacks.invokeCallbacks(0);
+
+    return tags;
+}
+
+
+
+// The callbacks are invoked from the highest to the lowest
+// priority, in the order they were registered within the
+// same priority
+
+template<typename CallbacksType>
+
+void checkPriorityOrder(TestReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+    Tags tags;
+
+    callbacks.register_callback(recorder(tags, 1));
+    callbacks.register_callback(recorder(tags, 2), 5);
+    callbacks.register_callback(recorder(tags, 3), -1);
+    callbacks.register_callback(recorder(tags, 4), 5);
+    callbacks.register_callback(recorder(tags, 5), 10);
+    callbacks.register_callback(recorder(tags, 6));
+
+    report.check(className + " invokes the callbacks by priority", invoke(callbacks, tags) == Tags({5, 2, 4, 1, 6, 3}));
+}
+
+
+
+// Callbacks inserted between the registered ones (or
+// registered after some were de-registered) still go
+// after the callbacks of the same priority
+
+template<typename CallbacksType>
+
+void checkPriorityInsertion(TestReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+    Tags tags;
+
+    callbacks.register_callback(recorder(tags, 1));
+    CallbacksLIB::CallbackID callbackID = callbacks.register_callback(recorder(tags, 2));
+    callbacks.register_callback(recorder(tags, 3));
+    callbacks.register_callback(recorder(tags, 4), 5);
+    callbacks.register_callback(recorder(tags, 5));
+    callbacks.register_callback(recorder(tags, 6), 5);
+    callbacks.register_callback(recorder(tags, 7), -5);
+
+    callbacks.deregister_callback(callbackID);
+
+    callbacks.register_callback(recorder(tags, 8));
+
+    bool isCorrect = invoke(callbacks, tags) == Tags({4, 6, 1, 3, 5, 8, 7}) &&
+                     callbacks.get_number_of_callbacks() == 7;
+
+    report.check(className + " inserts the callbacks after those of the same priority", isCorrect);
+}
+
+
+
+// Counted and one-shot callbacks are removed once they
+// used up their invocations
+
+template<typename CallbacksType>
+
+void checkCountedCallbacks(TestReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+    Tags tags;
+
+    callbacks.register_callback(recorder(tags, 1));
+    callbacks.register_callback_n_times(recorder(tags, 2), 3);
+    callbacks.register_one_shot_callback(recorder(tags, 3));
+
+    bool isCorrect = callbacks.get_number_of_callbacks() == 3 &&
+                     invoke(callbacks, tags) == Tags({1, 2, 3}) &&
+                     callbacks.get_number_of_callbacks() == 2 &&
+                     callbacks.list_callbacks().size() == 2 &&
+                     callbacks.list_callbacks()[1].m_remainingInvocations == 2 &&
+                     invoke(callbacks, tags) == Tags({1, 2}) &&
+                     invoke(callbacks, tags) == Tags({1, 2}) &&
+                     callbacks.get_number_of_callbacks() == 1 &&
+                     invoke(callbacks, tags) == Tags({1}) &&
+                     callbacks.register_callback_n_times(recorder(tags, 4), 0) == 0;
+
+    report.check(className + " removes the counted and one-shot callbacks once used up", isCorrect);
+}
+
+
+
+// A one-shot callback invoking the callbacks again from
+// within itself is not invoked by the nested invocation
+
+template<typename CallbacksType>
+
+void checkNestedOneShotCallbacks(TestReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+    Tags tags;
+
+    CallbacksType* registry = &callbacks;
+    Tags* recordedTags = &tags;
+
+    callbacks.register_one_shot_callback([registry, recordedTags](int)
+    {
+        recordedTags->push_back(1);
+
+        registry->invokeCallbacks(0);
+    });
+
+    callbacks.register_callback(recorder(tags, 2));
+
+    bool isCorrect = invoke(callbacks, tags) == Tags({1, 2, 2}) &&
+                     invoke(callbacks, tags) == Tags({2}) &&
+                     callbacks.get_number_of_callbacks() == 1;
+
+    report.check(className + " invokes a one-shot callback once even from a nested invocation", isCorrect);
+}
+
+
+
+// A callback registered from within a callback is invoked
+// from the next invocation on, and a callback de-registered
+// from within a callback is not invoked anymore (even later
+// in the same invocation)
+
+template<typename CallbacksType>
+
+void checkReentrancy(TestReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+    Tags tags;
+
+    std::vector<CallbacksLIB::CallbackID> callbackIDs(3, 0);
+
+    CallbacksType* registry = &callbacks;
+    std::vector<CallbacksLIB::CallbackID>* ids = &callbackIDs;
+    Tags* recordedTags = &tags;
+
+    callbackIDs[0] = callbacks.register_callback([registry, ids, recordedTags](int)
+    {
+        recordedTags->push_back(1);
+
+        if((*ids)[2] == 0)
+            (*ids)[2] = registry->register_callback(recorder(*recordedTags, 3));
+
+        registry->deregister_callback((*ids)[1]);
+        registry->deregister_callback((*ids)[0]);
+    });
+
+    callbackIDs[1] = callbacks.register_callback(recorder(tags, 2));
+
+    bool isCorrect = invoke(callbacks, tags) == Tags({1}) &&
+                     callbacks.get_number_of_callbacks() == 1 &&
+                     invoke(callbacks, tags) == Tags({3}) &&
+                     callbacks.list_callbacks().size() == 1;
+
+    report.check(className + " registers and de-registers callbacks from within a callback", isCorrect);
+}
+
+
+
+// A callback registered from within a callback that then
+// throws still goes before the callbacks registered after
+// the invocation
+
+template<typename CallbacksType>
+
+void checkRegistrationAfterThrow(TestReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+    Tags tags;
+
+    bool hasThrown = false;
+
+    CallbacksType* registry = &callbacks;
+    Tags* recordedTags = &tags;
+    bool* thrown = &hasThrown;
+
+    callbacks.register_callback([registry, recordedTags, thrown](int)
+    {
+        recordedTags->push_back(1);
+
+        if(!*thrown)
+        {
+            *thrown = true;
+            registry->register_callback(recorder(*recordedTags, 3));
+            throw std::runtime_error("callback failed");
+        }
+    });
+
+    callbacks.register_callback(recorder(tags, 2));
+
+    bool isCorrect = false;
+
+    try
+    {
+        invoke(callbacks, tags);
+    }
+    catch(const std::runtime_error&)
+    {
+        isCorrect = true;
+    }
+
+    callbacks.register_callback(recorder(tags, 4));
+
+    isCorrect = isCorrect &&
+                callbacks.get_number_of_callbacks() == 4 &&
+                invoke(callbacks, tags) == Tags({1, 2, 3, 4});
+
+    report.check(className + " keeps the callbacks registered before a callback threw in order", isCorrect);
+}
+
+
+
+// A connected callback stays registered for as long as its
+// connection is alive
+
+template<typename CallbacksType>
+
+void checkConnections(TestReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+    Tags tags;
+
+    CallbacksLIB::ScopedConnection movedConnection;
+
+    bool isCorrect = true;
+
+    {
+        CallbacksLIB::ScopedConnection connection = callbacks.connect(recorder(tags, 1));
+        CallbacksLIB::ScopedConnection otherConnection = callbacks.connect(recorder(tags, 2));
+
+        isCorrect = isCorrect && connection.is_connected() && invoke(callbacks, tags) == Tags({1, 2});
+
+        movedConnection = std::move(connection);
+
+        otherConnection.disconnect();
+
+        isCorrect = isCorrect && !otherConnection.is_connected() && invoke(callbacks, tags) == Tags({1});
+    }
+
+    isCorrect = isCorrect && movedConnection.is_connected() && invoke(callbacks, tags) == Tags({1});
+
+    movedConnection = CallbacksLIB::ScopedConnection();
+
+    isCorrect = isCorrect && invoke(callbacks, tags).empty() && !callbacks.has_callbacks();
+
+    report.check(className + " de-registers a connected callback with its connection", isCorrect);
+}
+
+
+
+// A callback can disconnect itself while being invoked, and
+// a connection can outlive the callbacks it was made with
+
+template<typename CallbacksType>
+
+void checkConnectionLifetimes(TestReport& report, const std::string& className)
+{
+    CallbacksLIB::ScopedConnection selfConnection;
+    CallbacksLIB::ScopedConnection danglingConnection;
+    Tags tags;
+
+    bool isCorrect = true;
+
+    {
+        CallbacksType callbacks;
+
+        CallbacksLIB::ScopedConnection* connection = &selfConnection;
+        Tags* recordedTags = &tags;
+
+        selfConnection = callbacks.connect([connection, recordedTags](int)
+        {
+            recordedTags->push_back(1);
+            connection->disconnect();
+        });
+
+        danglingConnection = callbacks.connect(recorder(tags, 2));
+
+        isCorrect = invoke(callbacks, tags) == Tags({1, 2}) &&
+                    invoke(callbacks, tags) == Tags({2}) &&
+                    callbacks.get_number_of_callbacks() == 1;
+    }
+
+    isCorrect = isCorrect && danglingConnection.is_connected();
+
+    danglingConnection.disconnect();
+
+    report.check(className + " disconnects a callback from within itself or after the callbacks are gone", isCorrect);
+}
+
+
+
+// A tracked callback is skipped once its owner is destroyed,
+// and its removal is counted in the statistics
+
+template<typename CallbacksType>
+
+void checkTrackedCallbacks(TestReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+    Tags tags;
+
+    auto firstOwner = std::make_shared<int>(0);
+    auto secondOwner = std::make_shared<int>(0);
+
+    callbacks.register_tracked_callback(firstOwner, recorder(tags, 1));
+    callbacks.register_tracked_callback(secondOwner, recorder(tags, 2));
+    callbacks.register_callback(recorder(tags, 3));
+
+    bool isCorrect = invoke(callbacks, tags) == Tags({1, 2, 3});
+
+    firstOwner.reset();
+
+    isCorrect = isCorrect &&
+                invoke(callbacks, tags) == Tags({2, 3}) &&
+                callbacks.get_number_of_callbacks() == 2 &&
+                callbacks.get_expired_callbacks_statistics().m_numberOfExpiredCallbacksCollected == 1;
+
+    secondOwner.reset();
+
+    isCorrect = isCorrect &&
+                callbacks.collect_expired_callbacks() == 1 &&
+                callbacks.get_number_of_callbacks() == 1 &&
+                callbacks.get_expired_callbacks_statistics().m_numberOfExpiredCallbacksCollected == 2 &&
+                callbacks.get_expired_callbacks_statistics().m_numberOfSweeps == 2 &&
+                invoke(callbacks, tags) == Tags({3});
+
+    report.check(className + " skips and collects the callbacks whose owner was destroyed", isCorrect);
+}
+
+
+
+// Removing a tracked callback (de-registered, or registered
+// from within a callback) leaves the owners of the other
+// tracked callbacks in place
+
+template<typename CallbacksType>
+
+void checkTrackedCallbackRemoval(TestReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+    Tags tags;
+
+    auto firstOwner = std::make_shared<int>(0);
+    auto secondOwner = std::make_shared<int>(0);
+    auto thirdOwner = std::make_shared<int>(0);
+
+    callbacks.register_tracked_callback(firstOwner, recorder(tags, 1));
+    CallbacksLIB::CallbackID callbackID = callbacks.register_tracked_callback(secondOwner, recorder(tags, 2));
+    callbacks.register_tracked_callback(thirdOwner, recorder(tags, 3));
+
+    callbacks.deregister_callback(callbackID);
+
+    bool isCorrect = invoke(callbacks, tags) == Tags({1, 3});
+
+    firstOwner.reset();
+
+    isCorrect = isCorrect && invoke(callbacks, tags) == Tags({3});
+
+    // A tracked callback registered from within a
+    // callback whose owner dies before it is invoked
+
+    CallbacksType* registry = &callbacks;
+    Tags* recordedTags = &tags;
+    std::shared_ptr<int>* owner = &secondOwner;
+
+    callbacks.register_one_shot_callback([registry, recordedTags, owner](int)
+    {
+        registry->register_tracked_callback(*owner, recorder(*recordedTags, 4));
+    });
+
+    isCorrect = isCorrect &&
+                invoke(callbacks, tags) == Tags({3}) &&
+                invoke(callbacks, tags) == Tags({3, 4});
+
+    secondOwner.reset();
+
+    isCorrect = isCorrect &&
+                invoke(callbacks, tags) == Tags({3}) &&
+                callbacks.get_number_of_callbacks() == 1;
+
+    thirdOwner.reset();
+
+    isCorrect = isCorrect && invoke(callbacks, tags).empty() && !callbacks.has_callbacks();
+
+    report.check(className + " keeps the other owners when removing a tracked callback", isCorrect);
+}
+
+
+
+// An invocation that ran out of budget resumes from where
+// it stopped, even if that callback was de-registered
+
+template<typename CallbacksType>
+
+void checkBudgetedInvocation(TestReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+    Tags tags;
+
+    std::vector<CallbacksLIB::CallbackID> callbackIDs;
+
+    for(int tag = 1; tag <= 4; ++tag)
+        callbackIDs.push_back(callbacks.register_callback(recorder(tags, tag), (tag <= 2) ? 1 : 0));
+
+    auto result = callbacks.invokeCallbacksWithinBudget(std::chrono::nanoseconds(0), 0);
+
+    bool isCorrect = !result.m_isComplete &&
+                     result.m_numberOfCallbacksInvoked == 1 &&
+                     result.m_resumeCallbackID == callbackIDs[1] &&
+                     tags == Tags({1});
+
+    callbacks.deregister_callback(callbackIDs[1]);
+
+    result = callbacks.resumeCallbacksWithinBudget(result, std::chrono::seconds(10), 0);
+
+    isCorrect = isCorrect &&
+                result.m_isComplete &&
+                result.m_numberOfCallbacksInvoked == 2 &&
+                result.m_resumeCallbackID == 0 &&
+                tags == Tags({1, 3, 4});
+
+    tags.clear();
+
+    result = callbacks.invokeCallbacksWithinBudget(std::chrono::seconds(10), 0);
+
+    isCorrect = isCorrect &&
+                result.m_isComplete &&
+                result.m_numberOfCallbacksInvoked == 3 &&
+                tags == Tags({1, 3, 4}) &&
+                callbacks.resumeCallbacksWithinBudget(result, std::chrono::seconds(10), 0).m_numberOfCallbacksInvoked == 0;
+
+    report.check(className + " resumes an invocation that ran out of budget", isCorrect);
+}
+
+
+
+// The arguments of a lazy invocation are only built when
+// at least one callback is registered
+
+template<typename CallbacksType>
+
+void checkLazyInvocation(TestReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+    Tags tags;
+
+    int numberOfFactoryCalls = 0;
+
+    auto argumentsFactory = [&numberOfFactoryCalls]
+    {
+        ++numberOfFactoryCalls;
+        return std::make_tuple(7);
+    };
+
+    callbacks.invokeCallbacksLazily(argumentsFactory);
+
+    bool isCorrect = !callbacks.has_callbacks() && numberOfFactoryCalls == 0;
+
+    auto callbackID = callbacks.register_callback([&tags](int argument){ tags.push_back(argument); });
+    callbacks.register_callback(recorder(tags, 1));
+
+    callbacks.invokeCallbacksLazily(argumentsFactory);
+
+    isCorrect = isCorrect &&
+                callbacks.has_callbacks() &&
+                numberOfFactoryCalls == 1 &&
+                tags == Tags({7, 1});
+
+    callbacks.deregister_all_callbacks();
+    callbacks.invokeCallbacksLazily(argumentsFactory);
+
+    isCorrect = isCorrect &&
+                !callbacks.has_callbacks() &&
+                !callbacks.deregister_callback(callbackID) &&
+                numberOfFactoryCalls == 1;
+
+    report.check(className + " builds the lazy arguments only when a callback is registered", isCorrect);
+}
+
+
+
+// The metadata attached to a callback is listed with it,
+// and dropped when the callback is removed
+
+template<typename CallbacksType>
+
+void checkCallbackMetadata(TestReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+    Tags tags;
+
+    int owner = 0;
+
+    CallbacksLIB::CallbackMetadata metadata;
+
+    metadata.m_name = "first";
+    metadata.m_owner = &owner;
+
+    auto firstCallbackID = callbacks.register_callback(recorder(tags, 1));
+    auto secondCallbackID = callbacks.register_one_shot_callback(recorder(tags, 2), 1);
+
+    bool isCorrect = !callbacks.set_callback_metadata(secondCallbackID + 1, metadata) &&
+                     callbacks.set_callback_metadata(firstCallbackID, metadata) &&
+                     callbacks.find_callback_metadata(secondCallbackID) == nullptr &&
+                     callbacks.find_callback_metadata(firstCallbackID)->m_owner == &owner;
+
+    metadata.m_name = "second";
+    metadata.m_description = "one-shot";
+
+    isCorrect = isCorrect && callbacks.set_callback_metadata(secondCallbackID, metadata);
+
+    auto callbacksInfo = callbacks.list_callbacks();
+
+    isCorrect = isCorrect &&
+                callbacksInfo.size() == 2 &&
+                callbacksInfo[0].m_id == secondCallbackID &&
+                callbacksInfo[0].m_priority == 1 &&
+                callbacksInfo[0].m_remainingInvocations == 1 &&
+                callbacksInfo[0].m_metadata.m_description == "one-shot" &&
+                callbacksInfo[1].m_id == firstCallbackID &&
+                callbacksInfo[1].m_remainingInvocations == -1 &&
+                callbacksInfo[1].m_metadata.m_name == "first";
+
+    metadata.m_name = "renamed";
+
+    isCorrect = isCorrect &&
+                callbacks.set_callback_metadata(firstCallbackID, metadata) &&
+                callbacks.find_callback_metadata(firstCallbackID)->m_name == "renamed" &&
+                invoke(callbacks, tags) == Tags({2, 1}) &&
+                callbacks.find_callback_metadata(secondCallbackID) == nullptr &&
+                !callbacks.set_callback_metadata(secondCallbackID, metadata);
+
+    callbacks.deregister_callback(firstCallbackID);
+
+    isCorrect = isCorrect && callbacks.find_callback_metadata(firstCallbackID) == nullptr;
+
+    report.check(className + " keeps the metadata of a callback until it is removed", isCorrect);
+
+    // Callbacks registered from within a callback can get
+    // metadata before they are added
+
+    CallbacksType* registry = &callbacks;
+    std::vector<CallbacksLIB::CallbackInfo> pendingCallbacksInfo;
+
+    callbacks.register_one_shot_callback([registry, &tags, &pendingCallbacksInfo](int)
+    {
+        CallbacksLIB::CallbackMetadata pendingMetadata;
+
+        pendingMetadata.m_name = "pending";
+
+        registry->set_callback_metadata(registry->register_callback(recorder(tags, 3)), pendingMetadata);
+
+        pendingCallbacksInfo = registry->list_callbacks();
+    });
+
+    auto trackedOwner = std::make_shared<int>(0);
+
+    auto trackedCallbackID = callbacks.register_tracked_callback(trackedOwner, recorder(tags, 4), -1);
+
+    callbacks.set_callback_metadata(trackedCallbackID, metadata);
+
+    invoke(callbacks, tags);
+
+    isCorrect = pendingCallbacksInfo.size() == 2 &&
+                pendingCallbacksInfo[0].m_isTracked &&
+                !pendingCallbacksInfo[0].m_isPending &&
+                pendingCallbacksInfo[1].m_isPending &&
+                pendingCallbacksInfo[1].m_metadata.m_name == "pending" &&
+                callbacks.list_callbacks().size() == 2 &&
+                callbacks.list_callbacks()[0].m_metadata.m_name == "pending";
+
+    callbacks.deregister_all_callbacks();
+
+    isCorrect = isCorrect &&
+                callbacks.find_callback_metadata(trackedCallbackID) == nullptr &&
+                callbacks.list_callbacks().empty();
+
+    report.check(className + " lists the callbacks with their metadata", isCorrect);
+}
+
+
+
+// A moved callback system keeps the IDs of its callbacks,
+// and the moved-from one is left empty but usable
+
+template<typename CallbacksType>
+
+void checkMovedCallbacks(TestReport& report, const std::string& className)
+{
+    Tags tags;
+
+    std::vector<CallbacksType> registries(1);
+
+    auto firstCallbackID = registries[0].register_callback(recorder(tags, 1));
+    auto secondCallbackID = registries[0].register_one_shot_callback(recorder(tags, 2));
+
+    CallbacksLIB::CallbackMetadata metadata;
+
+    metadata.m_name = "moved";
+
+    registries[0].set_callback_metadata(firstCallbackID, metadata);
+
+    // Growing the vector moves the callback systems
+
+    registries.resize(8);
+
+    CallbacksType callbacks(std::move(registries[0]));
+
+    bool isCorrect = invoke(callbacks, tags) == Tags({1, 2}) &&
+                     callbacks.find_callback_metadata(firstCallbackID)->m_name == "moved" &&
+                     !registries[0].has_callbacks() &&
+                     invoke(registries[0], tags).empty();
+
+    auto newCallbackID = registries[0].register_callback(recorder(tags, 3));
+
+    isCorrect = isCorrect &&
+                newCallbackID != firstCallbackID &&
+                newCallbackID != secondCallbackID &&
+                invoke(registries[0], tags) == Tags({3});
+
+    registries[1] = std::move(callbacks);
+
+    isCorrect = isCorrect &&
+                !callbacks.has_callbacks() &&
+                registries[1].deregister_callback(firstCallbackID) &&
+                !registries[1].has_callbacks();
+
+    report.check(className + " keeps the callback IDs valid when moved", isCorrect);
+}
+
+
+
+// A clone gets the same callbacks, IDs and metadata, then
+// changes independently of the original
+
+template<typename CallbacksType>
+
+void checkClonedCallbacks(TestReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+    Tags tags;
+
+    auto firstCallbackID = callbacks.register_callback(recorder(tags, 1));
+    auto secondCallbackID = callbacks.register_one_shot_callback(recorder(tags, 2));
+
+    CallbacksLIB::CallbackMetadata metadata;
+
+    metadata.m_name = "cloned";
+
+    callbacks.set_callback_metadata(firstCallbackID, metadata);
+
+    CallbacksType clone = callbacks.clone();
+
+    bool isCorrect = clone.get_number_of_callbacks() == 2 &&
+                     clone.find_callback_metadata(firstCallbackID)->m_name == "cloned" &&
+                     invoke(clone, tags) == Tags({1, 2}) &&
+                     invoke(callbacks, tags) == Tags({1, 2});
+
+    auto cloneCallbackID = clone.register_callback(recorder(tags, 3));
+
+    isCorrect = isCorrect &&
+                callbacks.deregister_callback(firstCallbackID) &&
+                invoke(callbacks, tags).empty() &&
+                invoke(clone, tags) == Tags({1, 3}) &&
+                !callbacks.deregister_callback(cloneCallbackID) &&
+                !clone.deregister_callback(secondCallbackID);
+
+    clone.deregister_all_callbacks();
+
+    isCorrect = isCorrect &&
+                !clone.has_callbacks() &&
+                callbacks.get_number_of_callbacks() == 0;
+
+    report.check(className + " clones are independent of the original", isCorrect);
+}
+
+
+
+// The IDs are never reused, and only is_registered_callback()
+// tells whether a callback is still registered
+
+template<typename CallbacksType>
+
+void checkCallbackIDs(TestReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+    Tags tags;
+
+    std::vector<CallbacksLIB::CallbackID> callbackIDs;
+
+    for(int i = 0; i < 3; ++i)
+        callbackIDs.push_back(callbacks.register_callback(recorder(tags, i)));
+
+    callbacks.deregister_callback(callbackIDs[2]);
+    callbacks.deregister_all_callbacks();
+
+    auto newCallbackID = callbacks.register_callback(recorder(tags, 3));
+
+    bool isCorrect = newCallbackID > callbackIDs[2] &&
+                     callbacks.is_assigned_callback_id(callbackIDs[2]) &&
+                     !callbacks.is_registered_callback(callbackIDs[2]) &&
+                     callbacks.is_registered_callback(newCallbackID) &&
+                     !callbacks.is_assigned_callback_id(0) &&
+                     !callbacks.is_assigned_callback_id(newCallbackID + 1) &&
+                     !callbacks.is_registered_callback(newCallbackID + 1);
+
+    // A callback registered while invoking the callbacks
+    // is registered before it is added
+
+    CallbacksType* registry = &callbacks;
+    bool isPendingCallbackRegistered = false;
+
+    callbacks.register_one_shot_callback([registry, &tags, &isPendingCallbackRegistered](int)
+    {
+        auto pendingCallbackID = registry->register_callback(recorder(tags, 4));
+
+        isPendingCallbackRegistered = registry->is_registered_callback(pendingCallbackID);
+    });
+
+    invoke(callbacks, tags);
+
+    isCorrect = isCorrect &&
+                isPendingCallbackRegistered &&
+                callbacks.get_number_of_callbacks() == 2;
+
+    report.check(className + " never reuses the IDs of the removed callbacks", isCorrect);
+}
+
+
+
+// Callbacks registered together keep their order among the
+// callbacks of the same priority, and are de-registered
+// together
+
+template<typename CallbacksType>
+
+void checkBulkFunctions(TestReport& report, const std::string& className)
+{
+    CallbacksType callbacks;
+    Tags tags;
+
+    callbacks.register_callback(recorder(tags, 1));
+    callbacks.register_callback(recorder(tags, 2), 2);
+
+    std::vector<Recorder> newCallbacks;
+
+    for(int tag = 3; tag <= 5; ++tag)
+        newCallbacks.push_back(recorder(tags, tag));
+
+    auto callbackIDs = callbacks.register_callbacks(newCallbacks, 1);
+    auto otherCallbackIDs = callbacks.register_callbacks({recorder(tags, 6), recorder(tags, 7)});
+
+    bool isCorrect = callbackIDs.size() == 3 &&
+                     callbackIDs[0] < callbackIDs[1] &&
+                     callbackIDs[1] < callbackIDs[2] &&
+                     otherCallbackIDs.size() == 2 &&
+                     callbacks.get_number_of_callbacks() == 7 &&
+                     invoke(callbacks, tags) == Tags({2, 3, 4, 5, 1, 6, 7});
+
+    // Unknown and repeated IDs are ignored
+
+    std::vector<CallbacksLIB::CallbackID> removedCallbackIDs = {callbackIDs[0], callbackIDs[2], callbackIDs[2], otherCallbackIDs[1] + 100};
+
+    isCorrect = isCorrect &&
+                callbacks.deregister_callbacks(removedCallbackIDs) == 2 &&
+                callbacks.deregister_callbacks({otherCallbackIDs[0]}) == 1 &&
+                callbacks.deregister_callbacks(removedCallbackIDs) == 0 &&
+                invoke(callbacks, tags) == Tags({2, 4, 1, 7});
+
+    report.check(className + " registers and de-registers callbacks in bulk", isCorrect);
+}
+
+
+
+// Function running all the checks on a callback system
+
+template<typename CallbacksType>
+
+void checkCallbacks(TestReport& report, const std::string& className)
+{
+    checkPriorityOrder<CallbacksType>(report, className);
+    checkPriorityInsertion<CallbacksType>(report, className);
+    checkCountedCallbacks<CallbacksType>(report, className);
+    checkNestedOneShotCallbacks<CallbacksType>(report, className);
+    checkReentrancy<CallbacksType>(report, className);
+    checkRegistrationAfterThrow<CallbacksType>(report, className);
+    checkConnections<CallbacksType>(report, className);
+    checkConnectionLifetimes<CallbacksType>(report, className);
+    checkTrackedCallbacks<CallbacksType>(report, className);
+    checkTrackedCallbackRemoval<CallbacksType>(report, className);
+    checkBudgetedInvocation<CallbacksType>(report, className);
+    checkLazyInvocation<CallbacksType>(report, className);
+    checkCallbackMetadata<CallbacksType>(report, className);
+    checkMovedCallbacks<CallbacksType>(report, className);
+    checkClonedCallbacks<CallbacksType>(report, className);
+    checkCallbackIDs<CallbacksType>(report, className);
+    checkBulkFunctions<CallbacksType>(report, className);
+}
+
+
+
+// The clones of a copy-on-write callback system share the
+// callables until one of them modifies its callbacks
+
+class CountingCallback
+{
+public:
+
+    explicit CountingCallback(Tags& tags) : m_tags(&tags){}
+
+    void operator()(int)
+    {
+        m_tags->push_back(++m_numberOfCalls);
+    }
+
+private:
+
+    Tags*                               m_tags;
+    int                                 m_numberOfCalls = 0;
+};
+
+
+
+void checkCopyOnWriteClones(TestReport& report)
+{
+    CallbacksLIB::CopyOnWriteCallbacks<void,int> callbacks;
+    Tags tags;
+
+    callbacks.register_callback(CountingCallback(tags));
+
+    auto clone = callbacks.clone();
+
+    callbacks.invokeCallbacks(0);
+    clone.invokeCallbacks(0);
+
+    bool isCorrect = tags == Tags({1, 2});
+
+    // Registering copies the callbacks of the clone
+
+    clone.register_callback(recorder(tags, 10));
+
+    isCorrect = isCorrect &&
+                invoke(callbacks, tags) == Tags({3}) &&
+                invoke(clone, tags) == Tags({3, 10}) &&
+                invoke(callbacks, tags) == Tags({4});
+
+    auto sharingClone = callbacks.clone();
+
+    sharingClone.deregister_all_callbacks();
+
+    isCorrect = isCorrect &&
+                !sharingClone.has_callbacks() &&
+                invoke(callbacks, tags) == Tags({5});
+
+    report.check("CopyOnWriteCallbacks clones share the callables until they are modified", isCorrect);
+}
+
+
+
+// The callbacks registered in bulk that don't fit a fixed
+// callback system get the ID 0
+
+void checkFullFixedCallbacks(TestReport& report)
+{
+    CallbacksLIB::FixedCallbacks<4,void,int> callbacks;
+    Tags tags;
+
+    callbacks.register_callback(recorder(tags, 1));
+
+    std::vector<Recorder> newCallbacks;
+
+    for(int tag = 2; tag <= 6; ++tag)
+        newCallbacks.push_back(recorder(tags, tag));
+
+    auto callbackIDs = callbacks.register_callbacks(newCallbacks);
+
+    bool isCorrect = callbackIDs.size() == 5 &&
+                     callbackIDs[2] != 0 &&
+                     callbackIDs[3] == 0 &&
+                     callbackIDs[4] == 0 &&
+                     invoke(callbacks, tags) == Tags({1, 2, 3, 4});
+
+    report.check("FixedCallbacks gives the ID 0 to the callbacks that don't fit", isCorrect);
+}
+
+
+
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// main function
+//-------------------------------------------------------------------
+int main()
+{
+    TestReport report;
+
+    checkCallbacks<CallbacksLIB::Callbacks<void,int>>(report, "Callbacks");
+    checkCallbacks<CallbacksLIB::SegmentedCallbacks<void,int>>(report, "SegmentedCallbacks");
+    checkCallbacks<CallbacksLIB::SmallCallbacks<4,void,int>>(report, "SmallCallbacks");
+    checkCallbacks<CallbacksLIB::FixedCallbacks<16,void,int>>(report, "FixedCallbacks");
+    checkCallbacks<CallbacksLIB::IndexedCallbacks<void,int>>(report, "IndexedCallbacks");
+    checkCallbacks<CallbacksLIB::CopyOnWriteCallbacks<void,int>>(report, "CopyOnWriteCallbacks");
+
+    checkCopyOnWriteClones(report);
+    checkFullFixedCallbacks(report);
+
+    return report.exit_code();
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,220 @@
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Test checking the latency instrumentation defined in
+/// callbacks_instrumentation.hpp
+///
+/// -- The histograms are checked with known durations (their percentiles
+///    must be within the precision of the buckets)
+///
+/// -- The instrumented callback systems are checked for the number of calls
+///    recorded for each callback, and for the statistics folded into those
+///    of the removed callbacks.  The only timing check uses a callback
+///    sleeping for a few milliseconds, far above the precision of the clock
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+#include "callbacks_instrumentation.hpp"
+#include "test_report.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <thread>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Helpers used by the test
+//-------------------------------------------------------------------
+namespace
+{
+
+
+
+using TestsLIB::TestReport;
+
+using InstrumentedCallbacks = CallbacksLIB::BasicCallbacks<CallbacksLIB::LatencyInstrumentedCallbacksPolicy,void,int>;
+
+
+
+// Function used to check that a measured value is
+// within the specified relative precision
+
+bool isWithin(double value, double expectedValue, double precision)
+{
+    return std::fabs(value - expectedValue) <= precision * expectedValue;
+}
+
+
+
+// The percentiles of a histogram are within the
+// precision of its buckets, and merging histograms
+// adds their durations
+
+void checkHistogram(TestReport& report)
+{
+    CallbacksLIB::LatencyHistogram histogram;
+
+    for(std::uint64_t ticks = 1; ticks <= 10000; ++ticks)
+        histogram.record(ticks);
+
+    bool isCorrect = histogram.total_count() == 10000 &&
+                     histogram.maximum() == 10000 &&
+                     isWithin(histogram.value_at_percentile(50.0), 5000, 0.04) &&
+                     isWithin(histogram.value_at_percentile(99.0), 9900, 0.04) &&
+                     histogram.value_at_percentile(100.0) <= 10000;
+
+    report.check("LatencyHistogram computes the percentiles within the precision of its buckets", isCorrect);
+
+    CallbacksLIB::LatencyHistogram otherHistogram;
+
+    otherHistogram.record(20000);
+    otherHistogram.merge(histogram);
+
+    isCorrect = otherHistogram.total_count() == 10001 &&
+                otherHistogram.maximum() == 20000 &&
+                isWithin(otherHistogram.value_at_percentile(50.0), 5000, 0.04);
+
+    histogram.clear();
+
+    isCorrect = isCorrect &&
+                histogram.total_count() == 0 &&
+                histogram.value_at_percentile(50.0) == 0;
+
+    report.check("LatencyHistogram merges and clears the recorded durations", isCorrect);
+}
+
+
+
+// Each callback has its own number of calls, and callbacks
+// that were never invoked have no statistics
+
+void checkNumberOfCalls(TestReport& report)
+{
+    InstrumentedCallbacks callbacks;
+
+    auto firstCallbackID = callbacks.register_callback([](int){});
+    auto secondCallbackID = callbacks.register_callback_n_times([](int){}, 2);
+
+    for(int i = 0; i < 3; ++i)
+        callbacks.invokeCallbacks(0);
+
+    auto snapshot = callbacks.instrumentation().get_latency_snapshot();
+
+    bool isCorrect = snapshot.size() == 1 &&
+                     snapshot[0].m_callbackID == firstCallbackID &&
+                     snapshot[0].m_numberOfCalls == 3 &&
+                     callbacks.instrumentation().get_latency_snapshot(secondCallbackID).m_numberOfCalls == 0 &&
+                     callbacks.instrumentation().get_removed_callbacks_latency_snapshot().m_numberOfCalls == 2;
+
+    auto thirdCallbackID = callbacks.register_callback([](int){});
+
+    isCorrect = isCorrect &&
+                callbacks.instrumentation().get_latency_snapshot(thirdCallbackID).m_numberOfCalls == 0 &&
+                callbacks.instrumentation().get_latency_snapshot().size() == 1;
+
+    report.check("LatencyInstrumentation counts the calls of each callback", isCorrect);
+}
+
+
+
+// De-registered callbacks fold their statistics into those
+// of the removed callbacks, and reset() discards them all
+
+void checkRemovedCallbacks(TestReport& report)
+{
+    InstrumentedCallbacks callbacks;
+
+    auto callbackID = callbacks.register_callback([](int){});
+    callbacks.register_callback([](int){});
+
+    callbacks.invokeCallbacks(0);
+    callbacks.invokeCallbacks(0);
+
+    callbacks.deregister_callback(callbackID);
+
+    bool isCorrect = callbacks.instrumentation().get_latency_snapshot(callbackID).m_numberOfCalls == 0 &&
+                     callbacks.instrumentation().get_removed_callbacks_latency_snapshot().m_numberOfCalls == 2 &&
+                     callbacks.instrumentation().get_latency_snapshot().size() == 1;
+
+    callbacks.deregister_all_callbacks();
+
+    isCorrect = isCorrect &&
+                callbacks.instrumentation().get_removed_callbacks_latency_snapshot().m_numberOfCalls == 4 &&
+                callbacks.instrumentation().get_latency_snapshot().empty();
+
+    callbacks.register_callback([](int){});
+    callbacks.invokeCallbacks(0);
+
+    callbacks.instrumentation().reset();
+
+    isCorrect = isCorrect &&
+                callbacks.instrumentation().get_removed_callbacks_latency_snapshot().m_numberOfCalls == 0 &&
+                callbacks.instrumentation().get_latency_snapshot().empty();
+
+    report.check("LatencyInstrumentation folds the statistics of the removed callbacks", isCorrect);
+}
+
+
+
+// The latency of a slow callback is measured (its
+// percentiles are ordered and close to its duration)
+
+void checkLatency(TestReport& report)
+{
+    InstrumentedCallbacks callbacks;
+
+    auto callbackID = callbacks.register_callback([](int)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    });
+
+    for(int i = 0; i < 5; ++i)
+        callbacks.invokeCallbacks(0);
+
+    auto snapshot = callbacks.instrumentation().get_latency_snapshot(callbackID);
+
+    bool isCorrect = snapshot.m_numberOfCalls == 5 &&
+                     snapshot.m_p50Nanoseconds >= 1.5e6 &&
+                     snapshot.m_p50Nanoseconds <= snapshot.m_p99Nanoseconds &&
+                     snapshot.m_p99Nanoseconds <= snapshot.m_maximumNanoseconds;
+
+    report.check("LatencyInstrumentation measures the latency of a slow callback", isCorrect);
+}
+
+
+
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// main function
+//-------------------------------------------------------------------
+int main()
+{
+    TestReport report;
+
+    checkHistogram(report);
+    checkNumberOfCalls(report);
+    checkRemovedCallbacks(report);
+    checkLatency(report);
+
+    return report.exit_code();
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,266 @@
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Test checking the deferred reclamation defined in callbacks_reclamation.hpp
+///
+/// -- The callbacks capture a Witness, which records the thread destroying
+///    the last copy of its state, so the checks can tell which thread
+///    destroyed the removed callbacks
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+#include "callbacks_reclamation.hpp"
+#include "test_report.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Helpers used by the test
+//-------------------------------------------------------------------
+namespace
+{
+
+
+
+using TestsLIB::TestReport;
+using CallbacksLIB::CallbacksReclaimer;
+
+using DeferredCallbacks = CallbacksLIB::BasicCallbacks<CallbacksLIB::DeferredReclamationCallbacksPolicy,void,int>;
+
+
+
+// What the witnesses recorded
+
+struct Destructions
+{
+    std::atomic<int>                    m_numberOfDestructions{0};
+    std::atomic<int>                    m_numberOfDestructionsOnThisThread{0};
+    std::thread::id                     m_threadID = std::this_thread::get_id();
+};
+
+
+
+// State captured by the callbacks, recording the thread
+// that destroys it
+
+class Witness
+{
+public:
+
+    explicit Witness(Destructions& destructions) : m_destructions(&destructions){}
+
+    ~Witness()
+    {
+        m_destructions->m_numberOfDestructions.fetch_add(1);
+
+        if(std::this_thread::get_id() == m_destructions->m_threadID)
+            m_destructions->m_numberOfDestructionsOnThisThread.fetch_add(1);
+    }
+
+private:
+
+    Destructions*                       m_destructions;
+};
+
+
+
+// Function used to make a callback whose state is
+// destroyed with its last copy
+
+std::function<void(int)> witnessCallback(Destructions& destructions)
+{
+    std::shared_ptr<Witness> witness = std::make_shared<Witness>(destructions);
+
+    return [witness](int){};
+}
+
+
+
+// The removed callbacks are destroyed by the background
+// thread, whether they are removed one by one, used up or
+// removed all at once
+
+void checkDeferredDestruction(TestReport& report)
+{
+    Destructions destructions;
+    CallbacksReclaimer reclaimer;
+
+    DeferredCallbacks callbacks;
+
+    callbacks.reclamation().set_reclaimer(reclaimer);
+
+    auto callbackID = callbacks.register_callback(witnessCallback(destructions));
+
+    callbacks.register_one_shot_callback(witnessCallback(destructions));
+    callbacks.register_one_shot_callback(witnessCallback(destructions));
+
+    callbacks.deregister_callback(callbackID);
+    callbacks.invokeCallbacks(0);
+
+    for(int i = 0; i < 3; ++i)
+        callbacks.register_callback(witnessCallback(destructions));
+
+    callbacks.deregister_all_callbacks();
+
+    reclaimer.flush();
+
+    bool isCorrect = destructions.m_numberOfDestructions == 6 &&
+                     destructions.m_numberOfDestructionsOnThisThread == 0 &&
+                     reclaimer.get_number_of_reclaimed_objects() == 3;
+
+    report.check("DeferredReclamation destroys the removed callbacks on the background thread", isCorrect);
+}
+
+
+
+// The holders carrying the removed callbacks are reused,
+// and the callbacks queued faster than the reclaimer
+// destroys them are all destroyed
+
+void checkReusedHolders(TestReport& report)
+{
+    Destructions destructions;
+    CallbacksReclaimer reclaimer;
+
+    DeferredCallbacks callbacks;
+
+    callbacks.reclamation().set_reclaimer(reclaimer);
+
+    const int numberOfPasses = 100;
+
+    for(int pass = 0; pass < numberOfPasses; ++pass)
+    {
+        for(int i = 0; i < 4; ++i)
+            callbacks.register_callback(witnessCallback(destructions));
+
+        callbacks.deregister_all_callbacks();
+
+        callbacks.register_one_shot_callback(witnessCallback(destructions));
+        callbacks.invokeCallbacks(0);
+    }
+
+    reclaimer.flush();
+
+    bool isCorrect = destructions.m_numberOfDestructions == 5 * numberOfPasses &&
+                     destructions.m_numberOfDestructionsOnThisThread == 0 &&
+                     reclaimer.get_number_of_reclaimed_objects() == 2 * numberOfPasses &&
+                     !callbacks.has_callbacks();
+
+    report.check("DeferredReclamation reuses the holders of the removed callbacks", isCorrect);
+}
+
+
+
+// Callbacks queued by a callback system are destroyed even
+// if the callback system is destroyed first, while the ones
+// still registered are destroyed with the callback system
+
+void checkDestroyedCallbackSystem(TestReport& report)
+{
+    Destructions destructions;
+    CallbacksReclaimer reclaimer;
+
+    {
+        DeferredCallbacks callbacks;
+
+        callbacks.reclamation().set_reclaimer(reclaimer);
+
+        for(int i = 0; i < 3; ++i)
+            callbacks.register_callback(witnessCallback(destructions));
+
+        callbacks.deregister_all_callbacks();
+
+        callbacks.register_callback(witnessCallback(destructions));
+    }
+
+    bool isCorrect = destructions.m_numberOfDestructionsOnThisThread == 1;
+
+    reclaimer.flush();
+
+    isCorrect = isCorrect && destructions.m_numberOfDestructions == 4;
+
+    report.check("DeferredReclamation destroys the queued callbacks of a destroyed callback system", isCorrect);
+}
+
+
+
+// The global reclaimer is the same for every callback
+// system, and is never destroyed
+
+void checkGlobalReclaimer(TestReport& report)
+{
+    DeferredCallbacks firstCallbacks;
+    DeferredCallbacks secondCallbacks;
+
+    bool isCorrect = &firstCallbacks.reclamation().reclaimer() == &CallbacksReclaimer::global() &&
+                     &secondCallbacks.reclamation().reclaimer() == &CallbacksReclaimer::global();
+
+    report.check("DeferredReclamation uses the global reclaimer by default", isCorrect);
+}
+
+
+
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Static object created before the global reclaimer, whose callbacks
+// are removed after main() returned, once the static objects created
+// after it have been destroyed
+//-------------------------------------------------------------------
+struct StaticCallbacksOwner
+{
+    ~StaticCallbacksOwner()
+    {
+        if(m_callbacks)
+            m_callbacks->deregister_all_callbacks();
+    }
+
+    std::unique_ptr<DeferredCallbacks>  m_callbacks;
+};
+
+StaticCallbacksOwner g_staticCallbacksOwner;
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// main function
+//-------------------------------------------------------------------
+int main()
+{
+    TestReport report;
+
+    checkDeferredDestruction(report);
+    checkReusedHolders(report);
+    checkDestroyedCallbackSystem(report);
+    checkGlobalReclaimer(report);
+
+    g_staticCallbacksOwner.m_callbacks.reset(new DeferredCallbacks());
+
+    for(int i = 0; i < 3; ++i)
+        g_staticCallbacksOwner.m_callbacks->register_callback([](int){});
+
+    return report.exit_code();
+}
+//-------------------------------------------------------------------
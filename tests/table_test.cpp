@@ -0,0 +1,196 @@
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Test checking the side tables of callback systems defined in
+/// callbacks_table.hpp
+///
+/// -- The objects are plain ints, only their addresses are used as keys
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+#include "callbacks_table.hpp"
+#include "test_report.hpp"
+
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Helpers used by the test
+//-------------------------------------------------------------------
+namespace
+{
+
+
+
+using TestsLIB::TestReport;
+using CallbacksLIB::CallbackID;
+
+using CallbacksTable = CallbacksLIB::CallbacksTable<void,int>;
+
+
+
+// The tags recorded by the invoked callbacks
+
+using Tags = std::vector<int>;
+
+
+
+// Each object only gets its own callbacks, and leaves the
+// table once it has no callback left
+
+void checkObjectCallbacks(TestReport& report)
+{
+    CallbacksTable table;
+    Tags tags;
+
+    int firstObject = 0;
+    int secondObject = 0;
+
+    auto callbackID = table.register_callback(&firstObject, [&tags](int){ tags.push_back(1); });
+    table.register_callback(&firstObject, [&tags](int){ tags.push_back(2); }, 1);
+    table.register_one_shot_callback(&secondObject, [&tags](int){ tags.push_back(3); });
+
+    table.invokeCallbacks(&firstObject, 0);
+    table(&secondObject, 0);
+
+    bool isCorrect = tags == Tags({2, 1, 3}) &&
+                     table.get_number_of_objects() == 1 &&
+                     table.get_number_of_callbacks(&firstObject) == 2 &&
+                     !table.has_callbacks(&secondObject) &&
+                     table.find(&secondObject) == nullptr &&
+                     !table.deregister_callback(&secondObject, callbackID) &&
+                     table.deregister_callback(&firstObject, callbackID);
+
+    table.deregister_all_callbacks(&firstObject);
+
+    isCorrect = isCorrect &&
+                table.get_number_of_objects() == 0 &&
+                !table.has_callbacks(&firstObject);
+
+    report.check("CallbacksTable keeps the callbacks of each object apart", isCorrect);
+}
+
+
+
+// The IDs of the callbacks of an object that lost all of
+// its callbacks never de-register the callbacks registered
+// later, even with a recycled callback system
+
+void checkStaleCallbackIDs(TestReport& report)
+{
+    CallbacksTable table;
+    Tags tags;
+
+    int firstObject = 0;
+    int secondObject = 0;
+
+    // The first object gets more IDs than the second
+    // one, whose callback system is recycled last
+
+    std::vector<CallbackID> firstCallbackIDs;
+
+    for(int i = 0; i < 4; ++i)
+        firstCallbackIDs.push_back(table.register_callback(&firstObject, [](int){}));
+
+    table.register_callback(&secondObject, [](int){});
+
+    table.deregister_all_callbacks(&firstObject);
+    table.deregister_all_callbacks(&secondObject);
+
+    // Register again, then de-register with the
+    // stale IDs
+
+    table.register_callback(&firstObject, [&tags](int){ tags.push_back(1); });
+    table.register_callback(&firstObject, [&tags](int){ tags.push_back(2); });
+
+    bool isCorrect = table.get_number_of_objects() == 1;
+
+    for(CallbackID callbackID : firstCallbackIDs)
+        isCorrect = isCorrect && !table.deregister_callback(&firstObject, callbackID);
+
+    table.invokeCallbacks(&firstObject, 0);
+
+    isCorrect = isCorrect &&
+                tags == Tags({1, 2}) &&
+                table.get_number_of_callbacks(&firstObject) == 2;
+
+    // Same after freeing the unused callback systems
+
+    table.deregister_all_callbacks(&firstObject);
+    table.release_unused_lists();
+
+    auto callbackID = table.register_callback(&secondObject, [](int){});
+
+    isCorrect = isCorrect &&
+                callbackID > firstCallbackIDs.back() + 2 &&
+                !table.deregister_callback(&secondObject, firstCallbackIDs.front()) &&
+                table.get_number_of_callbacks(&secondObject) == 1;
+
+    report.check("CallbacksTable doesn't reuse the IDs of a drained object", isCorrect);
+}
+
+
+
+// Objects emptied while their callbacks run leave the
+// table once the invocation has returned
+
+void checkCallbacksRemovedWhileInvoking(TestReport& report)
+{
+    CallbacksTable table;
+    Tags tags;
+
+    int object = 0;
+
+    CallbacksTable* callbacksTable = &table;
+
+    table.register_callback(&object, [&tags, callbacksTable, &object](int)
+    {
+        tags.push_back(1);
+        callbacksTable->deregister_all_callbacks(&object);
+    });
+
+    table.register_callback(&object, [&tags](int){ tags.push_back(2); });
+
+    table.invokeCallbacks(&object, 0);
+
+    bool isCorrect = tags == Tags({1}) &&
+                     table.get_number_of_objects() == 0 &&
+                     table.find(&object) == nullptr;
+
+    report.check("CallbacksTable removes an object emptied by its own callbacks", isCorrect);
+}
+
+
+
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// main function
+//-------------------------------------------------------------------
+int main()
+{
+    TestReport report;
+
+    checkObjectCallbacks(report);
+    checkStaleCallbackIDs(report);
+    checkCallbacksRemovedWhileInvoking(report);
+
+    return report.exit_code();
+}
+//-------------------------------------------------------------------
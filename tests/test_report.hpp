@@ -0,0 +1,111 @@
+#ifndef TEST_REPORT_HPP
+#define TEST_REPORT_HPP
+
+
+
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Helper used by the functional tests to check the behavior of the callback
+/// systems and report the checks that failed
+///
+/// -- Each check prints its name and whether it passed, and main() returns
+///    the exit code of the report (non-zero if any check failed):
+///
+///        TestReport report;
+///
+///        report.check("Callbacks invokes the callbacks by priority", tags == expectedTags);
+///
+///        return report.exit_code();
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include <cstdio>
+#include <string>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Test helpers are defined within the namespace TestsLIB
+//-------------------------------------------------------------------
+namespace TestsLIB
+{
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Class used to check the results of a test and report the ones
+// that don't match
+//-------------------------------------------------------------------
+class TestReport
+{
+public: // Public functions
+
+
+
+    // Function used to report whether a result
+    // is correct
+
+    void check(const std::string& name, bool isCorrect)
+    {
+        std::printf("%-90s %s\n", name.c_str(), isCorrect ? "ok" : "FAILED");
+
+        if(!isCorrect)
+            ++m_numberOfFailures;
+    }
+
+
+
+    int number_of_failures()const
+    {
+        return m_numberOfFailures;
+    }
+
+
+
+    // Function used to get the exit code of the test
+    // (printing how many checks failed, if any)
+
+    int exit_code()const
+    {
+        if(m_numberOfFailures == 0)
+            return 0;
+
+        std::printf("\n%d check(s) failed\n", m_numberOfFailures);
+
+        return 1;
+    }
+
+
+
+private: // Private variables
+
+
+
+    int                                 m_numberOfFailures = 0;
+};
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// End of TestsLIB namespace
+//-------------------------------------------------------------------
+}
+//-------------------------------------------------------------------
+
+
+
+#endif // TEST_REPORT_HPP
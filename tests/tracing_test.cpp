@@ -0,0 +1,237 @@
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Test checking the tracing of the callback systems defined in
+/// callbacks_tracing.hpp
+///
+/// -- The traces are written to strings and searched for the recorded
+///    spans, so the checks don't depend on the timings
+///
+/// -- The main thread prepares its buffer first, so it is always the
+///    thread 1 of the traces
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+#include "callbacks_tracing.hpp"
+#include "test_report.hpp"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Helpers used by the test
+//-------------------------------------------------------------------
+namespace
+{
+
+
+
+using TestsLIB::TestReport;
+using CallbacksLIB::CallbacksTracer;
+
+using TracedCallbacks = CallbacksLIB::BasicCallbacks<CallbacksLIB::TracingCallbacksPolicy,void,int>;
+
+
+
+// Function used to write the recorded events to a string
+
+std::string writeTrace(std::size_t& numberOfEvents)
+{
+    std::ostringstream trace;
+
+    numberOfEvents = CallbacksTracer::write_chrome_trace(trace);
+
+    return trace.str();
+}
+
+
+
+// Function used to count the occurrences of a
+// text in a trace
+
+std::size_t count(const std::string& trace, const std::string& text)
+{
+    std::size_t numberOfOccurrences = 0;
+
+    for(std::size_t position = trace.find(text); position != std::string::npos; position = trace.find(text, position + 1))
+        ++numberOfOccurrences;
+
+    return numberOfOccurrences;
+}
+
+
+
+// Nothing is recorded while tracing is off, and each
+// invocation records a span for the invocation and
+// one for each callback once it is on
+
+void checkRecordedSpans(TestReport& report)
+{
+    TracedCallbacks callbacks;
+
+    callbacks.instrumentation().set_trace_name("udp_messages");
+
+    callbacks.register_callback([](int){});
+    callbacks.register_callback([](int){});
+
+    callbacks.invokeCallbacks(0);
+
+    std::size_t numberOfEvents = 0;
+    std::string trace = writeTrace(numberOfEvents);
+
+    bool isCorrect = numberOfEvents == 0 && trace.find("traceEvents") != std::string::npos;
+
+    report.check("CallbacksTracer records nothing while tracing is off", isCorrect);
+
+    CallbacksTracer::enable();
+
+    callbacks.invokeCallbacks(0);
+
+    CallbacksTracer::disable();
+
+    trace = writeTrace(numberOfEvents);
+
+    isCorrect = numberOfEvents == 3 &&
+                count(trace, "\"cat\":\"invocation\",\"name\":\"udp_messages\"") == 1 &&
+                count(trace, "\"cat\":\"callback\",\"name\":\"udp_messages #") == 2 &&
+                count(trace, "\"tid\":1,") == 3 &&
+                writeTrace(numberOfEvents).find("udp_messages") == std::string::npos;
+
+    report.check("CallbacksTracer records the invocations and the callbacks once enabled", isCorrect);
+}
+
+
+
+// The names written in the trace are escaped
+
+void checkEscapedNames(TestReport& report)
+{
+    TracedCallbacks callbacks;
+
+    callbacks.instrumentation().set_trace_name("say \"hello\"\n");
+
+    callbacks.register_callback([](int){});
+
+    CallbacksTracer::enable();
+
+    callbacks.invokeCallbacks(0);
+
+    CallbacksTracer::disable();
+
+    std::size_t numberOfEvents = 0;
+    std::string trace = writeTrace(numberOfEvents);
+
+    bool isCorrect = numberOfEvents == 2 &&
+                     count(trace, "say \\\"hello\\\"\\u000a") == 2 &&
+                     trace.find("\"hello\"") == std::string::npos;
+
+    report.check("CallbacksTracer escapes the names written in the trace", isCorrect);
+}
+
+
+
+// The buffers of the threads that exited are freed once
+// their events are written (their events, and the events
+// they dropped, are still reported), and their thread IDs
+// are not reused
+
+void checkExitedThreads(TestReport& report)
+{
+    TracedCallbacks callbacks;
+
+    callbacks.instrumentation().set_trace_name("worker");
+
+    callbacks.register_callback([](int){});
+
+    std::size_t numberOfBuffers = CallbacksTracer::get_number_of_thread_buffers();
+
+    CallbacksTracer::enable();
+
+    std::vector<std::thread> threads;
+
+    for(int i = 0; i < 4; ++i)
+        threads.emplace_back([&callbacks]{ callbacks.invokeCallbacks(0); });
+
+    for(auto& thread : threads)
+        thread.join();
+
+    // A thread recording more events than its buffer holds
+
+    std::thread([&callbacks]
+    {
+        for(std::size_t i = 0; i < CallbacksLIB::CallbackTraceBuffer::s_capacity; ++i)
+            callbacks.invokeCallbacks(0);
+    }).join();
+
+    CallbacksTracer::disable();
+
+    bool isCorrect = CallbacksTracer::get_number_of_thread_buffers() == numberOfBuffers + 5;
+
+    std::size_t numberOfDroppedEvents = CallbacksLIB::CallbackTraceBuffer::s_capacity;
+    std::string dropCount = "\"dropped_events\":" + std::to_string(numberOfDroppedEvents) + "}";
+
+    std::size_t numberOfEvents = 0;
+    std::string trace = writeTrace(numberOfEvents);
+
+    isCorrect = isCorrect &&
+                numberOfEvents == 4 * 2 + CallbacksLIB::CallbackTraceBuffer::s_capacity &&
+                count(trace, "\"tid\":5,") == 2 &&
+                trace.find(dropCount) != std::string::npos &&
+                CallbacksTracer::get_number_of_thread_buffers() == numberOfBuffers &&
+                writeTrace(numberOfEvents).find(dropCount) != std::string::npos;
+
+    report.check("CallbacksTracer frees the buffers of the threads that exited", isCorrect);
+
+    CallbacksTracer::enable();
+
+    std::thread([&callbacks]{ callbacks.invokeCallbacks(0); }).join();
+
+    CallbacksTracer::disable();
+
+    trace = writeTrace(numberOfEvents);
+
+    isCorrect = numberOfEvents == 2 &&
+                count(trace, "\"tid\":7,") == 2;
+
+    report.check("CallbacksTracer doesn't reuse the thread IDs of the threads that exited", isCorrect);
+}
+
+
+
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// main function
+//-------------------------------------------------------------------
+int main()
+{
+    TestReport report;
+
+    CallbacksTracer::prepare_this_thread();
+
+    checkRecordedSpans(report);
+    checkEscapedNames(report);
+    checkExitedThreads(report);
+
+    return report.exit_code();
+}
+//-------------------------------------------------------------------
@@ -0,0 +1,225 @@
+///*****************************************************************************
+///*****************************************************************************
+///
+///
+///
+/// Test checking the slow-callback watchdog defined in callbacks_watchdog.hpp
+///
+/// -- The slow callbacks sleep for a few times the budget of a callback,
+///    while the other callbacks return right away, so the checks don't
+///    depend on the speed of the machine
+///
+///
+///
+///*****************************************************************************
+///*****************************************************************************
+
+
+
+//-------------------------------------------------------------------
+// Includes needed for this file
+//-------------------------------------------------------------------
+#include "callbacks.hpp"
+#include "callbacks_watchdog.hpp"
+#include "test_report.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// Helpers used by the test
+//-------------------------------------------------------------------
+namespace
+{
+
+
+
+using TestsLIB::TestReport;
+using CallbacksLIB::SlowCallbackReport;
+
+using WatchedCallbacks = CallbacksLIB::BasicCallbacks<CallbacksLIB::WatchdogCallbacksPolicy,void,int>;
+
+
+
+// The budget of each callback, and how long
+// the slow callbacks take
+
+const std::chrono::milliseconds g_callbackBudget(1);
+const std::chrono::milliseconds g_slowCallbackDuration(3);
+
+
+
+// Function used to make a callback system report
+// the callbacks that exceed their budget twice in
+// a row
+
+void configure(WatchedCallbacks& callbacks, std::vector<SlowCallbackReport>& reports)
+{
+    callbacks.instrumentation().set_callback_budget(g_callbackBudget);
+    callbacks.instrumentation().set_report_threshold(2);
+    callbacks.instrumentation().set_report_function([&reports](const SlowCallbackReport& report)
+    {
+        reports.push_back(report);
+    });
+}
+
+
+
+// A callback is reported once it exceeds its budget as
+// many times in a row as the threshold, and again after
+// every new streak
+
+void checkSlowCallbacks(TestReport& report)
+{
+    WatchedCallbacks callbacks;
+    std::vector<SlowCallbackReport> reports;
+
+    configure(callbacks, reports);
+
+    bool isSlow = true;
+
+    auto slowCallbackID = callbacks.register_callback([&isSlow](int)
+    {
+        if(isSlow)
+            std::this_thread::sleep_for(g_slowCallbackDuration);
+    });
+
+    auto fastCallbackID = callbacks.register_callback([](int){});
+
+    callbacks.invokeCallbacks(0);
+
+    bool isCorrect = reports.empty() && callbacks.instrumentation().get_slow_callbacks().empty();
+
+    callbacks.invokeCallbacks(0);
+    callbacks.invokeCallbacks(0);
+
+    isCorrect = isCorrect &&
+                reports.size() == 1 &&
+                reports[0].m_callbackID == slowCallbackID &&
+                reports[0].m_numberOfConsecutiveViolations == 2 &&
+                reports[0].m_longestDuration >= g_slowCallbackDuration &&
+                callbacks.instrumentation().get_slow_callbacks().size() == 1 &&
+                callbacks.instrumentation().get_report(slowCallbackID).m_numberOfViolations == 3 &&
+                callbacks.instrumentation().get_report(fastCallbackID).m_numberOfCalls == 3 &&
+                callbacks.instrumentation().get_report(fastCallbackID).m_numberOfViolations == 0;
+
+    report.check("WatchdogInstrumentation reports a callback exceeding its budget in a row", isCorrect);
+
+    isSlow = false;
+
+    callbacks.invokeCallbacks(0);
+
+    isCorrect = callbacks.instrumentation().get_slow_callbacks().empty() &&
+                callbacks.instrumentation().get_report(slowCallbackID).m_numberOfConsecutiveViolations == 0;
+
+    isSlow = true;
+
+    callbacks.invokeCallbacks(0);
+    callbacks.invokeCallbacks(0);
+
+    isCorrect = isCorrect &&
+                reports.size() == 2 &&
+                callbacks.instrumentation().get_report(slowCallbackID).m_numberOfCalls == 6 &&
+                callbacks.instrumentation().get_report(slowCallbackID).m_numberOfViolations == 5;
+
+    report.check("WatchdogInstrumentation reports a callback again after a new streak", isCorrect);
+}
+
+
+
+// What the watchdog knows about a callback is dropped
+// with the callback
+
+void checkRemovedCallbacks(TestReport& report)
+{
+    WatchedCallbacks callbacks;
+    std::vector<SlowCallbackReport> reports;
+
+    configure(callbacks, reports);
+
+    auto callbackID = callbacks.register_callback([](int)
+    {
+        std::this_thread::sleep_for(g_slowCallbackDuration);
+    });
+
+    callbacks.invokeCallbacks(0);
+    callbacks.invokeCallbacks(0);
+
+    bool isCorrect = callbacks.instrumentation().get_slow_callbacks().size() == 1;
+
+    callbacks.deregister_callback(callbackID);
+
+    isCorrect = isCorrect &&
+                callbacks.instrumentation().get_slow_callbacks().empty() &&
+                callbacks.instrumentation().get_report(callbackID).m_numberOfCalls == 0;
+
+    report.check("WatchdogInstrumentation drops what it knows about a removed callback", isCorrect);
+}
+
+
+
+// The report function is called once the callback has
+// returned, so it can throw like the callback would
+
+void checkThrowingReportFunction(TestReport& report)
+{
+    WatchedCallbacks callbacks;
+
+    callbacks.instrumentation().set_callback_budget(g_callbackBudget);
+    callbacks.instrumentation().set_report_threshold(1);
+    callbacks.instrumentation().set_report_function([](const SlowCallbackReport&)
+    {
+        throw std::runtime_error("slow callback");
+    });
+
+    int numberOfCalls = 0;
+
+    callbacks.register_callback([&numberOfCalls](int)
+    {
+        ++numberOfCalls;
+        std::this_thread::sleep_for(g_slowCallbackDuration);
+    });
+
+    bool isCorrect = false;
+
+    try
+    {
+        callbacks.invokeCallbacks(0);
+    }
+    catch(const std::runtime_error&)
+    {
+        isCorrect = true;
+    }
+
+    isCorrect = isCorrect && numberOfCalls == 1;
+
+    report.check("WatchdogInstrumentation reports a slow callback once it has returned", isCorrect);
+}
+
+
+
+}
+//-------------------------------------------------------------------
+
+
+
+//-------------------------------------------------------------------
+// main function
+//-------------------------------------------------------------------
+int main()
+{
+    TestReport report;
+
+    checkSlowCallbacks(report);
+    checkRemovedCallbacks(report);
+    checkThrowingReportFunction(report);
+
+    return report.exit_code();
+}
+//-------------------------------------------------------------------